@@ -116,6 +116,8 @@
 
 //Ignored because it is unimplemented
 %ignore gnc_numeric_convert_with_error;
+//Ignored because it takes a C array
+%ignore gnc_numeric_sum;
 %include <gnc-numeric.h>
 
 %include <gnc-commodity.h>
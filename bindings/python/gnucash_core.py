@@ -542,6 +542,8 @@ Book.add_method('gnc_book_set_root_account', 'set_root_account')
 Book.add_method('gnc_commodity_table_get_table', 'get_table')
 Book.add_method('gnc_pricedb_get_db', 'get_price_db')
 Book.add_method('qof_book_increment_and_format_counter', 'increment_and_format_counter')
+Book.add_method('gnc_book_begin_bulk_edit', 'begin_bulk_edit')
+Book.add_method('gnc_book_commit_bulk_edit', 'commit_bulk_edit')
 
 #Functions that return Account
 Book.get_root_account = method_function_returns_instance(
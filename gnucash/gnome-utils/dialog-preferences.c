@@ -1241,6 +1241,8 @@ gnc_preferences_dialog_create(GtkWindow *parent)
 
     gnc_builder_add_from_file (builder, "dialog-preferences.glade", "auto_decimal_places_adj");
     gnc_builder_add_from_file (builder, "dialog-preferences.glade", "autosave_interval_minutes_adj");
+    gnc_builder_add_from_file (builder, "dialog-preferences.glade", "autosave_compression_level_adj");
+    gnc_builder_add_from_file (builder, "dialog-preferences.glade", "file_compression_level_adj");
     gnc_builder_add_from_file (builder, "dialog-preferences.glade", "save_on_close_adj");
     gnc_builder_add_from_file (builder, "dialog-preferences.glade", "date_backmonth_adj");
     gnc_builder_add_from_file (builder, "dialog-preferences.glade", "default_zoom_adj");
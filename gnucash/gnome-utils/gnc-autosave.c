@@ -211,7 +211,9 @@ static gboolean autosave_timeout_cb(gpointer user_data)
         else
             g_debug("autosave_timeout_cb: toplevel is not a GNC_WINDOW\n");
 
-        gnc_file_save (GTK_WINDOW (toplevel));
+        /* An auto-save interrupts the user, so the backend compresses it
+           at the (faster) auto-save level. */
+        gnc_file_autosave (GTK_WINDOW (toplevel));
 
         gnc_main_window_set_progressbar_window(NULL);
 
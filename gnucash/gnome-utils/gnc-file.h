@@ -48,6 +48,10 @@
  *    gnc_file_save_as() routine).  The existing session will remain
  *    open for further editing.
  *
+ * The gnc_file_autosave() routine saves as gnc_file_save() does, for
+ *    the auto-save timer.  The backend may favour speed, e.g. by
+ *    compressing the file at the auto-save compression level.
+ *
  * The gnc_file_save_as() routine will prompt the user for a filename
  *    to save the account data to (using the standard GUI file dialogue
  *    box).  If the user specifies a filename, the account data will be
@@ -130,6 +134,7 @@ void gnc_file_new (GtkWindow *parent);
 gboolean gnc_file_open (GtkWindow *parent);
 void gnc_file_export(GtkWindow *parent);
 void gnc_file_save (GtkWindow *parent);
+void gnc_file_autosave (GtkWindow *parent);
 void gnc_file_save_as (GtkWindow *parent);
 void gnc_file_do_export(GtkWindow *parent, const char* filename);
 void gnc_file_do_save_as(GtkWindow *parent, const char* filename);
@@ -253,29 +253,33 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
 }
 
 static void
-gnc_cm_event_handler (QofInstance *entity,
-                      QofEventId event_type,
-                      gpointer user_data,
-                      gpointer event_data)
+gnc_cm_event_handler (const QofEventBatchEntry *entries,
+                      guint n_entries,
+                      gpointer user_data)
 {
-    const GncGUID *guid = qof_entity_get_guid(entity);
+    guint i;
+
+    for (i = 0; i < n_entries; i++)
+    {
+        const QofEventBatchEntry *entry = &entries[i];
 #if CM_DEBUG
-    gchar guidstr[GUID_ENCODING_LENGTH+1];
-    guid_to_string_buff (guid, guidstr);
-    fprintf (stderr, "event_handler: event %d, entity %p, guid %s\n", event_type,
-             entity, guidstr);
+        gchar guidstr[GUID_ENCODING_LENGTH+1];
+        guid_to_string_buff (&entry->guid, guidstr);
+        fprintf (stderr, "event_handler: events %d, entity %p, guid %s\n",
+                 entry->event_mask, entry->entity, guidstr);
 #endif
-    add_event (&changes, guid, event_type, TRUE);
+        add_event (&changes, &entry->guid, entry->event_mask, TRUE);
 
-    if (QOF_CHECK_TYPE(entity, GNC_ID_SPLIT))
-    {
-        /* split events are never generated by the engine, but might
-         * be generated by a backend (viz. the postgres backend.)
-         * Handle them like a transaction modify event. */
-        add_event_type (&changes, GNC_ID_TRANS, QOF_EVENT_MODIFY, TRUE);
+        if (!g_strcmp0 (entry->e_type, GNC_ID_SPLIT))
+        {
+            /* split events are never generated by the engine, but might
+             * be generated by a backend (viz. the postgres backend.)
+             * Handle them like a transaction modify event. */
+            add_event_type (&changes, GNC_ID_TRANS, QOF_EVENT_MODIFY, TRUE);
+        }
+        else
+            add_event_type (&changes, entry->e_type, entry->event_mask, TRUE);
     }
-    else
-        add_event_type (&changes, entity->e_type, event_type, TRUE);
 
     got_events = TRUE;
 
@@ -300,7 +304,7 @@ gnc_component_manager_init (void)
     changes_backup.event_masks = g_hash_table_new (g_str_hash, g_str_equal);
     changes_backup.entity_events = guid_hash_table_new ();
 
-    handler_id = qof_event_register_handler (gnc_cm_event_handler, NULL);
+    handler_id = qof_event_register_batch_handler (gnc_cm_event_handler, NULL);
 }
 
 void
@@ -574,6 +578,8 @@ void
 gnc_suspend_gui_refresh (void)
 {
     suspend_counter++;
+    /* Nothing is refreshed until we resume, so take the events in one go */
+    qof_event_begin_batch ();
 
     if (suspend_counter == 0)
     {
@@ -590,6 +596,7 @@ gnc_resume_gui_refresh (void)
         return;
     }
 
+    qof_event_end_batch ();
     suspend_counter--;
 
     if (suspend_counter == 0)
@@ -27,11 +27,16 @@
 #include "gnc-prefs-utils.h"
 #include "gnc-prefs.h"
 #include "xml/gnc-backend-xml.h"
+#include "TransLog.h"
 
 static QofLogModule log_module = G_LOG_DOMAIN;
 
 /* Keys used for core preferences */
 #define GNC_PREF_FILE_COMPRESSION    "file-compression"
+#define GNC_PREF_FILE_COMPRESSION_LEVEL "file-compression-level"
+#define GNC_PREF_FILE_JOURNAL        "file-journal"
+#define GNC_PREF_TRANSLOG_ASYNC      "translog-async"
+#define GNC_PREF_AUTOSAVE_COMPRESSION_LEVEL "autosave-compression-level"
 #define GNC_PREF_RETAIN_TYPE_NEVER   "retain-type-never"
 #define GNC_PREF_RETAIN_TYPE_DAYS    "retain-type-days"
 #define GNC_PREF_RETAIN_TYPE_FOREVER "retain-type-forever"
@@ -78,6 +83,46 @@ file_compression_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
     }
 }
 
+static void
+file_compression_level_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint level = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL);
+        gnc_prefs_set_file_compression_level (level);
+    }
+}
+
+static void
+autosave_compression_level_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint level = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_AUTOSAVE_COMPRESSION_LEVEL);
+        gnc_prefs_set_autosave_compression_level (level);
+    }
+}
+
+static void
+file_journal_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean journal = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_JOURNAL);
+        gnc_prefs_set_file_save_journal (journal);
+    }
+}
+
+static void
+translog_async_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean async = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_ASYNC);
+        xaccLogSetDurability (async ? XACC_LOG_ASYNC : XACC_LOG_SYNC);
+    }
+}
+
 
 void gnc_prefs_init (void)
 {
@@ -89,6 +134,10 @@ void gnc_prefs_init (void)
     file_retain_changed_cb (NULL, NULL, NULL);
     file_retain_type_changed_cb (NULL, NULL, NULL);
     file_compression_changed_cb (NULL, NULL, NULL);
+    file_compression_level_changed_cb (NULL, NULL, NULL);
+    autosave_compression_level_changed_cb (NULL, NULL, NULL);
+    file_journal_changed_cb (NULL, NULL, NULL);
+    translog_async_changed_cb (NULL, NULL, NULL);
 
     /* Check for invalid retain_type (days)/retain_days (0) combo.
      * This can happen either because a user changed the preferences
@@ -122,5 +171,13 @@ void gnc_prefs_init (void)
                            file_retain_type_changed_cb, NULL);
     gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION,
                            file_compression_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL,
+                           file_compression_level_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_AUTOSAVE_COMPRESSION_LEVEL,
+                           autosave_compression_level_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_JOURNAL,
+                           file_journal_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_ASYNC,
+                           translog_async_changed_cb, NULL);
 
 }
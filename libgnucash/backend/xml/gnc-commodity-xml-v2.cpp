@@ -40,8 +40,11 @@ extern "C"
 #include "sixtp-dom-generators.h"
 
 #include "gnc-xml.h"
+#include "gnc-xml-writer.hpp"
 #include "io-gncxml-gen.h"
 
+#include <kvp-frame.hpp>
+
 static QofLogModule log_module = GNC_MOD_IO;
 
 const gchar* commodity_version_string = "2.0.0";
@@ -118,6 +121,49 @@ gnc_commodity_dom_tree_create (const gnc_commodity* com)
     return ret;
 }
 
+gboolean
+gnc_commodity_write_xml (GncXmlWriter& writer, const gnc_commodity* com)
+{
+    gboolean currency = gnc_commodity_is_iso (com);
+    auto slots = qof_instance_get_slots (QOF_INSTANCE (com));
+    gboolean has_slots = slots && !slots->empty ();
+
+    if (currency && !gnc_commodity_get_quote_flag (com) && !has_slots)
+        return FALSE;
+
+    writer.start (gnc_commodity_string);
+    writer.attribute ("version", commodity_version_string);
+
+    writer.text_element (cmdty_namespace, gnc_commodity_get_namespace (com));
+    writer.text_element (cmdty_id, gnc_commodity_get_mnemonic (com));
+
+    if (!currency)
+    {
+        writer.text_element (cmdty_name, gnc_commodity_get_fullname (com));
+
+        auto cusip = gnc_commodity_get_cusip (com);
+        if (cusip && *cusip)
+            writer.text_element (cmdty_xcode, cusip);
+
+        writer.int_element (cmdty_fraction, gnc_commodity_get_fraction (com));
+    }
+
+    if (gnc_commodity_get_quote_flag (com))
+    {
+        writer.start (cmdty_get_quotes);
+        writer.end ();
+        if (auto source = gnc_commodity_get_quote_source (com))
+            writer.text_element (cmdty_quote_source,
+                                 gnc_quote_source_get_internal_name (source));
+        writer.text_element (cmdty_quote_tz, gnc_commodity_get_quote_tz (com));
+    }
+
+    writer.instance_slots (cmdty_slots, QOF_INSTANCE (com));
+
+    writer.end ();
+    return TRUE;
+}
+
 /***********************************************************************/
 
 struct com_char_handler
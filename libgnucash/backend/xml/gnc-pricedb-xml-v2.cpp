@@ -30,6 +30,7 @@ extern "C"
 }
 
 #include "gnc-xml.h"
+#include "gnc-xml-writer.hpp"
 #include "sixtp.h"
 #include "sixtp-utils.h"
 #include "sixtp-parsers.h"
@@ -513,3 +514,61 @@ gnc_pricedb_dom_tree_create (GNCPriceDB* db)
 {
     return gnc_pricedb_to_dom_tree (BAD_CAST "gnc:pricedb", db);
 }
+
+/* Whether gnc_price_to_dom_tree would make a node for the price. */
+static gboolean
+price_is_writable (GNCPrice* price, gpointer data)
+{
+    gnc_commodity* commodity;
+    gnc_commodity* currency;
+
+    if (!price)
+        return TRUE;
+
+    commodity = gnc_price_get_commodity (price);
+    currency = gnc_price_get_currency (price);
+    if (! (commodity && currency))
+        return FALSE;
+    if (!gnc_commodity_get_namespace (commodity) ||
+        !gnc_commodity_get_mnemonic (commodity) ||
+        !gnc_commodity_get_namespace (currency) ||
+        !gnc_commodity_get_mnemonic (currency))
+        return FALSE;
+    if (gnc_price_get_time64 (price) == INT64_MAX)
+        return FALSE;
+
+    *static_cast<gboolean*> (data) = TRUE;
+    return TRUE;
+}
+
+gboolean
+gnc_pricedb_is_writable (GNCPriceDB* db)
+{
+    gboolean any = FALSE;
+
+    return gnc_pricedb_foreach_price (db, price_is_writable, &any, FALSE) &&
+           any;
+}
+
+void
+gnc_price_write_xml (GncXmlWriter& writer, GNCPrice* price)
+{
+    writer.start ("price");
+
+    writer.guid_element ("price:id", gnc_price_get_guid (price));
+    writer.commodity_ref ("price:commodity", gnc_price_get_commodity (price));
+    writer.commodity_ref ("price:currency", gnc_price_get_currency (price));
+    writer.time64_element ("price:time", gnc_price_get_time64 (price));
+
+    auto sourcestr = gnc_price_get_source_string (price);
+    if (sourcestr && *sourcestr)
+        writer.text_element ("price:source", sourcestr);
+
+    auto typestr = gnc_price_get_typestr (price);
+    if (typestr && *typestr)
+        writer.text_element ("price:type", typestr);
+
+    writer.numeric_element ("price:value", gnc_price_get_value (price));
+
+    writer.end ();
+}
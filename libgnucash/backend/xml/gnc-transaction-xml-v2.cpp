@@ -43,11 +43,18 @@ extern "C"
 #include "sixtp-dom-generators.h"
 
 #include "gnc-xml.h"
+#include "gnc-xml-reader.hpp"
+#include "gnc-xml-writer.hpp"
 
 #include "io-gncxml-gen.h"
 
 #include "sixtp-dom-parsers.h"
 
+#include <kvp-frame.hpp>
+
+#include <string>
+#include <vector>
+
 const gchar* transaction_version_string = "2.0.0";
 
 static void
@@ -192,6 +199,69 @@ gnc_transaction_dom_tree_create (Transaction* trn)
     return ret;
 }
 
+static void
+split_write_xml (GncXmlWriter& writer, const gchar* tag, Split* spl)
+{
+    writer.start (tag);
+
+    writer.guid_element ("split:id", xaccSplitGetGUID (spl));
+
+    auto memo = xaccSplitGetMemo (spl);
+    if (memo && *memo)
+        writer.text_child ("split:memo", memo);
+
+    auto action = xaccSplitGetAction (spl);
+    if (action && *action)
+        writer.text_child ("split:action", action);
+
+    char tmp[2] = {xaccSplitGetReconcile (spl), '\0'};
+    writer.start ("split:reconciled-state");
+    writer.text (tmp, false);
+    writer.end ();
+
+    if (auto time = xaccSplitGetDateReconciled (spl))
+        writer.time64_element ("split:reconcile-date", time);
+
+    writer.numeric_element ("split:value", xaccSplitGetValue (spl));
+    writer.numeric_element ("split:quantity", xaccSplitGetAmount (spl));
+    writer.guid_element ("split:account",
+                         xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+    if (auto lot = xaccSplitGetLot (spl))
+        writer.guid_element ("split:lot", gnc_lot_get_guid (lot));
+    writer.instance_slots ("split:slots", QOF_INSTANCE (spl));
+
+    writer.end ();
+}
+
+void
+gnc_transaction_write_xml (GncXmlWriter& writer, Transaction* trn)
+{
+    writer.start ("gnc:transaction");
+    writer.attribute ("version", transaction_version_string);
+
+    writer.guid_element ("trn:id", xaccTransGetGUID (trn));
+    writer.commodity_ref ("trn:currency", xaccTransGetCurrency (trn));
+
+    auto num = xaccTransGetNum (trn);
+    if (num && *num)
+        writer.text_child ("trn:num", num);
+
+    writer.time64_element ("trn:date-posted", xaccTransRetDatePosted (trn));
+    writer.time64_element ("trn:date-entered", xaccTransRetDateEntered (trn));
+
+    if (auto description = xaccTransGetDescription (trn))
+        writer.text_child ("trn:description", description);
+
+    writer.instance_slots ("trn:slots", QOF_INSTANCE (trn));
+
+    writer.start ("trn:splits");
+    for (auto n = xaccTransGetSplitList (trn); n; n = n->next)
+        split_write_xml (writer, "trn:split", static_cast<Split*> (n->data));
+    writer.end ();
+
+    writer.end ();
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -641,6 +711,339 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
     return trn;
 }
 
+/***********************************************************************/
+/* Reading a transaction without a DOM tree.  Only the elements that
+ * gnc_transaction_dom_tree_create makes, in the order it makes them, are
+ * read: in any other order the handlers above could set things up
+ * differently (the amount is rounded to the account's SCU once the split
+ * has one, for instance), so the element is left to them. */
+
+struct GncXmlSplit
+{
+    GncGUID id;
+    bool has_memo = false;
+    std::string memo;
+    bool has_action = false;
+    std::string action;
+    char reconciled = '\0';
+    bool has_reconcile_date = false;
+    time64 reconcile_date = 0;
+    gnc_numeric value;
+    gnc_numeric quantity;
+    GncGUID account;
+    bool has_lot = false;
+    GncGUID lot;
+    GncXmlSlots slots;
+};
+
+struct GncXmlTransaction
+{
+    GncGUID id;
+    bool has_currency = false;
+    std::string currency_space;
+    std::string currency_id;
+    bool has_num = false;
+    std::string num;
+    time64 date_posted = 0;
+    time64 date_entered = 0;
+    bool has_description = false;
+    std::string description;
+    GncXmlSlots slots;
+    std::vector<GncXmlSplit> splits;
+};
+
+/* These are in the order of spl_dom_handlers and trn_dom_handlers. */
+enum
+{
+    SPL_ID, SPL_MEMO, SPL_ACTION, SPL_RECONCILED_STATE, SPL_RECONCILE_DATE,
+    SPL_VALUE, SPL_QUANTITY, SPL_ACCOUNT, SPL_LOT, SPL_SLOTS
+};
+
+enum
+{
+    TRN_ID, TRN_CURRENCY, TRN_NUM, TRN_DATE_POSTED, TRN_DATE_ENTERED,
+    TRN_DESCRIPTION, TRN_SLOTS, TRN_SPLITS
+};
+
+static const unsigned spl_required = 1 << SPL_ID | 1 << SPL_RECONCILED_STATE |
+                                     1 << SPL_VALUE | 1 << SPL_QUANTITY |
+                                     1 << SPL_ACCOUNT;
+static const unsigned trn_required = 1 << TRN_ID | 1 << TRN_DATE_POSTED |
+                                     1 << TRN_DATE_ENTERED | 1 << TRN_SPLITS;
+
+/* The index of the element just started in handlers, or -1. */
+static int
+handler_index (const GncXmlReader& reader, const dom_tree_handler* handlers)
+{
+    for (int i = 0; handlers[i].tag; ++i)
+        if (reader.is (handlers[i].tag))
+            return i;
+    return -1;
+}
+
+static bool
+read_split (GncXmlReader& reader, GncXmlSplit& split)
+{
+    using Token = GncXmlReader::Token;
+    unsigned seen = 0;
+    int last = -1;
+    std::string text;
+
+    while (true)
+    {
+        auto token = reader.next ();
+        if (token == Token::END)
+            return (seen & spl_required) == spl_required;
+        if (token == Token::TEXT)
+            continue;
+        if (token != Token::START)
+            return false;
+
+        auto tag = handler_index (reader, spl_dom_handlers);
+        if (tag <= last)
+            return false;
+        last = tag;
+        seen |= 1 << tag;
+
+        bool ok;
+        switch (tag)
+        {
+        case SPL_ID:
+            ok = reader.read_guid (split.id);
+            break;
+        case SPL_MEMO:
+            ok = split.has_memo = reader.read_text (split.memo);
+            break;
+        case SPL_ACTION:
+            ok = split.has_action = reader.read_text (split.action);
+            break;
+        case SPL_RECONCILED_STATE:
+            ok = reader.read_text (text);
+            split.reconciled = text.c_str ()[0];
+            break;
+        case SPL_RECONCILE_DATE:
+            ok = split.has_reconcile_date =
+                reader.read_time64 (split.reconcile_date);
+            break;
+        case SPL_VALUE:
+            ok = reader.read_numeric (split.value);
+            break;
+        case SPL_QUANTITY:
+            ok = reader.read_numeric (split.quantity);
+            break;
+        case SPL_ACCOUNT:
+            ok = reader.read_guid (split.account);
+            break;
+        case SPL_LOT:
+            ok = split.has_lot = reader.read_guid (split.lot);
+            break;
+        case SPL_SLOTS:
+            ok = reader.read_slots (split.slots);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+            return false;
+    }
+}
+
+static bool
+read_splits (GncXmlReader& reader, std::vector<GncXmlSplit>& splits)
+{
+    using Token = GncXmlReader::Token;
+
+    while (true)
+    {
+        switch (reader.next ())
+        {
+        case Token::TEXT:
+            break;
+        case Token::START:
+            if (!reader.is ("trn:split"))
+                return false;
+            splits.emplace_back ();
+            if (!read_split (reader, splits.back ()))
+                return false;
+            break;
+        case Token::END:
+            return !splits.empty ();
+        default:
+            return false;
+        }
+    }
+}
+
+static bool
+read_transaction (GncXmlReader& reader, GncXmlTransaction& trn)
+{
+    using Token = GncXmlReader::Token;
+    unsigned seen = 0;
+    int last = -1;
+
+    if (reader.next () != Token::START || !reader.is ("gnc:transaction"))
+        return false;
+
+    while (true)
+    {
+        auto token = reader.next ();
+        if (token == Token::END)
+            return (seen & trn_required) == trn_required &&
+                   reader.next () == Token::END_OF_INPUT;
+        if (token == Token::TEXT)
+            continue;
+        if (token != Token::START)
+            return false;
+
+        auto tag = handler_index (reader, trn_dom_handlers);
+        if (tag <= last)
+            return false;
+        last = tag;
+        seen |= 1 << tag;
+
+        bool ok;
+        switch (tag)
+        {
+        case TRN_ID:
+            ok = reader.read_guid (trn.id);
+            break;
+        case TRN_CURRENCY:
+            ok = trn.has_currency =
+                reader.read_commodity_ref (trn.currency_space,
+                                           trn.currency_id);
+            break;
+        case TRN_NUM:
+            ok = trn.has_num = reader.read_text (trn.num);
+            break;
+        case TRN_DATE_POSTED:
+            ok = reader.read_time64 (trn.date_posted);
+            break;
+        case TRN_DATE_ENTERED:
+            ok = reader.read_time64 (trn.date_entered);
+            break;
+        case TRN_DESCRIPTION:
+            ok = trn.has_description = reader.read_text (trn.description);
+            break;
+        case TRN_SLOTS:
+            ok = reader.read_slots (trn.slots);
+            break;
+        case TRN_SPLITS:
+            ok = read_splits (reader, trn.splits);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+            return false;
+    }
+}
+
+GncXmlTransaction*
+gnc_transaction_parse_xml (const char* data, size_t len)
+{
+    GncXmlReader reader (data, data + len);
+    auto trn = new GncXmlTransaction;
+
+    if (read_transaction (reader, *trn))
+        return trn;
+
+    delete trn;
+    return NULL;
+}
+
+void
+gnc_transaction_xml_data_free (GncXmlTransaction* data)
+{
+    delete data;
+}
+
+/* As dom_tree_create_instance_slots */
+static void
+set_instance_slots (QofInstance* inst, GncXmlSlots& slots)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+
+    for (auto& slot : slots)
+        delete frame->set ({slot.first}, slot.second.release ());
+}
+
+Transaction*
+gnc_transaction_from_xml_data (GncXmlTransaction* data, QofBook* book)
+{
+    gnc_commodity* currency = NULL;
+    std::vector<std::pair<Account*, GNCLot*>> refs;
+
+    g_return_val_if_fail (data, NULL);
+    g_return_val_if_fail (book, NULL);
+
+    /* Look everything up first, so that a missing reference leaves the
+     * book as it was for dom_tree_to_transaction to complain about. */
+    if (data->has_currency)
+    {
+        auto table = gnc_commodity_table_get_table (book);
+        currency = gnc_commodity_table_lookup (table,
+                                               data->currency_space.c_str (),
+                                               data->currency_id.c_str ());
+        if (!currency)
+            return NULL;
+    }
+    for (auto& split : data->splits)
+    {
+        Account* account = xaccAccountLookup (&split.account, book);
+        GNCLot* lot = NULL;
+
+        if (!account)
+            return NULL;
+        if (split.has_lot && !(lot = gnc_lot_lookup (&split.lot, book)))
+            return NULL;
+        refs.emplace_back (account, lot);
+    }
+
+    Transaction* trn = xaccMallocTransaction (book);
+    g_return_val_if_fail (trn, NULL);
+    xaccTransBeginEdit (trn);
+
+    xaccTransSetGUID (trn, &data->id);
+    if (currency)
+        xaccTransSetCurrency (trn, currency);
+    if (data->has_num)
+        xaccTransSetNum (trn, data->num.c_str ());
+    xaccTransSetDatePostedSecs (trn, data->date_posted);
+    xaccTransSetDateEnteredSecs (trn, data->date_entered);
+    if (data->has_description)
+        xaccTransSetDescription (trn, data->description.c_str ());
+    set_instance_slots (QOF_INSTANCE (trn), data->slots);
+
+    auto ref = refs.begin ();
+    for (auto& split : data->splits)
+    {
+        Split* spl = xaccMallocSplit (book);
+
+        xaccSplitSetGUID (spl, &split.id);
+        if (split.has_memo)
+            xaccSplitSetMemo (spl, split.memo.c_str ());
+        if (split.has_action)
+            xaccSplitSetAction (spl, split.action.c_str ());
+        xaccSplitSetReconcile (spl, split.reconciled);
+        if (split.has_reconcile_date)
+            xaccSplitSetDateReconciledSecs (spl, split.reconcile_date);
+        xaccSplitSetValue (spl, split.value);
+        xaccSplitSetAmount (spl, split.quantity);
+        xaccAccountInsertSplit (ref->first, spl);
+        if (ref->second)
+            gnc_lot_add_split (ref->second, spl);
+        set_instance_slots (QOF_INSTANCE (spl), split.slots);
+        ++ref;
+
+        xaccTransAppendSplit (trn, spl);
+    }
+
+    xaccTransCommitEdit (trn);
+    return trn;
+}
+
 sixtp*
 gnc_transaction_sixtp_parser_create (void)
 {
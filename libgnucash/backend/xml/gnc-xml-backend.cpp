@@ -34,11 +34,13 @@ extern "C"
 #include <gnc-engine.h> //for GNC_MOD_BACKEND
 #include <gnc-uri-utils.h>
 #include <TransLog.h>
+#include <Transaction.h>
 #include <gnc-prefs.h>
 
 }
 
 #include <sstream>
+#include <vector>
 
 #include "gnc-xml-backend.hpp"
 #include "gnc-backend-xml.h"
@@ -47,8 +49,22 @@ extern "C"
 
 #define XML_URI_PREFIX "xml://"
 #define FILE_URI_PREFIX "file://"
+/* The whole book is written once the journal is bigger than the book file
+ * divided by this. */
+#define JOURNAL_COMPACT_RATIO 4
 static QofLogModule log_module = GNC_MOD_BACKEND;
 
+/* Identifies the book file as it is on disk, so that a journal is never
+ * replayed over or appended to for a file written since it was started. */
+static std::string
+file_stamp (const GStatBuf& statbuf)
+{
+    std::ostringstream stamp;
+    stamp << statbuf.st_size << "-" << statbuf.st_mtime << "-"
+          << statbuf.st_ino;
+    return stamp.str();
+}
+
 bool
 GncXmlBackend::check_path (const char* fullpath, bool create)
 {
@@ -202,6 +218,8 @@ GncXmlBackend::session_end()
     m_fullpath.clear();
     m_lockfile.clear();
     m_linkfile.clear();
+    m_journal.clear();
+    m_journal_stamp.clear();
 }
 
 static QofBookFileType
@@ -243,8 +261,13 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
 
     error = ERR_BACKEND_NO_ERR;
     m_book = book;
+    m_loading = true;
+    m_journal.clear();
+    m_journal_compact = false;
+    m_journal_stamp.clear();
 
     int rc;
+    GStatBuf statbuf;
     switch (determine_file_type (m_fullpath))
     {
     case GNC_BOOK_XML2_FILE:
@@ -255,6 +278,21 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
             PWARN ("Syntax error in Xml File %s", m_fullpath.c_str());
             error = ERR_FILEIO_PARSE_ERROR;
         }
+        else if (g_stat (m_fullpath.c_str(), &statbuf) == 0)
+        {
+            /* Only a book file in the format that is saved can have a
+             * journal appended to it. */
+            auto journal = journal_path();
+            m_journal_stamp = file_stamp (statbuf);
+            if (g_file_test (journal.c_str(), G_FILE_TEST_EXISTS) &&
+                !gnc_book_replay_xml_journal_v2 (book, journal.c_str(),
+                                                 m_journal_stamp.c_str()))
+            {
+                PWARN ("Unable to replay the journal %s", journal.c_str());
+                error = ERR_FILEIO_PARSE_ERROR;
+                m_journal_stamp.clear();
+            }
+        }
         break;
 
     case GNC_BOOK_XML2_FILE_NO_ENCODING:
@@ -296,6 +334,7 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
         break;
     }
 
+    m_loading = false;
     if (error != ERR_BACKEND_NO_ERR)
     {
         set_error(error);
@@ -324,10 +363,96 @@ GncXmlBackend::sync(QofBook* book)
         return;
     }
 
+    if (gnc_prefs_get_file_save_journal () && append_journal ())
+    {
+        qof_book_mark_session_saved (m_book);
+        return;
+    }
+
     write_to_file (true);
     remove_old_files();
 }
 
+void
+GncXmlBackend::commit (QofInstance* inst)
+{
+    if (m_loading)
+        return;
+
+    /* Beginning and committing an edit without changing anything, as
+     * committing a transaction does to its accounts, changes nothing. */
+    if (!qof_instance_get_dirty_flag (inst) &&
+        !qof_instance_get_destroying (inst))
+        return;
+
+    if (GNC_IS_TRANSACTION (inst))
+    {
+        m_journal.insert (*qof_instance_get_guid (inst));
+    }
+    else if (GNC_IS_SPLIT (inst))
+    {
+        auto trans = xaccSplitGetParent (GNC_SPLIT (inst));
+        if (trans)
+            m_journal.insert (*qof_instance_get_guid (trans));
+    }
+    else
+    {
+        m_journal_compact = true;
+    }
+}
+
+/* Save by appending the transactions changed since the last save to the
+ * journal, if that brings the book file up to date and the journal isn't
+ * due to be compacted into a new book file. */
+bool
+GncXmlBackend::append_journal ()
+{
+    if (m_journal_compact || m_journal_stamp.empty())
+        return false;
+
+    GStatBuf book_stat, journal_stat;
+    auto journal = journal_path();
+    if (g_stat (m_fullpath.c_str(), &book_stat) != 0 ||
+        file_stamp (book_stat) != m_journal_stamp)
+        return false;
+    if (g_stat (journal.c_str(), &journal_stat) == 0 &&
+        journal_stat.st_size > book_stat.st_size / JOURNAL_COMPACT_RATIO)
+        return false;
+
+    if (m_journal.empty())
+        return true;
+
+    std::vector<GncGUID> transactions (m_journal.begin(), m_journal.end());
+    if (!gnc_book_append_to_xml_journal_v2 (m_book, journal.c_str(),
+                                            m_journal_stamp.c_str(),
+                                            transactions))
+    {
+        PWARN ("Unable to append to the journal %s, writing the book file",
+               journal.c_str());
+        return false;
+    }
+    m_journal.clear();
+    return true;
+}
+
+/* The book file has just been written: nothing is left for the journal. */
+void
+GncXmlBackend::reset_journal ()
+{
+    GStatBuf statbuf;
+    auto journal = journal_path();
+
+    if (g_unlink (journal.c_str()) != 0 && errno != ENOENT)
+        PWARN ("unable to unlink the journal %s: %s", journal.c_str(),
+               g_strerror (errno) ? g_strerror (errno) : "");
+    m_journal.clear();
+    m_journal_compact = false;
+    if (g_stat (m_fullpath.c_str(), &statbuf) == 0)
+        m_journal_stamp = file_stamp (statbuf);
+    else
+        m_journal_stamp.clear();
+}
+
 bool
 GncXmlBackend::save_may_clobber_data()
 {
@@ -400,8 +525,15 @@ GncXmlBackend::write_to_file (bool make_backup)
         }
     }
 
+    /* Auto-saves interrupt the user, so they have their own, usually
+     * faster, level; the next manual save compresses as well as ever. */
+    auto level = gnc_prefs_get_file_compression_level ();
+    if (m_autosaving && gnc_prefs_get_autosave_compression_level () >= 0)
+        level = gnc_prefs_get_autosave_compression_level ();
+
     if (gnc_book_write_to_xml_file_v2 (m_book, tmp_name,
-                                       gnc_prefs_get_file_save_compressed ()))
+                                       gnc_prefs_get_file_save_compressed (),
+                                       level))
     {
         /* Record the file's permissions before g_unlinking it */
         GStatBuf statbuf;
@@ -478,6 +610,7 @@ GncXmlBackend::write_to_file (bool make_backup)
             return FALSE;
         }
         g_free (tmp_name);
+        reset_journal();
 
         /* Since we successfully saved the book,
          * we should mark it clean. */
@@ -23,6 +23,7 @@ extern "C"
 #include <qof.h>
 }
 
+#include <set>
 #include <string>
 #include <qof-backend.hpp>
 
@@ -39,7 +40,9 @@ public:
                        bool ignore_lock, bool create, bool force) override;
     void session_end() override;
     void load(QofBook* book, QofBackendLoadType loadType) override;
-    /* The XML backend isn't able to do anything with individual instances. */
+    /* The XML backend can't save individual instances, but it notes which
+     * have changed so that a save can append them to the journal. */
+    void commit(QofInstance* inst) override;
     void export_coa(QofBook*) override;
     void sync(QofBook* book) override;
     void safe_sync(QofBook* book) override { sync(book); } // XML sync is inherently safe.
@@ -47,11 +50,22 @@ public:
     QofBook* get_book() { return m_book; }
 
 private:
+    struct GuidLess
+    {
+        bool operator() (const GncGUID& a, const GncGUID& b) const
+        {
+            return guid_compare (&a, &b) < 0;
+        }
+    };
+
     bool save_may_clobber_data();
     bool get_file_lock();
     bool link_or_make_backup(const std::string& orig, const std::string& bkup);
     bool backup_file();
     bool write_to_file(bool make_backup);
+    bool append_journal();
+    void reset_journal();
+    std::string journal_path() const { return m_fullpath + ".journal"; }
     void remove_old_files();
     void write_accounts(QofBook* book);
     bool check_path(const char* fullpath, bool create);
@@ -62,5 +76,14 @@ private:
     int m_lockfd;
 
     QofBook* m_book = nullptr;  /* The primary, main open book */
+
+    bool m_loading = false;
+    /* The stamp of the book file as it was loaded or last written, which
+     * the journal must have been started for. */
+    std::string m_journal_stamp;
+    /* The transactions changed since the last save. */
+    std::set<GncGUID, GuidLess> m_journal;
+    /* Something the journal can't hold has changed since the last save. */
+    bool m_journal_compact = false;
 };
 #endif // __GNC_XML_BACKEND_HPP__
@@ -0,0 +1,1051 @@
+/********************************************************************
+ * gnc-xml-reader.cpp: Read XML without building a DOM tree.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gnc-date.h>
+}
+
+#include "gnc-xml-reader.hpp"
+#include "sixtp-utils.h"
+
+#include <kvp-frame.hpp>
+
+#include <algorithm>
+
+static inline bool
+is_space (char c)
+{
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+static inline bool
+is_name_start (char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '_' || c == ':';
+}
+
+static inline bool
+is_name_char (char c)
+{
+    return is_name_start (c) || (c >= '0' && c <= '9') ||
+           c == '-' || c == '.';
+}
+
+/* The length of the UTF-8 character at p that XML allows, or 0. */
+static size_t
+xml_char_length (const char* p, const char* end)
+{
+    auto s = reinterpret_cast<const unsigned char*> (p);
+    size_t len;
+    unsigned char min = 0x80, max = 0xbf;
+
+    if (s[0] < 0x80)
+        return (s[0] >= 0x20 || s[0] == '\t' || s[0] == '\n') ? 1 : 0;
+    if (s[0] >= 0xc2 && s[0] <= 0xdf)
+        len = 2;
+    else if (s[0] >= 0xe0 && s[0] <= 0xef)
+        len = 3;
+    else if (s[0] >= 0xf0 && s[0] <= 0xf4)
+        len = 4;
+    else
+        return 0;
+    if (end - p < static_cast<ptrdiff_t> (len))
+        return 0;
+
+    /* No overlong forms, surrogates or characters past U+10FFFF. */
+    if (s[0] == 0xe0)
+        min = 0xa0;
+    else if (s[0] == 0xed)
+        max = 0x9f;
+    else if (s[0] == 0xf0)
+        min = 0x90;
+    else if (s[0] == 0xf4)
+        max = 0x8f;
+    if (s[1] < min || s[1] > max)
+        return 0;
+    for (size_t i = 2; i < len; ++i)
+        if (s[i] < 0x80 || s[i] > 0xbf)
+            return 0;
+
+    /* U+FFFE and U+FFFF */
+    if (s[0] == 0xef && s[1] == 0xbf && s[2] >= 0xbe)
+        return 0;
+    return len;
+}
+
+static void
+append_utf8 (std::string& out, gunichar c)
+{
+    char buf[6];
+    out.append (buf, g_unichar_to_utf8 (c, buf));
+}
+
+GncXmlReader::GncXmlReader (const char* begin, const char* end) :
+    m_p {begin}, m_end {end}
+{
+}
+
+GncXmlReader::Token
+GncXmlReader::error ()
+{
+    m_failed = true;
+    return Token::ERROR;
+}
+
+void
+GncXmlReader::skip_space ()
+{
+    while (m_p < m_end && is_space (*m_p))
+        ++m_p;
+}
+
+bool
+GncXmlReader::read_name (const char*& name, size_t& len)
+{
+    name = m_p;
+    if (m_p == m_end || !is_name_start (*m_p))
+        return false;
+    while (++m_p < m_end && is_name_char (*m_p))
+        ;
+    len = m_p - name;
+    return true;
+}
+
+/* Replace the reference at m_p. */
+bool
+GncXmlReader::read_reference (std::string& out)
+{
+    static const struct
+    {
+        const char* name;
+        char c;
+    } entities[] =
+    {
+        { "lt;", '<' }, { "gt;", '>' }, { "amp;", '&' },
+        { "quot;", '"' }, { "apos;", '\'' },
+    };
+    auto p = m_p + 1;
+    auto semi = static_cast<const char*> (memchr (p, ';',
+                                                  MIN (m_end - p, 12)));
+
+    if (!semi)
+        return false;
+
+    if (*p != '#')
+    {
+        for (auto& entity : entities)
+        {
+            auto len = strlen (entity.name);
+            if (static_cast<size_t> (semi + 1 - p) == len &&
+                memcmp (p, entity.name, len) == 0)
+            {
+                out += entity.c;
+                m_p = semi + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    gunichar c = 0;
+    bool hex = (++p < semi && *p == 'x');
+    if (hex)
+        ++p;
+    if (p == semi)
+        return false;
+    for (; p < semi; ++p)
+    {
+        int digit = hex ? g_ascii_xdigit_value (*p) : g_ascii_digit_value (*p);
+        if (digit < 0)
+            return false;
+        c = c * (hex ? 16 : 10) + digit;
+        if (c > 0x10ffff)
+            return false;
+    }
+
+    if (!(c == '\t' || c == '\n' || c == '\r' ||
+          (c >= 0x20 && c <= 0xd7ff) ||
+          (c >= 0xe000 && c <= 0xfffd) ||
+          (c >= 0x10000 && c <= 0x10ffff)))
+        return false;
+    append_utf8 (out, c);
+    m_p = semi + 1;
+    return true;
+}
+
+/* Read text or an attribute value up to stop, checking each character
+ * and replacing references. */
+bool
+GncXmlReader::read_chars (std::string& out, char stop)
+{
+    auto run = m_p;
+
+    while (m_p < m_end && *m_p != stop)
+    {
+        auto c = *m_p;
+        if (c >= 0x20 && c != '&' && c != '<' && c != ']' && c != '\x7f' &&
+            !(c & 0x80))
+        {
+            ++m_p;
+            continue;
+        }
+
+        out.append (run, m_p - run);
+        if (c == '&')
+        {
+            if (!read_reference (out))
+                return false;
+        }
+        else if (c == '<')
+        {
+            return false;
+        }
+        else if (c == ']' && stop == '<' && m_end - m_p >= 3 &&
+                 memcmp (m_p, "]]>", 3) == 0)
+        {
+            return false;
+        }
+        else if ((c == '\t' || c == '\n') && stop != '<')
+        {
+            /* libxml2 turns these into spaces in attribute values. */
+            return false;
+        }
+        else
+        {
+            auto len = xml_char_length (m_p, m_end);
+            if (!len)
+                return false;
+            out.append (m_p, len);
+            m_p += len;
+        }
+        run = m_p;
+    }
+    out.append (run, m_p - run);
+    return m_p < m_end;
+}
+
+GncXmlReader::Token
+GncXmlReader::next ()
+{
+    if (m_failed)
+        return Token::ERROR;
+
+    if (m_empty_end)
+    {
+        m_empty_end = false;
+        m_open.pop_back ();
+        return Token::END;
+    }
+
+    if (m_started && m_open.empty ())
+        return m_p == m_end ? Token::END_OF_INPUT : error ();
+
+    if (m_p == m_end)
+        return error ();
+
+    if (*m_p != '<')
+    {
+        if (!m_started)
+            return error ();
+        m_text.clear ();
+        if (!read_chars (m_text, '<'))
+            return error ();
+        return Token::TEXT;
+    }
+
+    if (++m_p < m_end && *m_p == '/')
+    {
+        if (m_open.empty ())
+            return error ();
+        ++m_p;
+        if (!read_name (m_name, m_name_len))
+            return error ();
+        auto& open = m_open.back ();
+        if (open.second != m_name_len ||
+            memcmp (open.first, m_name, m_name_len) != 0)
+            return error ();
+        skip_space ();
+        if (m_p == m_end || *m_p != '>')
+            return error ();
+        ++m_p;
+        m_open.pop_back ();
+        return Token::END;
+    }
+
+    if (!read_name (m_name, m_name_len))
+        return error ();
+
+    m_n_attrs = 0;
+    while (true)
+    {
+        auto before = m_p;
+        skip_space ();
+        if (m_p == m_end)
+            return error ();
+        if (*m_p == '>')
+        {
+            ++m_p;
+            break;
+        }
+        if (*m_p == '/')
+        {
+            if (++m_p == m_end || *m_p != '>')
+                return error ();
+            ++m_p;
+            m_empty_end = true;
+            break;
+        }
+        if (m_p == before)
+            return error ();
+
+        const char* name;
+        size_t len;
+        if (!read_name (name, len))
+            return error ();
+        for (size_t i = 0; i < m_n_attrs; ++i)
+            if (m_attrs[i].name_len == len &&
+                memcmp (m_attrs[i].name, name, len) == 0)
+                return error ();
+        skip_space ();
+        if (m_p == m_end || *m_p != '=')
+            return error ();
+        ++m_p;
+        skip_space ();
+        if (m_p == m_end || (*m_p != '"' && *m_p != '\''))
+            return error ();
+        auto quote = *m_p++;
+
+        if (m_n_attrs == m_attrs.size ())
+            m_attrs.emplace_back ();
+        auto& attr = m_attrs[m_n_attrs++];
+        attr.name = name;
+        attr.name_len = len;
+        attr.value.clear ();
+        if (!read_chars (attr.value, quote))
+            return error ();
+        ++m_p;
+    }
+
+    m_started = true;
+    m_open.emplace_back (m_name, m_name_len);
+    return Token::START;
+}
+
+bool
+GncXmlReader::is (const char* name) const
+{
+    return strncmp (m_name, name, m_name_len) == 0 && !name[m_name_len];
+}
+
+const char*
+GncXmlReader::attribute (const char* name) const
+{
+    for (size_t i = 0; i < m_n_attrs; ++i)
+        if (strncmp (m_attrs[i].name, name, m_attrs[i].name_len) == 0 &&
+            !name[m_attrs[i].name_len])
+            return m_attrs[i].value.c_str ();
+    return nullptr;
+}
+
+bool
+GncXmlReader::read_text (std::string& text)
+{
+    text.clear ();
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::TEXT:
+            text += m_text;
+            break;
+        case Token::END:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+bool
+GncXmlReader::skip ()
+{
+    int depth = 1;
+
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::START:
+            ++depth;
+            break;
+        case Token::END:
+            if (--depth == 0)
+                return true;
+            break;
+        case Token::TEXT:
+            break;
+        default:
+            return false;
+        }
+    }
+}
+
+bool
+GncXmlReader::read_guid (GncGUID& guid)
+{
+    auto type = attribute ("type");
+    std::string text;
+
+    if (m_n_attrs != 1 || !type ||
+        (strcmp (type, "guid") != 0 && strcmp (type, "new") != 0))
+        return false;
+    return read_text (text) && string_to_guid (text.c_str (), &guid);
+}
+
+bool
+GncXmlReader::read_time64 (time64& time)
+{
+    std::string text;
+    bool seen = false;
+
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::TEXT:
+            break;
+        case Token::START:
+            if (seen || !is ("ts:date") || !read_text (text))
+                return false;
+            time = gnc_iso8601_to_time64_gmt (text.c_str ());
+            seen = true;
+            break;
+        case Token::END:
+            return seen && time != INT64_MAX;
+        default:
+            return false;
+        }
+    }
+}
+
+bool
+GncXmlReader::read_gdate (GDate& date)
+{
+    std::string text;
+    bool seen = false;
+
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::TEXT:
+            break;
+        case Token::START:
+        {
+            gint year, month, day;
+            if (seen || !is ("gdate") || !read_text (text) ||
+                sscanf (text.c_str (), "%d-%d-%d", &year, &month, &day) != 3 ||
+                year < 1 || year > G_MAXUINT16 || month < 1 || month > 12 ||
+                day < 1 || day > 31 ||
+                !g_date_valid_dmy (day, static_cast<GDateMonth> (month), year))
+                return false;
+            g_date_clear (&date, 1);
+            g_date_set_dmy (&date, day, static_cast<GDateMonth> (month), year);
+            seen = true;
+            break;
+        }
+        case Token::END:
+            return seen;
+        default:
+            return false;
+        }
+    }
+}
+
+bool
+GncXmlReader::read_numeric (gnc_numeric& num)
+{
+    std::string text;
+
+    if (!read_text (text))
+        return false;
+    if (!string_to_gnc_numeric (text.c_str (), &num))
+        num = gnc_numeric_zero ();
+    return true;
+}
+
+/* As g_strstrip */
+static void
+strip (std::string& str)
+{
+    auto not_space = [] (char c) { return !g_ascii_isspace (c); };
+    str.erase (std::find_if (str.rbegin (), str.rend (), not_space).base (),
+               str.end ());
+    str.erase (str.begin (), std::find_if (str.begin (), str.end (),
+                                           not_space));
+}
+
+bool
+GncXmlReader::read_commodity_ref (std::string& name_space,
+                                  std::string& mnemonic)
+{
+    bool have_space = false, have_id = false;
+
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::TEXT:
+            break;
+        case Token::START:
+            if (is ("cmdty:space") && !have_space)
+            {
+                if (!read_text (name_space))
+                    return false;
+                have_space = true;
+            }
+            else if (is ("cmdty:id") && !have_id)
+            {
+                if (!read_text (mnemonic))
+                    return false;
+                have_id = true;
+            }
+            else
+            {
+                return false;
+            }
+            break;
+        case Token::END:
+            if (!have_space || !have_id)
+                return false;
+            strip (name_space);
+            strip (mnemonic);
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+bool
+GncXmlReader::read_slots (GncXmlSlots& slots)
+{
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::TEXT:
+            break;
+        case Token::START:
+            if (is ("slot"))
+            {
+                std::string key;
+                bool has_key = false;
+                std::unique_ptr<KvpValue> value;
+
+                if (!read_slot (key, has_key, value))
+                    return false;
+                if (has_key && value)
+                    slots.emplace_back (std::move (key), std::move (value));
+            }
+            else if (!skip ())
+            {
+                return false;
+            }
+            break;
+        case Token::END:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+bool
+GncXmlReader::read_slot (std::string& key, bool& has_key,
+                         std::unique_ptr<KvpValue>& value)
+{
+    while (true)
+    {
+        switch (next ())
+        {
+        case Token::TEXT:
+            break;
+        case Token::START:
+            if (is ("slot:key"))
+            {
+                if (!read_text (key))
+                    return false;
+                has_key = true;
+            }
+            else if (is ("slot:value"))
+            {
+                if (!read_kvp_value (value))
+                    return false;
+            }
+            else if (!skip ())
+            {
+                return false;
+            }
+            break;
+        case Token::END:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+/* As dom_tree_to_kvp_value: value is left empty where that would return
+ * NULL without complaining. */
+bool
+GncXmlReader::read_kvp_value (std::unique_ptr<KvpValue>& value)
+{
+    enum { INTEGER, DOUBLE, NUMERIC, STRING, GUID, TIMESPEC, GDATE, LIST,
+           FRAME, UNKNOWN };
+    static const char* types[] =
+    {
+        "integer", "double", "numeric", "string", "guid", "timespec",
+        "gdate", "list", "frame"
+    };
+    auto type_name = attribute ("type");
+    int type = UNKNOWN;
+    std::string text;
+
+    value.reset ();
+    if (!type_name)
+        return false;
+    for (int i = 0; i < UNKNOWN; ++i)
+        if (strcmp (type_name, types[i]) == 0)
+            type = i;
+
+    switch (type)
+    {
+    case INTEGER:
+    {
+        gint64 val;
+        if (!read_text (text))
+            return false;
+        if (string_to_gint64 (text.c_str (), &val))
+            value.reset (new KvpValue {val});
+        return true;
+    }
+    case DOUBLE:
+    {
+        double val;
+        if (!read_text (text))
+            return false;
+        if (string_to_double (text.c_str (), &val))
+            value.reset (new KvpValue {val});
+        return true;
+    }
+    case NUMERIC:
+    {
+        gnc_numeric val;
+        if (!read_numeric (val))
+            return false;
+        value.reset (new KvpValue {val});
+        return true;
+    }
+    case STRING:
+    {
+        if (!read_text (text))
+            return false;
+        const gchar* str = g_strdup (text.c_str ());
+        value.reset (new KvpValue {str});
+        return true;
+    }
+    case GUID:
+    {
+        GncGUID guid;
+        if (!read_guid (guid))
+            return false;
+        value.reset (new KvpValue {guid_copy (&guid)});
+        return true;
+    }
+    case TIMESPEC:
+    {
+        time64 time;
+        if (!read_time64 (time))
+            return false;
+        value.reset (new KvpValue {Time64 {time}});
+        return true;
+    }
+    case GDATE:
+    {
+        GDate date;
+        if (!read_gdate (date))
+            return false;
+        value.reset (new KvpValue {date});
+        return true;
+    }
+    case LIST:
+    {
+        GList* list = NULL;
+        bool ok = true;
+
+        while (ok)
+        {
+            auto token = next ();
+            if (token == Token::END)
+                break;
+            if (token == Token::START)
+            {
+                std::unique_ptr<KvpValue> item;
+                ok = read_kvp_value (item);
+                if (item)
+                    list = g_list_prepend (list, item.release ());
+            }
+            else if (token != Token::TEXT)
+            {
+                ok = false;
+            }
+        }
+        list = g_list_reverse (list);
+        if (!ok)
+        {
+            for (auto node = list; node; node = node->next)
+                delete static_cast<KvpValue*> (node->data);
+            g_list_free (list);
+            return false;
+        }
+        value.reset (new KvpValue {list});
+        return true;
+    }
+    case FRAME:
+    {
+        GncXmlSlots slots;
+        if (!read_slots (slots))
+            return false;
+        auto frame = new KvpFrame;
+        for (auto& slot : slots)
+            delete frame->set ({slot.first}, slot.second.release ());
+        value.reset (new KvpValue {frame});
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/***********************************************************************/
+
+GncXmlSplitter::GncXmlSplitter (const char* element,
+                                std::vector<std::string> parents) :
+    m_element {element}, m_parents {std::move (parents)}
+{
+}
+
+void
+GncXmlSplitter::feed (const char* data, size_t len)
+{
+    if (m_start > 0)
+    {
+        m_buf.erase (0, m_start);
+        m_pos -= m_start;
+        if (m_element_end)
+            m_element_end -= m_start;
+        m_start = 0;
+    }
+    m_buf.append (data, len);
+}
+
+void
+GncXmlSplitter::finish ()
+{
+    m_finished = true;
+}
+
+/* The length of the markup starting with the '<' at pos, or 0 if it
+ * isn't all there yet. */
+size_t
+GncXmlSplitter::markup_length (size_t pos, Markup& kind,
+                               size_t& name_len) const
+{
+    auto buf = m_buf.data ();
+    auto size = m_buf.size ();
+    auto find = [this] (size_t from, const char* str) -> size_t
+    {
+        auto found = m_buf.find (str, from);
+        return found == std::string::npos ? 0 : found + strlen (str);
+    };
+    auto starts = [buf, size, pos] (const char* str)
+    {
+        return size - pos >= strlen (str) &&
+               memcmp (buf + pos, str, strlen (str)) == 0;
+    };
+    size_t end;
+
+    if (pos + 1 >= size)
+        return 0;
+
+    switch (buf[pos + 1])
+    {
+    case '/':
+        kind = Markup::END;
+        end = find (pos + 2, ">");
+        break;
+    case '?':
+        kind = starts ("<?xml ") ? Markup::DECLARATION : Markup::OTHER;
+        end = find (pos + 2, "?>");
+        break;
+    case '!':
+        if (size - pos < 9 && !m_finished)
+            return 0;
+        if (starts ("<!--"))
+        {
+            kind = Markup::OTHER;
+            end = find (pos + 4, "-->");
+        }
+        else if (starts ("<![CDATA["))
+        {
+            kind = Markup::OTHER;
+            end = find (pos + 9, "]]>");
+        }
+        else
+        {
+            kind = Markup::DOCTYPE;
+            end = find (pos + 2, ">");
+        }
+        break;
+    default:
+    {
+        char quote = 0;
+
+        name_len = 0;
+        while (pos + 1 + name_len < size &&
+               is_name_char (buf[pos + 1 + name_len]))
+            ++name_len;
+        end = 0;
+        for (auto p = pos + 1 + name_len; p < size; ++p)
+        {
+            if (quote)
+            {
+                if (buf[p] == quote)
+                    quote = 0;
+            }
+            else if (buf[p] == '"' || buf[p] == '\'')
+            {
+                quote = buf[p];
+            }
+            else if (buf[p] == '>')
+            {
+                end = p + 1;
+                break;
+            }
+        }
+        kind = (end && buf[end - 2] == '/') ? Markup::EMPTY : Markup::START;
+        break;
+    }
+    }
+
+    return end ? end - pos : 0;
+}
+
+/* The length of the element whose start tag is at pos, or 0 if it isn't
+ * all there yet. */
+size_t
+GncXmlSplitter::element_length (size_t pos) const
+{
+    auto buf = m_buf.data ();
+    auto end = pos;
+    size_t depth = 0;
+
+    do
+    {
+        auto lt = static_cast<const char*> (memchr (buf + end, '<',
+                                                    m_buf.size () - end));
+        Markup kind;
+        size_t name_len;
+
+        if (!lt)
+            return 0;
+        auto start = lt - buf;
+        auto len = markup_length (start, kind, name_len);
+        if (!len)
+            return 0;
+        end = start + len;
+
+        if (kind == Markup::START)
+            ++depth;
+        else if (kind == Markup::END)
+            --depth;
+    }
+    while (depth > 0);
+
+    return end - pos;
+}
+
+/* Whether what comes before the first markup, and the XML declaration if
+ * that's what it is, leave the stream in UTF-8. */
+bool
+GncXmlSplitter::prolog_ok (size_t pos, size_t len, Markup kind) const
+{
+    auto p = m_start;
+
+    if (pos - p >= 3 && memcmp (m_buf.data () + p, "\xef\xbb\xbf", 3) == 0)
+        p += 3;
+    for (; p < pos; ++p)
+        if (!is_space (m_buf[p]) && m_buf[p] != '\r')
+            return false;
+
+    if (kind != Markup::DECLARATION)
+        return true;
+
+    std::string decl {m_buf, pos, len};
+    auto enc = decl.find ("encoding");
+    if (enc == std::string::npos)
+        return true;
+    auto quote = decl.find_first_of ("\"'", enc);
+    if (quote == std::string::npos)
+        return false;
+    auto end = decl.find (decl[quote], quote + 1);
+    if (end == std::string::npos)
+        return false;
+    auto encoding = decl.substr (quote + 1, end - quote - 1);
+    return g_ascii_strcasecmp (encoding.c_str (), "UTF-8") == 0 ||
+           g_ascii_strcasecmp (encoding.c_str (), "UTF8") == 0;
+}
+
+bool
+GncXmlSplitter::splits_here (size_t name_pos, size_t name_len) const
+{
+    if (name_len != m_element.size () ||
+        m_buf.compare (name_pos, name_len, m_element) != 0)
+        return false;
+    for (auto& parent : m_parents)
+        if (parent == m_path)
+            return true;
+    return false;
+}
+
+GncXmlSplitter::Piece
+GncXmlSplitter::take_text (const char*& data, size_t& len)
+{
+    data = m_buf.data () + m_start;
+    len = m_pos - m_start;
+    m_start = m_pos;
+    return Piece::TEXT;
+}
+
+GncXmlSplitter::Piece
+GncXmlSplitter::next (const char*& data, size_t& len)
+{
+    while (m_enabled)
+    {
+        if (m_element_end)
+        {
+            data = m_buf.data () + m_pos;
+            len = m_element_end - m_pos;
+            m_start = m_pos = m_element_end;
+            m_element_end = 0;
+            return Piece::ELEMENT;
+        }
+
+        auto lt = static_cast<const char*> (memchr (m_buf.data () + m_pos, '<',
+                                                    m_buf.size () - m_pos));
+        /* Nothing before the first markup is handed back until it has been
+         * checked. */
+        if (!lt)
+        {
+            if (m_started || m_finished)
+                m_pos = m_buf.size ();
+            break;
+        }
+
+        size_t pos = lt - m_buf.data ();
+        Markup kind;
+        size_t name_len;
+        auto markup_len = markup_length (pos, kind, name_len);
+        if (!markup_len)
+        {
+            if (m_started)
+                m_pos = pos;
+            if (!m_finished)
+                break;
+            m_enabled = false;
+            continue;
+        }
+
+        if (!m_started)
+        {
+            m_started = true;
+            if (!prolog_ok (pos, markup_len, kind))
+            {
+                m_enabled = false;
+                continue;
+            }
+        }
+
+        switch (kind)
+        {
+        case Markup::START:
+            if (splits_here (pos + 1, name_len))
+            {
+                auto elem_len = element_length (pos);
+                m_pos = pos;
+                if (!elem_len)
+                {
+                    if (m_finished)
+                        m_enabled = false;
+                    goto done;
+                }
+                m_element_end = pos + elem_len;
+                if (m_pos > m_start)
+                    return take_text (data, len);
+                continue;
+            }
+            m_path_lens.push_back (m_path.size ());
+            if (!m_path.empty ())
+                m_path += '/';
+            m_path.append (m_buf, pos + 1, name_len);
+            break;
+        case Markup::END:
+            if (m_path_lens.empty ())
+            {
+                m_enabled = false;
+                continue;
+            }
+            m_path.resize (m_path_lens.back ());
+            m_path_lens.pop_back ();
+            break;
+        case Markup::DOCTYPE:
+            m_enabled = false;
+            continue;
+        default:
+            break;
+        }
+        m_pos = pos + markup_len;
+    }
+
+done:
+    if (!m_enabled)
+        m_pos = m_buf.size ();
+    if (m_pos > m_start)
+        return take_text (data, len);
+    return Piece::NONE;
+}
@@ -0,0 +1,187 @@
+/********************************************************************
+ * gnc-xml-reader.hpp: Read XML without building a DOM tree.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#ifndef GNC_XML_READER_HPP
+#define GNC_XML_READER_HPP
+
+extern "C"
+{
+#include <glib.h>
+
+#include "qof.h"
+}
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** The slots read for an instance, in the order they were in the file. */
+typedef std::vector<std::pair<std::string, std::unique_ptr<KvpValue>>>
+    GncXmlSlots;
+
+/** Reads one element of XML a token at a time, for loading objects on
+ * threads that mustn't touch libxml2's parser or the book.
+ *
+ * It only reads what the file backend writes: elements, attributes,
+ * text and the predefined and numeric character references, in UTF-8.
+ * Anything else -- comments, processing instructions, CDATA sections,
+ * other entities, carriage returns, tabs or newlines in attribute
+ * values, characters XML doesn't allow, mismatched tags -- is an ERROR.
+ * The caller should then give the element to the SAX parser after all,
+ * so that it is treated exactly as it always has been.
+ *
+ * Element and attribute names point into the input, which must outlive
+ * the reader.
+ */
+class GncXmlReader
+{
+public:
+    enum class Token { START, END, TEXT, END_OF_INPUT, ERROR };
+
+    GncXmlReader (const char* begin, const char* end);
+    GncXmlReader (const GncXmlReader&) = delete;
+    GncXmlReader& operator= (const GncXmlReader&) = delete;
+
+    /** Read the next token.  An empty element gives a START and an END;
+     * once the outermost element has ended the input must be used up. */
+    Token next ();
+    /** Whether the element just started or ended is called name. */
+    bool is (const char* name) const;
+    /** The value of the named attribute of the element just started, or
+     * nullptr.  Only good until the next call to next(). */
+    const char* attribute (const char* name) const;
+    size_t attribute_count () const { return m_n_attrs; }
+    /** The TEXT just read, with its references replaced. */
+    const std::string& text () const { return m_text; }
+
+    /** Having just read a START, read the element's text and its END.
+     * @return false if it has elements in it or on an error. */
+    bool read_text (std::string& text);
+    /** Having just read a START, skip to after its END. */
+    bool skip ();
+
+    /* These mirror the sixtp-dom-parsers of the same names, to be called
+     * having just read the START of the element they convert.  They
+     * return false wherever those would complain or make something up,
+     * which leaves the element to the SAX parser. */
+
+    bool read_guid (GncGUID& guid);
+    bool read_time64 (time64& time);
+    bool read_gdate (GDate& date);
+    bool read_numeric (gnc_numeric& num);
+    bool read_commodity_ref (std::string& name_space, std::string& mnemonic);
+    /** The <slot>s of an instance's slots element or a frame value.  The
+     * values are put in the order read, so a later slot with the same key
+     * replaces an earlier one, just as dom_tree_to_kvp_frame_given does. */
+    bool read_slots (GncXmlSlots& slots);
+
+private:
+    struct Attribute
+    {
+        const char* name;
+        size_t name_len;
+        std::string value;
+    };
+
+    Token error ();
+    void skip_space ();
+    bool read_name (const char*& name, size_t& len);
+    bool read_chars (std::string& out, char stop);
+    bool read_reference (std::string& out);
+    bool read_slot (std::string& key, bool& has_key,
+                    std::unique_ptr<KvpValue>& value);
+    bool read_kvp_value (std::unique_ptr<KvpValue>& value);
+
+    const char* m_p;
+    const char* m_end;
+    const char* m_name = nullptr;
+    size_t m_name_len = 0;
+    std::vector<std::pair<const char*, size_t>> m_open;
+    std::vector<Attribute> m_attrs;
+    size_t m_n_attrs = 0;
+    std::string m_text;
+    bool m_started = false;
+    /* The START just read was an empty element, so next() gives its END. */
+    bool m_empty_end = false;
+    bool m_failed = false;
+};
+
+/** Cuts the elements with a given name out of a stream of XML, so that
+ * they can be read with a GncXmlReader while the rest of the stream goes
+ * to the SAX parser.
+ *
+ * The stream is fed in as it is read and handed back in pieces: TEXT is
+ * everything that isn't one of the elements, ELEMENT is one whole
+ * element.  The pieces come in the same order as in the stream, and
+ * together they are all of it.  Only elements whose parent is one of
+ * the given paths of element names, such as "gnc-v2/gnc:book", are cut
+ * out.
+ *
+ * If the stream doesn't look like UTF-8, or has a document type
+ * declaration, or stops making sense, nothing more is cut out and the
+ * rest comes back as TEXT, for the SAX parser to deal with.
+ */
+class GncXmlSplitter
+{
+public:
+    enum class Piece { NONE, TEXT, ELEMENT };
+
+    GncXmlSplitter (const char* element, std::vector<std::string> parents);
+    GncXmlSplitter (const GncXmlSplitter&) = delete;
+    GncXmlSplitter& operator= (const GncXmlSplitter&) = delete;
+
+    /** Add the next len bytes of the stream.  This invalidates the
+     * pieces returned before. */
+    void feed (const char* data, size_t len);
+    /** Say that there is nothing more to feed. */
+    void finish ();
+    /** The next piece of the stream, or NONE if there isn't one until more
+     * is fed. */
+    Piece next (const char*& data, size_t& len);
+
+private:
+    enum class Markup { START, EMPTY, END, DECLARATION, OTHER, DOCTYPE };
+
+    size_t markup_length (size_t pos, Markup& kind, size_t& name_len) const;
+    size_t element_length (size_t pos) const;
+    bool prolog_ok (size_t pos, size_t len, Markup kind) const;
+    bool splits_here (size_t name_pos, size_t name_len) const;
+    Piece take_text (const char*& data, size_t& len);
+
+    std::string m_element;
+    std::vector<std::string> m_parents;
+    std::string m_buf;
+    /* The start of what hasn't been handed back and of what hasn't been
+     * scanned. */
+    size_t m_start = 0;
+    size_t m_pos = 0;
+    /* The end of the element at m_pos, once it has been found. */
+    size_t m_element_end = 0;
+    /* The names of the open elements, separated by '/'. */
+    std::string m_path;
+    std::vector<size_t> m_path_lens;
+    bool m_started = false;
+    bool m_enabled = true;
+    bool m_finished = false;
+};
+
+#endif /* GNC_XML_READER_HPP */
@@ -0,0 +1,460 @@
+/********************************************************************
+ * gnc-xml-writer.cpp: Write XML without building a DOM tree.       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <string.h>
+
+#include <gnc-date.h>
+}
+
+#include "gnc-xml-writer.hpp"
+#include "gnc-xml-helper.h"
+#include "sixtp-dom-generators.h"
+
+#include <qofinstance-p.h>
+#include <kvp-frame.hpp>
+#include <gnc-datetime.hpp>
+
+#include <algorithm>
+
+/* libxml2 stops indenting at this level (its MAX_INDENT / 2). */
+static const size_t max_indent_level = 30;
+static const size_t flush_size = 64 * 1024;
+
+GncXmlWriter::GncXmlWriter (FILE* out, int level) :
+    m_out {out}, m_level {static_cast<size_t> (level)}, m_buf (m_own_buf)
+{
+    m_buf.reserve (flush_size + flush_size / 4);
+}
+
+GncXmlWriter::GncXmlWriter (std::string& out, int level) :
+    m_out {nullptr}, m_level {static_cast<size_t> (level)}, m_buf (out)
+{
+}
+
+GncXmlWriter::~GncXmlWriter ()
+{
+    flush ();
+}
+
+bool
+GncXmlWriter::flush ()
+{
+    if (m_out && !m_buf.empty ())
+    {
+        if (fwrite (m_buf.data (), 1, m_buf.size (), m_out) != m_buf.size ())
+            m_ok = false;
+        m_buf.clear ();
+    }
+    return good ();
+}
+
+bool
+GncXmlWriter::good () const
+{
+    return m_ok && (!m_out || !ferror (m_out));
+}
+
+void
+GncXmlWriter::indent (size_t level)
+{
+    m_buf.append (2 * std::min (level, max_indent_level), ' ');
+}
+
+/* Finish the start tag of the innermost element if it's still open and
+ * note what it holds. */
+void
+GncXmlWriter::open_content (Content content)
+{
+    auto& elem = m_open.back ();
+    if (elem.content != Content::NONE)
+        return;
+    m_buf += '>';
+    if (content == Content::ELEMENTS)
+        m_buf += '\n';
+    elem.content = content;
+}
+
+void
+GncXmlWriter::start (const char* tag)
+{
+    if (!m_open.empty ())
+    {
+        open_content (Content::ELEMENTS);
+        indent (m_level + m_open.size ());
+    }
+    m_buf += '<';
+    m_buf += tag;
+    m_open.push_back ({tag, Content::NONE});
+}
+
+void
+GncXmlWriter::attribute (const char* name, const char* value)
+{
+    m_buf += ' ';
+    m_buf += name;
+    m_buf += "=\"";
+    escape_attribute (value);
+    m_buf += '"';
+}
+
+void
+GncXmlWriter::end ()
+{
+    auto elem = m_open.back ();
+    m_open.pop_back ();
+
+    switch (elem.content)
+    {
+    case Content::NONE:
+        m_buf += "/>";
+        break;
+    case Content::ELEMENTS:
+        indent (m_level + m_open.size ());
+        /* fall through */
+    case Content::TEXT:
+        m_buf += "</";
+        m_buf += elem.tag;
+        m_buf += '>';
+        break;
+    }
+
+    if (!m_open.empty ())
+        m_buf += '\n';
+    else if (m_out && m_buf.size () >= flush_size)
+        flush ();
+}
+
+void
+GncXmlWriter::raw (const char* str)
+{
+    m_buf += str;
+}
+
+/* What xmlEscapeContent does to a text node. */
+void
+GncXmlWriter::escape_text (const char* str, size_t len)
+{
+    auto run = str;
+    for (auto p = str; p < str + len; ++p)
+    {
+        const char* entity;
+        switch (*p)
+        {
+        case '<':
+            entity = "&lt;";
+            break;
+        case '>':
+            entity = "&gt;";
+            break;
+        case '&':
+            entity = "&amp;";
+            break;
+        case '\r':
+            entity = "&#13;";
+            break;
+        default:
+            continue;
+        }
+        m_buf.append (run, p - run);
+        m_buf += entity;
+        run = p + 1;
+    }
+    m_buf.append (run, str + len - run);
+}
+
+/* What libxml2 does to an attribute value.  It would also write any
+ * non-ASCII character as a character reference, but every value written
+ * here is a constant. */
+void
+GncXmlWriter::escape_attribute (const char* str)
+{
+    for (auto p = str; *p; ++p)
+    {
+        switch (*p)
+        {
+        case '<':
+            m_buf += "&lt;";
+            break;
+        case '>':
+            m_buf += "&gt;";
+            break;
+        case '&':
+            m_buf += "&amp;";
+            break;
+        case '"':
+            m_buf += "&quot;";
+            break;
+        case '\n':
+            m_buf += "&#10;";
+            break;
+        case '\r':
+            m_buf += "&#13;";
+            break;
+        case '\t':
+            m_buf += "&#9;";
+            break;
+        default:
+            m_buf += *p;
+            break;
+        }
+    }
+}
+
+void
+GncXmlWriter::text (const char* str, bool check)
+{
+    open_content (Content::TEXT);
+    if (!str)
+        return;
+
+    auto len = strlen (str);
+    /* Only copy the string for checked_char_cast if it has something that
+     * checked_char_cast might change. */
+    if (check)
+    {
+        for (auto p = reinterpret_cast<const unsigned char*> (str);
+             *p; ++p)
+        {
+            if (*p >= 0x80 ||
+                (*p < 0x20 && *p != '\t' && *p != '\n' && *p != '\r'))
+            {
+                std::string copy {str, len};
+                checked_char_cast (&copy[0]);
+                escape_text (copy.data (), len);
+                return;
+            }
+        }
+    }
+    escape_text (str, len);
+}
+
+void
+GncXmlWriter::text_child (const char* tag, const char* str)
+{
+    start (tag);
+    if (str)
+        text (str);
+    end ();
+}
+
+void
+GncXmlWriter::text_element (const char* tag, const char* str)
+{
+    if (!str)
+        return;
+    start (tag);
+    if (*str)
+        text (str);
+    end ();
+}
+
+void
+GncXmlWriter::int_element (const char* tag, gint64 val)
+{
+    char str[32];
+    snprintf (str, sizeof (str), "%" G_GINT64_FORMAT, val);
+    text_element (tag, str);
+}
+
+void
+GncXmlWriter::guid_element (const char* tag, const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (gid, guid_str))
+        return;
+    start (tag);
+    attribute ("type", "guid");
+    text (guid_str, false);
+    end ();
+}
+
+void
+GncXmlWriter::commodity_ref (const char* tag, const gnc_commodity* c)
+{
+    if (!c)
+        return;
+    auto name_space = gnc_commodity_get_namespace (c);
+    auto mnemonic = gnc_commodity_get_mnemonic (c);
+    if (!name_space || !mnemonic)
+        return;
+
+    start (tag);
+    text_child ("cmdty:space", name_space);
+    text_child ("cmdty:id", mnemonic);
+    end ();
+}
+
+void
+GncXmlWriter::time64_element (const char* tag, time64 time, const char* type)
+{
+    if (time == INT64_MAX)
+        return;
+    auto date_str = GncDateTime(time).format_iso8601();
+    if (date_str.empty())
+        return;
+    date_str += " +0000"; //Tack on a UTC offset to mollify GnuCash for Android
+
+    start (tag);
+    if (type)
+        attribute ("type", type);
+    text_child ("ts:date", date_str.c_str ());
+    end ();
+}
+
+void
+GncXmlWriter::gdate_element (const char* tag, const GDate* date,
+                             const char* type)
+{
+    char date_str[512] = "";
+
+    if (!date)
+        return;
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+
+    start (tag);
+    if (type)
+        attribute ("type", type);
+    text_child ("gdate", date_str);
+    end ();
+}
+
+void
+GncXmlWriter::numeric_element (const char* tag, gnc_numeric num)
+{
+    auto numstr = gnc_numeric_to_string (num);
+    text_element (tag, numstr);
+    g_free (numstr);
+}
+
+void
+GncXmlWriter::instance_slots (const char* tag, const QofInstance* inst)
+{
+    auto frame = qof_instance_get_slots (inst);
+    if (!frame || frame->empty ())
+        return;
+
+    start (tag);
+    frame->for_each_slot_temp ([this] (const char* key, KvpValue* val)
+                               {
+                                   kvp_slot (key, val);
+                               });
+    end ();
+}
+
+void
+GncXmlWriter::kvp_slot (const char* key, KvpValue* val)
+{
+    start ("slot");
+    text_child ("slot:key", key);
+    kvp_value ("slot:value", val);
+    end ();
+}
+
+void
+GncXmlWriter::kvp_value (const char* tag, KvpValue* val)
+{
+    auto typed_text = [this, tag] (const char* type, const char* str)
+    {
+        start (tag);
+        attribute ("type", type);
+        if (str && *str)
+            text (str);
+        end ();
+    };
+
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::INT64:
+    {
+        char str[32];
+        snprintf (str, sizeof (str), "%" G_GINT64_FORMAT,
+                  val->get<int64_t> ());
+        typed_text ("integer", str);
+        break;
+    }
+    case KvpValue::Type::DOUBLE:
+    {
+        auto str = double_to_string (val->get<double> ());
+        typed_text ("double", str);
+        g_free (str);
+        break;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        auto str = gnc_numeric_to_string (val->get<gnc_numeric> ());
+        typed_text ("numeric", str);
+        g_free (str);
+        break;
+    }
+    case KvpValue::Type::STRING:
+        start (tag);
+        attribute ("type", "string");
+        if (auto str = val->get<const char*> ())
+            text (str);
+        end ();
+        break;
+    case KvpValue::Type::GUID:
+    {
+        char guidstr[GUID_ENCODING_LENGTH + 1];
+        if (guid_to_string_buff (val->get<GncGUID*> (), guidstr))
+            typed_text ("guid", guidstr);
+        break;
+    }
+    /* Note: The type attribute must remain 'timespec' to maintain
+     * compatibility.
+     */
+    case KvpValue::Type::TIME64:
+        time64_element (tag, val->get<Time64> ().t, "timespec");
+        break;
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate> ();
+        gdate_element (tag, &d, "gdate");
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        start (tag);
+        attribute ("type", "list");
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+            kvp_value ("slot:value", static_cast<KvpValue*> (cursor->data));
+        end ();
+        break;
+    case KvpValue::Type::FRAME:
+        start (tag);
+        attribute ("type", "frame");
+        if (auto frame = val->get<KvpFrame*> ())
+            frame->for_each_slot_temp ([this] (const char* key,
+                                               KvpValue* slot)
+                                       {
+                                           kvp_slot (key, slot);
+                                       });
+        end ();
+        break;
+    default:
+        start (tag);
+        end ();
+        break;
+    }
+}
@@ -0,0 +1,125 @@
+/********************************************************************
+ * gnc-xml-writer.hpp: Write XML without building a DOM tree.       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#ifndef GNC_XML_WRITER_HPP
+#define GNC_XML_WRITER_HPP
+
+extern "C"
+{
+#include <glib.h>
+#include <stdio.h>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+}
+
+#include <string>
+#include <vector>
+
+/** Writes elements straight to a buffered FILE*, producing the same bytes
+ * that xmlElemDump would for the tree the sixtp-dom-generators build.
+ *
+ * That means libxml2's formatting: an element with no children is
+ * written as <tag/>, one with text is written on one line, and one with
+ * only element children has each child on its own line, indented two
+ * spaces per level.  No element the generators build mixes text and
+ * elements, so the writer decides how to lay an element out from its
+ * first child.
+ *
+ * The start level is the nesting level of the elements written at the
+ * top, as xmlNodeDumpOutput's level argument; it only changes the
+ * indentation of their children.  Nothing is written between top-level
+ * elements: use raw() for that.
+ *
+ * Output is buffered and written when the buffer fills, on flush() or on
+ * destruction, so flush() before writing to the FILE* some other way.
+ * A writer made on a string just appends to it.
+ */
+class GncXmlWriter
+{
+public:
+    GncXmlWriter (FILE* out, int level = 0);
+    GncXmlWriter (std::string& out, int level = 0);
+    GncXmlWriter (const GncXmlWriter&) = delete;
+    GncXmlWriter& operator= (const GncXmlWriter&) = delete;
+    ~GncXmlWriter ();
+
+    /** Open an element. */
+    void start (const char* tag);
+    /** Add an attribute to the element just opened, before any content. */
+    void attribute (const char* name, const char* value);
+    /** Add text to the open element.  Unless check is false the text is
+     * cleaned up with checked_char_cast, as the generators do; it is
+     * always escaped.  An empty string still makes the element a text
+     * element: <tag></tag>. */
+    void text (const char* str, bool check = true);
+    /** Close the innermost open element. */
+    void end ();
+    /** Write str as it is, outside of any element. */
+    void raw (const char* str);
+
+    /** Write the buffer out; a string writer has nothing to do.
+     * @return false if the FILE* has had an error. */
+    bool flush ();
+    /** false once writing has failed. */
+    bool good () const;
+
+    /* These mirror the sixtp-dom-generators of the same names and write
+     * nothing where those would return NULL. */
+
+    /** As xmlNewTextChild: a NULL str gives an empty element. */
+    void text_child (const char* tag, const char* str);
+    /** As text_to_dom_tree: an empty str gives an empty element. */
+    void text_element (const char* tag, const char* str);
+    void int_element (const char* tag, gint64 val);
+    void guid_element (const char* tag, const GncGUID* gid);
+    void commodity_ref (const char* tag, const gnc_commodity* c);
+    void time64_element (const char* tag, time64 time,
+                         const char* type = nullptr);
+    void gdate_element (const char* tag, const GDate* date,
+                        const char* type = nullptr);
+    void numeric_element (const char* tag, gnc_numeric num);
+    void instance_slots (const char* tag, const QofInstance* inst);
+
+private:
+    enum class Content { NONE, ELEMENTS, TEXT };
+    struct Element
+    {
+        const char* tag;
+        Content content;
+    };
+
+    void open_content (Content content);
+    void indent (size_t level);
+    void escape_text (const char* str, size_t len);
+    void escape_attribute (const char* str);
+    void kvp_value (const char* tag, KvpValue* val);
+    void kvp_slot (const char* key, KvpValue* val);
+
+    FILE* m_out;
+    size_t m_level;
+    bool m_ok = true;
+    std::string m_own_buf;
+    std::string& m_buf;
+    std::vector<Element> m_open;
+};
+
+#endif /* GNC_XML_WRITER_HPP */
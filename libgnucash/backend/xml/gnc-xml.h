@@ -36,6 +36,9 @@ extern "C"
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
 
+class GncXmlWriter;
+struct GncXmlTransaction;
+
 xmlNodePtr gnc_account_dom_tree_create (Account* act, gboolean exporting,
                                         gboolean allow_incompat);
 sixtp* gnc_account_sixtp_parser_create (void);
@@ -46,6 +49,10 @@ sixtp* gnc_book_id_sixtp_parser_create (void);
 sixtp* gnc_book_slots_sixtp_parser_create (void);
 
 xmlNodePtr gnc_commodity_dom_tree_create (const gnc_commodity* com);
+/** Write what gnc_commodity_dom_tree_create would make, without the tree.
+ * @return FALSE, having written nothing, where it would return NULL. */
+gboolean gnc_commodity_write_xml (GncXmlWriter& writer,
+                                  const gnc_commodity* com);
 sixtp* gnc_commodity_sixtp_parser_create (void);
 
 sixtp* gnc_freqSpec_sixtp_parser_create (void);
@@ -54,6 +61,11 @@ xmlNodePtr gnc_lot_dom_tree_create (GNCLot*);
 sixtp* gnc_lot_sixtp_parser_create (void);
 
 xmlNodePtr gnc_pricedb_dom_tree_create (GNCPriceDB* db);
+/** Whether gnc_pricedb_dom_tree_create would make a tree: the DB has a
+ * price and none of them is missing anything the tree needs. */
+gboolean gnc_pricedb_is_writable (GNCPriceDB* db);
+/** Write one of the pricedb's <price> elements without building it. */
+void gnc_price_write_xml (GncXmlWriter& writer, GNCPrice* price);
 sixtp* gnc_pricedb_sixtp_parser_create (void);
 
 xmlNodePtr gnc_schedXaction_dom_tree_create (SchedXaction* sx);
@@ -63,6 +75,20 @@ xmlNodePtr gnc_budget_dom_tree_create (GncBudget* bgt);
 sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
+/** Write what gnc_transaction_dom_tree_create would make, without the tree. */
+void gnc_transaction_write_xml (GncXmlWriter& writer, Transaction* txn);
+/** Read a <gnc:transaction> element without a DOM tree or the book, so it
+ * can be done on any thread.
+ * @return NULL if the element isn't one that the backend writes, in which
+ * case it should be given to the SAX parser after all. */
+GncXmlTransaction* gnc_transaction_parse_xml (const char* data, size_t len);
+/** Make the transaction that dom_tree_to_transaction would from what was
+ * read.  The slots are taken out of data.
+ * @return NULL, having changed nothing, if the book doesn't already have
+ * its currency, accounts and lots. */
+Transaction* gnc_transaction_from_xml_data (GncXmlTransaction* data,
+                                            QofBook* book);
+void gnc_transaction_xml_data_free (GncXmlTransaction* data);
 sixtp* gnc_transaction_sixtp_parser_create (void);
 
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
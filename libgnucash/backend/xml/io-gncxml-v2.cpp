@@ -46,6 +46,7 @@ extern "C"
 #include <zlib.h>
 #include <errno.h>
 
+#include "cap-gains.h"
 #include "gnc-engine.h"
 #include "gnc-pricedb-p.h"
 #include "Scrub.h"
@@ -70,11 +71,20 @@ extern "C"
 #include "sixtp-parsers.h"
 #include "sixtp-utils.h"
 #include "gnc-xml.h"
+#include "gnc-xml-reader.hpp"
+#include "gnc-xml-writer.hpp"
 #include "io-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
 
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 /* Do not treat -Wstrict-aliasing warnings as errors because of problems of the
  * G_LOCK* macros as declared by glib.  See
  * https://bugs.gnucash.org/show_bug.cgi?id=316221 for additional information.
@@ -95,6 +105,7 @@ typedef struct
     gchar* filename;
     gchar* perms;
     gboolean compress;
+    gint level;
 } gz_thread_params_t;
 
 /* Callback structure */
@@ -107,6 +118,7 @@ struct file_backend
     sixtp*          parser;
     FILE*           out;
     QofBook*        book;
+    GncXmlWriter*   writer;
 };
 
 static std::vector<GncXmlDataType_t> backend_registry;
@@ -125,7 +137,7 @@ gnc_v2_book_version_string;        /* see gnc-book-xml-v2 */
 /* Forward declarations */
 static FILE* try_gz_open (const char* filename, const char* perms,
                           gboolean use_gzip,
-                          gboolean compress);
+                          gboolean compress, gint level);
 static gboolean is_gzipped_file (const gchar* name);
 static gboolean wait_for_gzip (FILE* file);
 
@@ -691,6 +703,372 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+/* Transactions are read on the thread pool in batches of this many. */
+#define XML_LOAD_BATCH 256
+/* The file is read this much at a time. */
+#define XML_LOAD_BLOCK (256 * 1024)
+
+typedef struct
+{
+    GMutex mutex;
+    GCond cond;
+} XmlLoadWork;
+
+typedef struct
+{
+    XmlLoadWork* work;
+    std::vector<std::string> elements;
+    std::vector<GncXmlTransaction*> transactions;
+    gboolean done;
+} XmlLoadBatch;
+
+/* A file being loaded, read in blocks and inflated as it is read if it
+ * is compressed.  It is not mapped into memory: another program cutting
+ * a mapped file short would crash GnuCash with SIGBUS, where a read
+ * just ends early. */
+typedef struct
+{
+    FILE* file;
+    std::vector<char> raw;
+    z_stream zs;
+    std::vector<char> out;
+    gboolean gzipped;
+    /* The gzip member being inflated has ended. */
+    gboolean member_end;
+    /* There is nothing more to read from the file. */
+    gboolean raw_eof;
+} XmlLoadInput;
+
+typedef struct
+{
+    XmlLoadInput* input;
+    sixtp_gdv2* gd;
+    QofBook* book;
+    gboolean ok;
+} XmlLoadData;
+
+/* Move what is left of the raw input to the front of the buffer and read
+ * more after it. */
+static gboolean
+xml_load_input_fill (XmlLoadInput* input)
+{
+    size_t kept = input->zs.avail_in;
+    size_t n;
+
+    if (input->raw_eof)
+        return TRUE;
+    if (kept > 0)
+        memmove (input->raw.data (), input->zs.next_in, kept);
+    n = fread (input->raw.data () + kept, 1, input->raw.size () - kept,
+               input->file);
+    if (n < input->raw.size () - kept)
+    {
+        if (ferror (input->file))
+        {
+            PWARN ("Error reading XML file");
+            return FALSE;
+        }
+        input->raw_eof = TRUE;
+    }
+    input->zs.next_in = reinterpret_cast<Bytef*> (input->raw.data ());
+    input->zs.avail_in = kept + n;
+    return TRUE;
+}
+
+static gboolean
+xml_load_input_open (XmlLoadInput* input, const char* filename)
+{
+    memset (&input->zs, 0, sizeof (input->zs));
+    input->gzipped = FALSE;
+    input->member_end = FALSE;
+    input->raw_eof = FALSE;
+
+    input->file = g_fopen (filename, "rb");
+    if (!input->file)
+        return FALSE;
+    input->raw.resize (XML_LOAD_BLOCK);
+    if (!xml_load_input_fill (input))
+    {
+        fclose (input->file);
+        return FALSE;
+    }
+
+    /* Like gzread, read a file without the gzip magic number as it is. */
+    if (input->zs.avail_in >= 2 && input->zs.next_in[0] == 037 &&
+        input->zs.next_in[1] == 0213)
+    {
+        /* Adding 16 to the window bits asks for a gzip header. */
+        if (inflateInit2 (&input->zs, 16 + MAX_WBITS) != Z_OK)
+        {
+            PWARN ("Unable to set up decompression of %s", filename);
+            fclose (input->file);
+            return FALSE;
+        }
+        input->gzipped = TRUE;
+        input->out.resize (XML_LOAD_BLOCK);
+    }
+    return TRUE;
+}
+
+static void
+xml_load_input_close (XmlLoadInput* input)
+{
+    if (input->gzipped)
+        inflateEnd (&input->zs);
+    fclose (input->file);
+}
+
+/* The next len bytes of the file, inflated if it is compressed, or len 0
+ * at its end.  The bytes are only good until the next call.
+ * Returns FALSE if the file can't be read or is corrupt or cut short. */
+static gboolean
+xml_load_input_read (XmlLoadInput* input, const char*& data, size_t& len)
+{
+    len = 0;
+    if (!input->gzipped)
+    {
+        if (input->zs.avail_in == 0 && !xml_load_input_fill (input))
+            return FALSE;
+        data = reinterpret_cast<const char*> (input->zs.next_in);
+        len = std::min<size_t> (input->zs.avail_in, XML_LOAD_BLOCK);
+        input->zs.next_in += len;
+        input->zs.avail_in -= len;
+        return TRUE;
+    }
+
+    while (len == 0)
+    {
+        int ret;
+
+        if (input->zs.avail_in < 2 && !xml_load_input_fill (input))
+            return FALSE;
+
+        /* A compressed file may be several gzip members one after the
+         * other, as a parallel save writes it; gzread ignores anything
+         * after the last one. */
+        if (input->member_end)
+        {
+            if (input->zs.avail_in < 2 || input->zs.next_in[0] != 037 ||
+                input->zs.next_in[1] != 0213)
+                return TRUE;
+            inflateReset (&input->zs);
+            input->member_end = FALSE;
+        }
+
+        input->zs.next_out = reinterpret_cast<Bytef*> (input->out.data ());
+        input->zs.avail_out = input->out.size ();
+        ret = inflate (&input->zs, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END)
+        {
+            input->member_end = TRUE;
+        }
+        else if (ret == Z_BUF_ERROR && input->raw_eof)
+        {
+            PWARN ("Compressed XML file is cut short");
+            return FALSE;
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            PWARN ("Unable to decompress XML file: %s",
+                   input->zs.msg ? input->zs.msg : "unknown error");
+            return FALSE;
+        }
+        data = input->out.data ();
+        len = input->out.size () - input->zs.avail_out;
+    }
+    return TRUE;
+}
+
+static void
+xml_load_batch_run (gpointer data, gpointer user_data)
+{
+    XmlLoadBatch* batch = static_cast<XmlLoadBatch*> (data);
+
+    for (auto& element : batch->elements)
+        batch->transactions.push_back (
+            gnc_transaction_parse_xml (element.data (), element.size ()));
+
+    g_mutex_lock (&batch->work->mutex);
+    batch->done = TRUE;
+    g_cond_broadcast (&batch->work->cond);
+    g_mutex_unlock (&batch->work->mutex);
+}
+
+static void
+xml_load_parse_chunk (XmlLoadData* load, xmlParserCtxtPtr xml_context,
+                      const char* data, size_t len)
+{
+    if (load->ok && (xmlParseChunk (xml_context, data, len, 0) != 0 ||
+                     !xml_context->wellFormed))
+        load->ok = FALSE;
+}
+
+/* Wait for the batch, then add its transactions to the book in order.
+ * Any that couldn't be read, or refer to something the book doesn't have
+ * yet, go to the SAX parser in their place. */
+static void
+xml_load_batch_finish (XmlLoadData* load, xmlParserCtxtPtr xml_context,
+                       XmlLoadBatch* batch)
+{
+    g_mutex_lock (&batch->work->mutex);
+    while (!batch->done)
+        g_cond_wait (&batch->work->cond, &batch->work->mutex);
+    g_mutex_unlock (&batch->work->mutex);
+
+    for (size_t i = 0; i < batch->elements.size (); ++i)
+    {
+        GncXmlTransaction* data = batch->transactions[i];
+        Transaction* trn = NULL;
+
+        if (data && load->ok)
+            trn = gnc_transaction_from_xml_data (data, load->book);
+        gnc_transaction_xml_data_free (data);
+
+        if (trn)
+            generic_callback (TRANSACTION_TAG, load->gd, trn);
+        else
+            xml_load_parse_chunk (load, xml_context, batch->elements[i].data (),
+                                  batch->elements[i].size ());
+    }
+}
+
+static gboolean
+is_blank (const char* data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i)
+        if (!g_ascii_isspace (data[i]))
+            return FALSE;
+    return TRUE;
+}
+
+/* Give the whole file to the SAX parser as it is read. */
+static void
+load_push_handler (xmlParserCtxtPtr xml_context, gpointer user_data)
+{
+    XmlLoadData* load = static_cast<XmlLoadData*> (user_data);
+    const char* data;
+    size_t len;
+
+    while (load->ok)
+    {
+        if (!xml_load_input_read (load->input, data, len))
+            load->ok = FALSE;
+        else if (len == 0)
+            break;
+        else
+            xml_load_parse_chunk (load, xml_context, data, len);
+    }
+
+    if (xmlParseChunk (xml_context, "", 0, 1) != 0 || !xml_context->wellFormed)
+        load->ok = FALSE;
+}
+
+/* Read a gnc-v2 file in two stages: the book's transactions are cut out
+ * of the stream, inflated here if the file is compressed, and read on a
+ * thread pool without a DOM tree; and this thread gives everything else
+ * to the SAX parser and adds the transactions to the book where they
+ * were in the file.
+ *
+ * The book's accounts, commodities and lots come before its transactions,
+ * so each transaction's references can be looked up once the SAX parser
+ * has had everything before it.  Whitespace between transactions is
+ * dropped, which the book and top-level parsers ignore anyway. */
+static void
+parallel_load_push_handler (xmlParserCtxtPtr xml_context, gpointer user_data)
+{
+    XmlLoadData* load = static_cast<XmlLoadData*> (user_data);
+    GncXmlSplitter splitter (TRANSACTION_TAG,
+                             {GNC_V2_STRING,
+                              std::string (GNC_V2_STRING "/") + BOOK_TAG});
+    std::deque<std::unique_ptr<XmlLoadBatch>> batches;
+    std::unique_ptr<XmlLoadBatch> filling;
+    guint n_threads = g_get_num_processors ();
+    XmlLoadWork work;
+    GThreadPool* pool;
+    gboolean eof = FALSE;
+
+    g_mutex_init (&work.mutex);
+    g_cond_init (&work.cond);
+    pool = g_thread_pool_new (xml_load_batch_run, NULL, n_threads, FALSE,
+                              NULL);
+
+    while (load->ok && !eof)
+    {
+        const char* data;
+        size_t len;
+        GncXmlSplitter::Piece piece;
+
+        if (!xml_load_input_read (load->input, data, len))
+            load->ok = FALSE;
+        if (len > 0)
+        {
+            splitter.feed (data, len);
+        }
+        else
+        {
+            splitter.finish ();
+            eof = TRUE;
+        }
+
+        while (load->ok &&
+               (piece = splitter.next (data, len)) != GncXmlSplitter::Piece::NONE)
+        {
+            if (piece == GncXmlSplitter::Piece::ELEMENT)
+            {
+                if (!filling)
+                {
+                    filling.reset (new XmlLoadBatch);
+                    filling->work = &work;
+                    filling->done = FALSE;
+                }
+                filling->elements.emplace_back (data, len);
+                if (filling->elements.size () < XML_LOAD_BATCH)
+                    continue;
+
+                g_thread_pool_push (pool, filling.get (), NULL);
+                batches.push_back (std::move (filling));
+                /* Keep the pool busy without holding the whole file. */
+                while (batches.size () > 2 * n_threads)
+                {
+                    xml_load_batch_finish (load, xml_context,
+                                           batches.front ().get ());
+                    batches.pop_front ();
+                }
+                continue;
+            }
+
+            if ((filling || !batches.empty ()) && is_blank (data, len))
+                continue;
+
+            /* Everything before this has to be in the book first. */
+            if (filling)
+            {
+                g_thread_pool_push (pool, filling.get (), NULL);
+                batches.push_back (std::move (filling));
+            }
+            for (; !batches.empty (); batches.pop_front ())
+                xml_load_batch_finish (load, xml_context,
+                                       batches.front ().get ());
+            xml_load_parse_chunk (load, xml_context, data, len);
+        }
+    }
+
+    if (filling)
+    {
+        g_thread_pool_push (pool, filling.get (), NULL);
+        batches.push_back (std::move (filling));
+    }
+    for (; !batches.empty (); batches.pop_front ())
+        xml_load_batch_finish (load, xml_context, batches.front ().get ());
+
+    if (xmlParseChunk (xml_context, "", 0, 1) != 0 || !xml_context->wellFormed)
+        load->ok = FALSE;
+
+    g_thread_pool_free (pool, FALSE, TRUE);
+    g_cond_clear (&work.cond);
+    g_mutex_clear (&work.mutex);
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full (
     GncXmlBackend* xml_be, QofBook* book,
@@ -794,22 +1172,37 @@ qof_session_load_from_xml_file_v2_full (
          * https://bugs.gnucash.org/show_bug.cgi?id=712528 for more
          * info.
          */
-         const char* filename = xml_be->get_filename();
-        FILE* file;
-        gboolean is_compressed = is_gzipped_file (filename);
-        file = try_gz_open (filename, "r", is_compressed, FALSE);
-        if (file == NULL)
+        const char* filename = xml_be->get_filename();
+        XmlLoadInput input;
+        if (!xml_load_input_open (&input, filename))
         {
             PWARN ("Unable to open file %s", filename);
             retval = FALSE;
         }
         else
         {
-            retval = gnc_xml_parse_fd (top_parser, file,
-                                       generic_callback, gd, book);
-            fclose (file);
-            if (is_compressed)
-                wait_for_gzip (file);
+            gpointer parse_result = NULL;
+            gxpf_data gpdata;
+            XmlLoadData load;
+
+            gpdata.cb = generic_callback;
+            gpdata.parsedata = gd;
+            gpdata.bookdata = book;
+            load.input = &input;
+            load.gd = gd;
+            load.book = book;
+            load.ok = TRUE;
+
+            if (type == GNC_BOOK_XML2_FILE && g_get_num_processors () > 1)
+                retval = sixtp_parse_push (top_parser,
+                                           parallel_load_push_handler, &load,
+                                           NULL, &gpdata, &parse_result);
+            else
+                retval = sixtp_parse_push (top_parser, load_push_handler,
+                                           &load, NULL, &gpdata,
+                                           &parse_result);
+            retval = retval && load.ok;
+            xml_load_input_close (&input);
         }
     }
 
@@ -1057,10 +1450,10 @@ write_commodities (FILE* out, QofBook* book, sixtp_gdv2* gd)
         namespaces = g_list_sort (namespaces, compare_namespaces);
     }
 
+    GncXmlWriter writer (out);
     for (lp = namespaces; success && lp; lp = lp->next)
     {
         GList* comms, *lp2;
-        xmlNodePtr comnode;
 
         comms = gnc_commodity_table_get_commodities (tbl,
                                                      static_cast<const char*> (lp->data));
@@ -1068,19 +1461,17 @@ write_commodities (FILE* out, QofBook* book, sixtp_gdv2* gd)
 
         for (lp2 = comms; lp2; lp2 = lp2->next)
         {
-            comnode = gnc_commodity_dom_tree_create (static_cast<const gnc_commodity*>
-                                                     (lp2->data));
-            if (comnode == NULL)
+            if (!gnc_commodity_write_xml (writer, static_cast<const gnc_commodity*>
+                                          (lp2->data)))
                 continue;
 
-            xmlElemDump (out, NULL, comnode);
-            if (ferror (out) || fprintf (out, "\n") < 0)
+            writer.raw ("\n");
+            if (!writer.good ())
             {
                 success = FALSE;
                 break;
             }
 
-            xmlFreeNode (comnode);
             gd->counter.commodities_loaded++;
             sixtp_run_callback (gd, "commodities");
         }
@@ -1090,62 +1481,184 @@ write_commodities (FILE* out, QofBook* book, sixtp_gdv2* gd)
 
     if (namespaces) g_list_free (namespaces);
 
-    return success;
+    return writer.flush () && success;
 }
 
-static gboolean
-write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
+/* Transactions and prices are formatted in chunks of this many. */
+#define XML_CHUNK_TRANSACTIONS 256
+#define XML_CHUNK_PRICES 1024
+
+typedef std::function<void (GncXmlWriter&, size_t)> XmlItemWriter;
+
+typedef struct
 {
-    xmlNodePtr node;
-    xmlNodePtr parent;
-    xmlOutputBufferPtr outbuf;
+    const XmlItemWriter* write_item;
+    int level;
+    const char* indent;
+    GMutex mutex;
+    GCond cond;
+} XmlChunkWork;
 
-    parent = gnc_pricedb_dom_tree_create (gnc_pricedb_get_db (book));
+typedef struct
+{
+    XmlChunkWork* work;
+    size_t begin;
+    size_t end;
+    std::string text;
+    gboolean done;
+} XmlChunk;
 
-    if (!parent)
+static void
+xml_chunk_format (XmlChunk* chunk)
+{
+    XmlChunkWork* work = chunk->work;
+    GncXmlWriter writer (chunk->text, work->level);
+
+    for (size_t i = chunk->begin; i < chunk->end; ++i)
     {
-        return TRUE;
+        writer.raw (work->indent);
+        (*work->write_item) (writer, i);
+        writer.raw ("\n");
     }
+}
 
-    /* Write out the parent pricedb tag then loop to write out each price.
-       We do it this way instead of just calling xmlElemDump so that we can
-       increment the progress bar as we go. */
+static void
+xml_chunk_run (gpointer data, gpointer user_data)
+{
+    XmlChunk* chunk = static_cast<XmlChunk*> (data);
 
-    if (fprintf (out, "<%s version=\"%s\">\n", parent->name,
-                 xmlGetProp (parent, BAD_CAST "version")) < 0)
-        return FALSE;
+    xml_chunk_format (chunk);
+
+    g_mutex_lock (&chunk->work->mutex);
+    chunk->done = TRUE;
+    g_cond_broadcast (&chunk->work->cond);
+    g_mutex_unlock (&chunk->work->mutex);
+}
+
+/* Write n_items elements with write_item, each after indent and followed
+ * by a newline, as xmlElemDump at the given level would.
+ *
+ * The elements are formatted in chunks on a thread pool, each into its
+ * own buffer, a window of chunks at a time; the chunks come out in order,
+ * so the file is the same as a serial write would make.  The workers read
+ * the engine, and the progress callback may run the GUI's main loop, whose
+ * handlers could change it, so the callback is only run once every chunk
+ * of a window has been formatted and before the next window is started.
+ * Writing a window out overlaps with formatting the next. */
+static gboolean
+write_items_in_chunks (FILE* out, size_t n_items, size_t chunk_size,
+                       int level, const char* indent,
+                       const XmlItemWriter& write_item,
+                       sixtp_gdv2* gd, int* loaded, const char* type)
+{
+    XmlChunkWork work;
+    std::vector<XmlChunk> chunks;
+    GThreadPool* pool = NULL;
+    guint n_threads = g_get_num_processors ();
+    size_t window = 1;
+    gboolean success = TRUE;
+
+    work.write_item = &write_item;
+    work.level = level;
+    work.indent = indent;
+    g_mutex_init (&work.mutex);
+    g_cond_init (&work.cond);
 
-    /* We create our own output buffer so we can call xmlNodeDumpOutput to get
-       the indentation correct. */
-    outbuf = xmlOutputBufferCreateFile (out, NULL);
-    if (outbuf == NULL)
+    for (size_t begin = 0; begin < n_items; begin += chunk_size)
+        chunks.push_back ({&work, begin, MIN (begin + chunk_size, n_items),
+                           std::string (), FALSE});
+
+    if (n_threads > 1 && chunks.size () > 1)
     {
-        xmlFreeNode (parent);
-        return FALSE;
+        pool = g_thread_pool_new (xml_chunk_run, NULL, n_threads, FALSE, NULL);
+        window = 2 * n_threads;
+        for (size_t i = 0; i < MIN (window, chunks.size ()); ++i)
+            g_thread_pool_push (pool, &chunks[i], NULL);
     }
 
-    for (node = parent->children; node; node = node->next)
+    for (size_t first = 0; first < chunks.size (); first += window)
     {
-        /* Write two spaces since xmlNodeDumpOutput doesn't indent the first line */
-        xmlOutputBufferWrite (outbuf, 2, "  ");
-        xmlNodeDumpOutput (outbuf, NULL, node, 1, 1, NULL);
-        /* It also doesn't terminate the last line */
-        xmlOutputBufferWrite (outbuf, 1, "\n");
-        if (ferror (out))
+        size_t last = MIN (first + window, chunks.size ());
+
+        if (pool)
+        {
+            g_mutex_lock (&work.mutex);
+            for (size_t i = first; i < last; ++i)
+                while (!chunks[i].done)
+                    g_cond_wait (&work.cond, &work.mutex);
+            g_mutex_unlock (&work.mutex);
+        }
+        else
+        {
+            for (size_t i = first; i < last; ++i)
+                xml_chunk_format (&chunks[i]);
+        }
+
+        /* No chunk is being formatted now. */
+        *loaded += chunks[last - 1].end - chunks[first].begin;
+        sixtp_run_callback (gd, type);
+
+        if (pool)
+            for (size_t i = last; i < MIN (last + window, chunks.size ()); ++i)
+                g_thread_pool_push (pool, &chunks[i], NULL);
+
+        for (size_t i = first; success && i < last; ++i)
+        {
+            auto& chunk = chunks[i];
+            if (fwrite (chunk.text.data (), 1, chunk.text.size (), out)
+                != chunk.text.size () || ferror (out))
+                success = FALSE;
+            std::string ().swap (chunk.text);
+        }
+        if (!success)
             break;
-        gd->counter.prices_loaded += 1;
-        sixtp_run_callback (gd, "prices");
     }
 
-    xmlOutputBufferClose (outbuf);
+    /* On an error, drop the chunks that haven't been started. */
+    if (pool)
+        g_thread_pool_free (pool, TRUE, TRUE);
+    g_cond_clear (&work.cond);
+    g_mutex_clear (&work.mutex);
+    return success;
+}
 
-    if (ferror (out) || fprintf (out, "</%s>\n", parent->name) < 0)
-    {
-        xmlFreeNode (parent);
+static gboolean
+collect_price (GNCPrice* p, gpointer data)
+{
+    if (p)
+        static_cast<std::vector<GNCPrice*>*> (data)->push_back (p);
+    return TRUE;
+}
+
+static gboolean
+write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
+{
+    GNCPriceDB* db = gnc_pricedb_get_db (book);
+    std::vector<GNCPrice*> prices;
+
+    /* gnc_pricedb_dom_tree_create writes nothing at all if any price is
+       bad, so check them all before starting. */
+    if (!gnc_pricedb_is_writable (db))
+        return TRUE;
+
+    gnc_pricedb_foreach_price (db, collect_price, &prices, TRUE);
+
+    /* Write out the parent pricedb tag, then the prices indented as
+       xmlElemDump would have indented them inside it. */
+    if (fprintf (out, "<gnc:pricedb version=\"1\">\n") < 0)
+        return FALSE;
+
+    if (!write_items_in_chunks (out, prices.size (), XML_CHUNK_PRICES, 1, "  ",
+                                [&prices] (GncXmlWriter & writer, size_t i)
+                                {
+                                    gnc_price_write_xml (writer, prices[i]);
+                                },
+                                gd, &gd->counter.prices_loaded, "prices"))
+        return FALSE;
+
+    if (fprintf (out, "</gnc:pricedb>\n") < 0)
         return FALSE;
-    }
 
-    xmlFreeNode (parent);
     return TRUE;
 }
 
@@ -1153,14 +1666,10 @@ static int
 xml_add_trn_data (Transaction* t, gpointer data)
 {
     struct file_backend* be_data = static_cast<decltype (be_data)> (data);
-    xmlNodePtr node;
-
-    node = gnc_transaction_dom_tree_create (t);
 
-    xmlElemDump (be_data->out, NULL, node);
-    xmlFreeNode (node);
-
-    if (ferror (be_data->out) || fprintf (be_data->out, "\n") < 0)
+    gnc_transaction_write_xml (*be_data->writer, t);
+    be_data->writer->raw ("\n");
+    if (!be_data->writer->good ())
         return -1;
 
     be_data->gd->counter.transactions_loaded++;
@@ -1168,17 +1677,30 @@ xml_add_trn_data (Transaction* t, gpointer data)
     return 0;
 }
 
+static int
+collect_transaction (Transaction* t, gpointer data)
+{
+    static_cast<std::vector<Transaction*>*> (data)->push_back (t);
+    return 0;
+}
+
 static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
-    struct file_backend be_data;
-
-    be_data.out = out;
-    be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
-                                              xml_add_trn_data,
-                                              (gpointer) &be_data);
+    std::vector<Transaction*> transactions;
+
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       collect_transaction, &transactions);
+    return write_items_in_chunks (out, transactions.size (),
+                                  XML_CHUNK_TRANSACTIONS, 0, "",
+                                  [&transactions] (GncXmlWriter & writer,
+                                                   size_t i)
+                                  {
+                                      gnc_transaction_write_xml (writer,
+                                                                 transactions[i]);
+                                  },
+                                  gd, &gd->counter.transactions_loaded,
+                                  "transaction");
 }
 
 static gboolean
@@ -1193,9 +1715,12 @@ write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
     ra = gnc_book_get_template_root (book);
     if (gnc_account_n_descendants (ra) > 0)
     {
+        GncXmlWriter writer (out);
+        be_data.writer = &writer;
         if (fprintf (out, "<%s>\n", TEMPLATE_TRANSACTION_TAG) < 0
             || !write_account_tree (out, ra, gd)
             || xaccAccountTreeForEachTransaction (ra, xml_add_trn_data, (gpointer)&be_data)
+            || !writer.flush ()
             || fprintf (out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
 
             return FALSE;
@@ -1270,13 +1795,11 @@ write_namespace (const GncXmlDataType_t& data, FILE* out)
         (data.ns)(out);
 }
 
+/* The namespace declarations of the top-level element. */
 static gboolean
-write_v2_header (FILE* out)
+write_namespace_decls (FILE* out)
 {
-    if (fprintf (out, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n") < 0
-        || fprintf (out, "<" GNC_V2_STRING) < 0
-
-        || !gnc_xml2_write_namespace_decl (out, "gnc")
+    if (!gnc_xml2_write_namespace_decl (out, "gnc")
         || !gnc_xml2_write_namespace_decl (out, "act")
         || !gnc_xml2_write_namespace_decl (out, "book")
         || !gnc_xml2_write_namespace_decl (out, "cd")
@@ -1298,7 +1821,16 @@ write_v2_header (FILE* out)
     for (auto data : backend_registry)
         write_namespace(data, out);
 
-    if (ferror (out) || fprintf (out, ">\n") < 0)
+    return !ferror (out);
+}
+
+static gboolean
+write_v2_header (FILE* out)
+{
+    if (fprintf (out, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n") < 0
+        || fprintf (out, "<" GNC_V2_STRING) < 0
+        || !write_namespace_decls (out)
+        || fprintf (out, ">\n") < 0)
         return FALSE;
 
     return TRUE;
@@ -1379,19 +1911,184 @@ gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* qof_be, QofBook* book,
     return success;
 }
 
-#define BUFLEN 4096
+/* The size of the reads and writes on either side of the pipe to and from
+ * the gzip thread, and of the pipe's stdio buffer. */
+#define BUFLEN (64 * 1024)
+
+/* When compressing on a machine with several cores, the data is cut into
+ * blocks of this size and each is compressed on a thread pool into a gzip
+ * member of its own.  The members are written in order; gzread, like
+ * gunzip, reads a file of several members as if it were one. */
+#define GZ_BLOCK_SIZE (1024 * 1024)
+
+typedef struct
+{
+    GMutex mutex;
+    GCond cond;
+    gint level;
+} GzBlocks;
+
+typedef struct
+{
+    GzBlocks* blocks;
+    std::string in;
+    std::vector<Bytef> out;
+    gboolean done;
+    gboolean ok;
+} GzBlock;
+
+static void
+gz_compress_block (gpointer data, gpointer user_data)
+{
+    GzBlock* block = static_cast<GzBlock*> (data);
+    z_stream zs;
+
+    memset (&zs, 0, sizeof (zs));
+    /* Adding 16 to the window bits asks for a gzip header and trailer. */
+    if (deflateInit2 (&zs, block->blocks->level, Z_DEFLATED, 16 + MAX_WBITS,
+                      8, Z_DEFAULT_STRATEGY) == Z_OK)
+    {
+        /* Older zlibs leave the gzip header out of deflateBound. */
+        block->out.resize (deflateBound (&zs, block->in.size ()) + 32);
+        zs.next_in = reinterpret_cast<Bytef*> (&block->in[0]);
+        zs.avail_in = block->in.size ();
+        zs.next_out = block->out.data ();
+        zs.avail_out = block->out.size ();
+        block->ok = deflate (&zs, Z_FINISH) == Z_STREAM_END;
+        block->out.resize (zs.total_out);
+        deflateEnd (&zs);
+    }
+    std::string ().swap (block->in);
+
+    g_mutex_lock (&block->blocks->mutex);
+    block->done = TRUE;
+    g_cond_broadcast (&block->blocks->cond);
+    g_mutex_unlock (&block->blocks->mutex);
+}
+
+/* Read everything from params->fd and write it compressed to
+ * params->filename, a few blocks at a time on a thread pool.
+ * Returns 1 on success or 0 otherwise. */
+static gint
+gz_compress_parallel (gz_thread_params_t* params)
+{
+    GzBlocks blocks;
+    std::deque<std::unique_ptr<GzBlock>> pending;
+    guint n_threads = g_get_num_processors ();
+    GThreadPool* pool;
+    FILE* file;
+    gboolean eof = FALSE, any = FALSE;
+    gint success = 1;
+
+    file = g_fopen (params->filename, "wb");
+    if (!file)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                   params->filename, g_strerror (errno) ? g_strerror (errno) : "",
+                   errno);
+        return 0;
+    }
+
+    g_mutex_init (&blocks.mutex);
+    g_cond_init (&blocks.cond);
+    blocks.level = params->level;
+    pool = g_thread_pool_new (gz_compress_block, NULL, n_threads, FALSE, NULL);
+
+    while (success && !(eof && pending.empty ()))
+    {
+        if (!eof && pending.size () < 2 * n_threads)
+        {
+            std::unique_ptr<GzBlock> block (new GzBlock {&blocks, {}, {},
+                                                         FALSE, FALSE});
+            size_t filled = 0;
+
+            block->in.resize (GZ_BLOCK_SIZE);
+            while (filled < GZ_BLOCK_SIZE)
+            {
+                gssize bytes = read (params->fd, &block->in[filled],
+                                     GZ_BLOCK_SIZE - filled);
+                if (bytes > 0)
+                {
+                    filled += bytes;
+                }
+                else if (bytes == 0)
+                {
+                    eof = TRUE;
+                    break;
+                }
+                else
+                {
+                    g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                               g_strerror (errno) ? g_strerror (errno) : "", errno);
+                    success = 0;
+                    break;
+                }
+            }
+            block->in.resize (filled);
+
+            /* Even an empty file gets a gzip header. */
+            if (filled > 0 || !any)
+            {
+                g_thread_pool_push (pool, block.get (), NULL);
+                pending.push_back (std::move (block));
+                any = TRUE;
+            }
+            continue;
+        }
+
+        GzBlock* block = pending.front ().get ();
+        g_mutex_lock (&blocks.mutex);
+        while (!block->done)
+            g_cond_wait (&blocks.cond, &blocks.mutex);
+        g_mutex_unlock (&blocks.mutex);
+
+        if (!block->ok)
+        {
+            g_warning ("Could not compress the data for '%s'", params->filename);
+            success = 0;
+        }
+        else if (fwrite (block->out.data (), 1, block->out.size (), file)
+                 != block->out.size ())
+        {
+            g_warning ("Could not write the compressed file '%s'. The error is '%s' (errno %d)",
+                       params->filename, g_strerror (errno) ? g_strerror (errno) : "",
+                       errno);
+            success = 0;
+        }
+        pending.pop_front ();
+    }
+
+    /* The blocks still pending must outlive the threads using them. */
+    g_thread_pool_free (pool, FALSE, TRUE);
+    g_cond_clear (&blocks.cond);
+    g_mutex_clear (&blocks.mutex);
+
+    if (fclose (file) != 0)
+    {
+        g_warning ("Could not close the compressed file '%s' (errno %d)",
+                   params->filename, errno);
+        success = 0;
+    }
+    return success;
+}
 
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
 gz_thread_func (gz_thread_params_t* params)
 {
-    gchar buffer[BUFLEN];
+    std::vector<gchar> buffer (BUFLEN);
     gssize bytes;
     gint gzval;
     gzFile file;
     gint success = 1;
 
+    if (params->compress && g_get_num_processors () > 1)
+    {
+        success = gz_compress_parallel (params);
+        goto cleanup_gz_thread_func;
+    }
+
 #ifdef G_OS_WIN32
     {
         gchar* conv_name = g_win32_locale_filename_from_utf8 (params->filename);
@@ -1427,12 +2124,16 @@ gz_thread_func (gz_thread_params_t* params)
 
     if (params->compress)
     {
+        if (gzsetparams (file, params->level, Z_DEFAULT_STRATEGY) != Z_OK)
+            g_warning ("Could not set the compression level of '%s'",
+                       params->filename);
+
         while (success)
         {
-            bytes = read (params->fd, buffer, BUFLEN);
+            bytes = read (params->fd, buffer.data (), BUFLEN);
             if (bytes > 0)
             {
-                if (gzwrite (file, buffer, bytes) <= 0)
+                if (gzwrite (file, buffer.data (), bytes) <= 0)
                 {
                     gint errnum;
                     const gchar* error = gzerror (file, &errnum);
@@ -1457,7 +2158,7 @@ gz_thread_func (gz_thread_params_t* params)
     {
         while (success)
         {
-            gzval = gzread (file, buffer, BUFLEN);
+            gzval = gzread (file, buffer.data (), BUFLEN);
             if (gzval > 0)
             {
                 if (
@@ -1466,7 +2167,7 @@ gz_thread_func (gz_thread_params_t* params)
 #else
                     write
 #endif
-                    (params->fd, buffer, gzval) < 0)
+                    (params->fd, buffer.data (), gzval) < 0)
                 {
                     g_warning ("Could not write to pipe. The error is '%s' (%d)",
                                g_strerror (errno) ? g_strerror (errno) : "", errno);
@@ -1506,7 +2207,7 @@ cleanup_gz_thread_func:
 
 static FILE*
 try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
-             gboolean compress)
+             gboolean compress, gint level)
 {
     if (strstr (filename, ".gz.") != NULL) /* its got a temp extension */
         use_gzip = TRUE;
@@ -1536,6 +2237,10 @@ try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
         params->filename = g_strdup (filename);
         params->perms = g_strdup (perms);
         params->compress = compress;
+        params->level = level;
+        if (params->level < Z_DEFAULT_COMPRESSION ||
+            params->level > Z_BEST_COMPRESSION)
+            params->level = Z_DEFAULT_COMPRESSION;
 
         thread = g_thread_new ("xml_thread", (GThreadFunc) gz_thread_func,
                                params);
@@ -1555,6 +2260,8 @@ try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
             file = fdopen (filedes[1], "w");
         else
             file = fdopen (filedes[0], "r");
+        if (file)
+            setvbuf (file, NULL, _IOFBF, BUFLEN);
 
         G_LOCK (threads);
         if (!threads)
@@ -1592,12 +2299,13 @@ gboolean
 gnc_book_write_to_xml_file_v2 (
     QofBook* book,
     const char* filename,
-    gboolean compress)
+    gboolean compress,
+    gint level)
 {
     FILE* out;
     gboolean success = TRUE;
 
-    out = try_gz_open (filename, "w", compress, TRUE);
+    out = try_gz_open (filename, "w", compress, TRUE, level);
 
     /* Try to write as much as possible */
     if (!out
@@ -1651,6 +2359,294 @@ gnc_book_write_accounts_to_xml_file_v2 (QofBackend* qof_be, QofBook* book,
     return success;
 }
 
+/***********************************************************************/
+/* The journal holds the transactions saved since the book file was last
+ * written, so that a save needn't rewrite the whole book.  It starts with
+ * a header naming the book file it goes with by its stamp, then has one
+ * gnc:journal-entry per save with the transactions changed since the save
+ * before and the ids of those deleted.  Replaying the entries in order
+ * over the book file gives the book as it was last saved.
+ */
+
+#define JOURNAL_TAG "gnc-journal"
+#define JOURNAL_ENTRY_TAG "gnc:journal-entry"
+#define JOURNAL_DELETED_TAG "gnc:transaction-deleted"
+#define JOURNAL_ENTRY_END "</" JOURNAL_ENTRY_TAG ">\n"
+
+static std::string
+journal_header (const char* stamp)
+{
+    return std::string ("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+                        "<" JOURNAL_TAG " version=\"1\" book=\"") +
+           stamp + "\"";
+}
+
+/* Whether replacing trn on replay changes nothing but trn.  A read-only
+ * transaction can't be destroyed, one with splits in lots or capital gains
+ * takes other objects with it, and template transactions belong to their
+ * scheduled transactions. */
+static gboolean
+journal_can_hold (Transaction* trn, QofBook* book)
+{
+    auto root = gnc_book_get_root_account (book);
+
+    if (xaccTransGetReadOnly (trn))
+        return FALSE;
+
+    for (auto node = xaccTransGetSplitList (trn); node; node = node->next)
+    {
+        auto split = static_cast<Split*> (node->data);
+        auto account = xaccSplitGetAccount (split);
+
+        if (xaccSplitGetLot (split)
+            || xaccSplitGetCapGainsSplit (split)
+            || xaccSplitGetGainsSourceSplit (split)
+            || !account || gnc_account_get_root (account) != root)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Whether the journal in f is for the book file with the given stamp and
+ * ends with a whole entry, so that another can follow it. */
+static gboolean
+journal_can_append (FILE* f, const std::string& header)
+{
+    static const size_t end_len = strlen (JOURNAL_ENTRY_END);
+    std::vector<char> buf (std::max (header.size (), end_len));
+
+    rewind (f);
+    if (fread (buf.data (), 1, header.size (), f) != header.size ()
+        || header.compare (0, header.size (), buf.data (), header.size ()))
+        return FALSE;
+
+    if (fseek (f, -(long)end_len, SEEK_END)
+        || fread (buf.data (), 1, end_len, f) != end_len
+        || strncmp (buf.data (), JOURNAL_ENTRY_END, end_len))
+        return FALSE;
+
+    return TRUE;
+}
+
+gboolean
+gnc_book_append_to_xml_journal_v2 (QofBook* book, const char* filename,
+                                   const char* stamp,
+                                   const std::vector<GncGUID>& transactions)
+{
+    auto header = journal_header (stamp);
+    std::string entry;
+    {
+        GncXmlWriter writer (entry);
+
+        writer.start (JOURNAL_ENTRY_TAG);
+        for (const auto& guid : transactions)
+        {
+            auto trn = xaccTransLookup (&guid, book);
+
+            if (trn && !qof_instance_get_destroying (trn))
+            {
+                if (!journal_can_hold (trn, book))
+                    return FALSE;
+                gnc_transaction_write_xml (writer, trn);
+            }
+            else
+            {
+                writer.start (JOURNAL_DELETED_TAG);
+                writer.guid_element ("trn:id", &guid);
+                writer.end ();
+            }
+        }
+        writer.end ();
+        writer.raw ("\n");
+    }
+
+    auto out = g_fopen (filename, "a+b");
+    if (!out)
+        return FALSE;
+
+    gboolean success = TRUE;
+    if (fseek (out, 0, SEEK_END) || ftell (out) < 0)
+        success = FALSE;
+    else if (ftell (out) == 0)
+        success = fputs (header.c_str (), out) >= 0
+                  && write_namespace_decls (out)
+                  && fputs (">\n", out) >= 0;
+    else if (!journal_can_append (out, header)
+             || fseek (out, 0, SEEK_END))
+        success = FALSE;
+
+    if (success
+        && fwrite (entry.data (), 1, entry.size (), out) != entry.size ())
+        success = FALSE;
+
+    if (fclose (out))
+        success = FALSE;
+
+    return success;
+}
+
+/* Destroy the transaction with the id in tree's trn:id, if there is one,
+ * so that a record from the journal can take its place. */
+static gboolean
+journal_remove_transaction (xmlNodePtr tree, QofBook* book)
+{
+    for (auto node = tree->xmlChildrenNode; node; node = node->next)
+    {
+        if (g_strcmp0 ((char*)node->name, "trn:id") != 0)
+            continue;
+
+        auto guid = dom_tree_to_guid (node);
+        g_return_val_if_fail (guid, FALSE);
+        auto trn = xaccTransLookup (guid, book);
+        g_free (guid);
+
+        if (!trn)
+            return TRUE;
+        if (!journal_can_hold (trn, book))
+        {
+            PWARN ("The journal replaces a transaction it can't");
+            return FALSE;
+        }
+        xaccTransBeginEdit (trn);
+        xaccTransDestroy (trn);
+        xaccTransCommitEdit (trn);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean
+journal_transaction_end_handler (gpointer data_for_children,
+                                 GSList* data_from_children,
+                                 GSList* sibling_data,
+                                 gpointer parent_data, gpointer global_data,
+                                 gpointer* result, const gchar* tag)
+{
+    Transaction* trn = NULL;
+    xmlNodePtr tree = (xmlNodePtr)data_for_children;
+    gxpf_data* gdata = (gxpf_data*)global_data;
+    auto book = static_cast<QofBook*> (gdata->bookdata);
+
+    if (parent_data)
+        return TRUE;
+
+    if (!tag)
+        return TRUE;
+
+    g_return_val_if_fail (tree, FALSE);
+
+    if (journal_remove_transaction (tree, book))
+        trn = dom_tree_to_transaction (tree, book);
+    if (trn != NULL)
+        gdata->cb (tag, gdata->parsedata, trn);
+
+    xmlFreeNode (tree);
+
+    return trn != NULL;
+}
+
+static gboolean
+journal_deleted_end_handler (gpointer data_for_children,
+                             GSList* data_from_children, GSList* sibling_data,
+                             gpointer parent_data, gpointer global_data,
+                             gpointer* result, const gchar* tag)
+{
+    xmlNodePtr tree = (xmlNodePtr)data_for_children;
+    gxpf_data* gdata = (gxpf_data*)global_data;
+
+    if (parent_data)
+        return TRUE;
+
+    if (!tag)
+        return TRUE;
+
+    g_return_val_if_fail (tree, FALSE);
+
+    auto ok = journal_remove_transaction (
+                  tree, static_cast<QofBook*> (gdata->bookdata));
+
+    xmlFreeNode (tree);
+
+    return ok;
+}
+
+static sixtp*
+journal_parser_new (void)
+{
+    auto entry_parser = sixtp_add_some_sub_parsers (
+        sixtp_new (), TRUE,
+        TRANSACTION_TAG,
+        sixtp_dom_parser_new (journal_transaction_end_handler, NULL, NULL),
+        JOURNAL_DELETED_TAG,
+        sixtp_dom_parser_new (journal_deleted_end_handler, NULL, NULL),
+        NULL, NULL);
+    if (!entry_parser)
+        return NULL;
+
+    auto journal_parser = sixtp_add_some_sub_parsers (
+        sixtp_new (), TRUE, JOURNAL_ENTRY_TAG, entry_parser, NULL, NULL);
+    if (!journal_parser)
+        return NULL;
+
+    return sixtp_add_some_sub_parsers (
+        sixtp_new (), TRUE, JOURNAL_TAG, journal_parser, NULL, NULL);
+}
+
+gboolean
+gnc_book_replay_xml_journal_v2 (QofBook* book, const char* filename,
+                                const char* stamp)
+{
+    gchar* contents = NULL;
+    gsize length = 0;
+
+    if (!g_file_get_contents (filename, &contents, &length, NULL))
+        return FALSE;
+    std::string journal (contents, length);
+    g_free (contents);
+
+    auto header = journal_header (stamp);
+    if (journal.compare (0, header.size (), header) != 0)
+    {
+        PWARN ("Ignoring %s, which was written for another book file",
+               filename);
+        return TRUE;
+    }
+
+    /* Only whole entries were saved: the end of the last one may have been
+     * cut off by a crash while it was being written. */
+    auto end = journal.rfind (JOURNAL_ENTRY_END);
+    if (end == std::string::npos)
+        return TRUE;
+    journal.resize (end + strlen (JOURNAL_ENTRY_END));
+    journal += "</" JOURNAL_TAG ">\n";
+
+    auto parser = journal_parser_new ();
+    if (!parser)
+        return FALSE;
+
+    auto gd = gnc_sixtp_gdv2_new (book, FALSE, NULL, NULL);
+    gxpf_data gpdata;
+    gpointer parse_result = NULL;
+
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+
+    xaccLogDisable ();
+    xaccDisableDataScrubbing ();
+    auto retval = sixtp_parse_buffer (parser, &journal[0], journal.size (),
+                                      NULL, &gpdata, &parse_result);
+    xaccEnableDataScrubbing ();
+    xaccLogEnable ();
+
+    sixtp_destroy (parser);
+    g_free (gd);
+
+    if (!retval)
+        PWARN ("Failed to replay %s", filename);
+    return retval;
+}
+
 /***********************************************************************/
 static gboolean
 is_gzipped_file (const gchar* name)
@@ -1681,39 +2677,37 @@ is_gzipped_file (const gchar* name)
 QofBookFileType
 gnc_is_xml_data_file_v2 (const gchar* name, gboolean* with_encoding)
 {
-    if (is_gzipped_file (name))
-    {
-        gzFile file = NULL;
-        char first_chunk[256];
-        int num_read;
+    /* gzread reads an uncompressed file as it is, so there is no need to
+     * open the file once more to see whether it is compressed. */
+    gzFile file = NULL;
+    char first_chunk[256];
+    int num_read;
 
 #ifdef G_OS_WIN32
+    {
+        gchar* conv_name = g_win32_locale_filename_from_utf8 (name);
+        if (!conv_name)
+            g_warning ("Could not convert '%s' to system codepage", name);
+        else
         {
-            gchar* conv_name = g_win32_locale_filename_from_utf8 (name);
-            if (!conv_name)
-                g_warning ("Could not convert '%s' to system codepage", name);
-            else
-            {
-                file = gzopen (conv_name, "rb");
-                g_free (conv_name);
-            }
+            file = gzopen (conv_name, "rb");
+            g_free (conv_name);
         }
+    }
 #else
-        file = gzopen (name, "r");
+    file = gzopen (name, "r");
 #endif
-        if (file == NULL)
-            return GNC_BOOK_NOT_OURS;
-
-        num_read = gzread (file, first_chunk, sizeof (first_chunk) - 1);
-        gzclose (file);
+    if (file == NULL)
+        return GNC_BOOK_NOT_OURS;
 
-        if (num_read < 1)
-            return GNC_BOOK_NOT_OURS;
+    num_read = gzread (file, first_chunk, sizeof (first_chunk) - 1);
+    gzclose (file);
 
-        return gnc_is_our_first_xml_chunk (first_chunk, with_encoding);
-    }
+    if (num_read < 1)
+        return GNC_BOOK_NOT_OURS;
 
-    return (gnc_is_our_xml_file (name, with_encoding));
+    first_chunk[num_read] = '\0';
+    return gnc_is_our_first_xml_chunk (first_chunk, with_encoding);
 }
 
 
@@ -1811,7 +2805,8 @@ gnc_xml2_find_ambiguous (const gchar* filename, GList* encodings,
     gboolean clean_return = FALSE;
 
     is_compressed = is_gzipped_file (filename);
-    file = try_gz_open (filename, "r", is_compressed, FALSE);
+    file = try_gz_open (filename, "r", is_compressed, FALSE,
+                        Z_DEFAULT_COMPRESSION);
     if (file == NULL)
     {
         PWARN ("Unable to open file %s", filename);
@@ -2020,7 +3015,8 @@ parse_with_subst_push_handler (xmlParserCtxtPtr xml_context,
 
     filename = push_data->filename;
     is_compressed = is_gzipped_file (filename);
-    file = try_gz_open (filename, "r", is_compressed, FALSE);
+    file = try_gz_open (filename, "r", is_compressed, FALSE,
+                        Z_DEFAULT_COMPRESSION);
     if (file == NULL)
     {
         PWARN ("Unable to open file %s", filename);
@@ -90,8 +90,30 @@ gboolean qof_session_load_from_xml_file_v2 (GncXmlBackend*, QofBook*,
 
 /* write all book info to a file */
 gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
+/** The level is zlib's compression level, used if compress is TRUE. */
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
-                                        gboolean compress);
+                                        gboolean compress, gint level);
+
+/** Append an entry with the given transactions, or a deletion record for
+ * those no longer in the book, to the journal kept beside a book file.
+ * The stamp identifies the book file as it is on disk; a new journal is
+ * started for it if there isn't one.
+ *
+ * @return FALSE if the journal is for another book file or damaged, if a
+ * transaction can't be replaced from the journal on its own, or if it
+ * couldn't be written; the book must be written in full then.
+ */
+gboolean gnc_book_append_to_xml_journal_v2 (
+    QofBook* book, const char* filename, const char* stamp,
+    const std::vector<GncGUID>& transactions);
+/** Apply the entries of the journal to a book just loaded from the book
+ * file with the given stamp.  A journal written for another book file is
+ * ignored, as is an entry cut short by a crash.
+ *
+ * @return FALSE if the journal couldn't be read or replayed.
+ */
+gboolean gnc_book_replay_xml_journal_v2 (QofBook* book, const char* filename,
+                                         const char* stamp);
 
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
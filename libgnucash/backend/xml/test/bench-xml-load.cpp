@@ -0,0 +1,305 @@
+/********************************************************************
+ * bench-xml-load.cpp: Time saving and loading large XML books.     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/**
+ * @file bench-xml-load.cpp
+ * @brief Time the XML backend saving and loading random books.
+ *
+ * Usage: bench-xml-load [TRANSACTIONS...]
+ *
+ * For each book size (by default 10000 and 100000 transactions) a random
+ * book is built with the test-engine-stuff generators, saved through a
+ * session to a scratch directory uncompressed, compressed and compressed
+ * at the fastest level as an auto-save is.  One transaction is then
+ * changed and saved to the journal, as an auto-save after an edit is when
+ * journaling is on, and each file is loaded back in a new session.  Every
+ * result is printed to stdout as one JSON object per line, with the wall
+ * clock time and the CPU time of all threads, e.g.
+ *
+ *   {"benchmark": "load (compressed)", "transactions": 10000,
+ *    "bytes": 2751342, "seconds": 0.412113, "cpu_seconds": 0.901245}
+ *
+ * so that runs from different commits can be compared with a script.
+ * The random seed is fixed, so a given size always gets the same book.
+ */
+
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+
+#include "qof.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "TransLog.h"
+#include "cashobjects.h"
+#include "gnc-engine.h"
+#include "gnc-prefs.h"
+#include "test-stuff.h"
+#include "test-engine-stuff.h"
+}
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#define GNC_LIB_NAME "gncmod-backend-xml"
+#define GNC_LIB_REL_PATH "xml"
+
+using Clock = std::chrono::steady_clock;
+
+static const guint default_sizes[] = {10000, 100000};
+
+/* How a book is saved: the file name, whether it is compressed and at
+ * what zlib level. */
+struct SaveMode
+{
+    const char* name;
+    const char* filename;
+    gboolean compressed;
+    gint level;
+};
+
+static const SaveMode save_modes[] =
+{
+    {"", "book.gnucash", FALSE, -1},
+    {" (compressed)", "book.gnucash.gz", TRUE, -1},
+    {" (compressed fast)", "book-fast.gnucash.gz", TRUE, 1},
+};
+
+/* The wall clock time and the CPU time of the whole process, which
+ * includes the gzip and thread pool threads, between start() and stop(). */
+class Timer
+{
+public:
+    void start ()
+    {
+        m_wall = Clock::now ();
+        m_cpu = std::clock ();
+    }
+    void stop ()
+    {
+        seconds = std::chrono::duration<double> (Clock::now () - m_wall).count ();
+        cpu_seconds = double (std::clock () - m_cpu) / CLOCKS_PER_SEC;
+    }
+
+    double seconds = 0;
+    double cpu_seconds = 0;
+
+private:
+    Clock::time_point m_wall;
+    std::clock_t m_cpu = 0;
+};
+
+static void
+report (const char* what, const SaveMode& mode, guint transactions,
+        gint64 bytes, const Timer& timer)
+{
+    printf ("{\"benchmark\": \"%s%s\", \"transactions\": %u, "
+            "\"bytes\": %" G_GINT64_FORMAT ", \"seconds\": %.6f, "
+            "\"cpu_seconds\": %.6f}\n",
+            what, mode.name, transactions, bytes, timer.seconds,
+            timer.cpu_seconds);
+    fflush (stdout);
+}
+
+static gint64
+file_size (const char* filename)
+{
+    GStatBuf buf;
+    return g_stat (filename, &buf) == 0 ? buf.st_size : -1;
+}
+
+static bool
+session_ok (QofSession* session, const char* what)
+{
+    auto err = qof_session_get_error (session);
+
+    if (err == ERR_BACKEND_NO_ERR)
+        return true;
+    fprintf (stderr, "%s failed: error %d\n", what, err);
+    return false;
+}
+
+/* A random book of at least num_transactions transactions in a session
+ * on uri. */
+static QofSession*
+make_session (const char* uri, guint num_transactions)
+{
+    auto session = qof_session_new ();
+    auto book = qof_session_get_book (session);
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+
+    qof_session_begin (session, uri, TRUE, TRUE, TRUE);
+    if (!session_ok (session, "qof_session_begin"))
+    {
+        qof_session_destroy (session);
+        return NULL;
+    }
+
+    /* Random transactions need at least two accounts to go between. */
+    while (gnc_account_n_descendants (gnc_book_get_root_account (book)) < 2)
+        get_random_account_tree (book);
+    while (qof_collection_count (transactions) < num_transactions)
+        add_random_transactions_to_book (book, 100);
+    return session;
+}
+
+static void
+find_transaction (QofInstance* inst, gpointer data)
+{
+    *static_cast<Transaction**> (data) = GNC_TRANSACTION (inst);
+}
+
+/* Change one transaction, as editing it in a register does. */
+static void
+change_a_transaction (QofBook* book)
+{
+    Transaction* trn = nullptr;
+
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            find_transaction, &trn);
+    if (!trn)
+        return;
+    xaccTransBeginEdit (trn);
+    xaccTransSetDescription (trn, "changed");
+    xaccTransCommitEdit (trn);
+}
+
+static void
+bench_file (const char* dir, guint num_transactions, const SaveMode& mode)
+{
+    auto filename = g_build_filename (dir, mode.filename, NULL);
+    auto journal = g_strconcat (filename, ".journal", NULL);
+    auto uri = g_strconcat ("xml://", filename, NULL);
+    auto session = make_session (uri, num_transactions);
+    Timer timer;
+
+    if (session)
+    {
+        gnc_prefs_set_file_save_compressed (mode.compressed);
+        gnc_prefs_set_file_compression_level (mode.level);
+        timer.start ();
+        qof_session_save (session, NULL);
+        timer.stop ();
+        if (session_ok (session, "qof_session_save"))
+            report ("save", mode, num_transactions, file_size (filename),
+                    timer);
+
+        change_a_transaction (qof_session_get_book (session));
+        gnc_prefs_set_file_save_journal (TRUE);
+        timer.start ();
+        qof_session_save (session, NULL);
+        timer.stop ();
+        gnc_prefs_set_file_save_journal (FALSE);
+        if (session_ok (session, "qof_session_save"))
+            report ("save one change to journal", mode, num_transactions,
+                    file_size (journal), timer);
+        qof_session_end (session);
+        qof_session_destroy (session);
+
+        session = qof_session_new ();
+        qof_session_begin (session, uri, TRUE, FALSE, FALSE);
+        timer.start ();
+        qof_session_load (session, NULL);
+        timer.stop ();
+        if (session_ok (session, "qof_session_load"))
+        {
+            auto book = qof_session_get_book (session);
+            auto loaded = qof_collection_count (
+                              qof_book_get_collection (book, GNC_ID_TRANS));
+            report ("load", mode, loaded, file_size (filename), timer);
+        }
+        qof_session_end (session);
+        qof_session_destroy (session);
+    }
+
+    g_free (uri);
+    g_free (journal);
+    g_free (filename);
+}
+
+/* The session leaves backups and logs next to the file. */
+static void
+remove_dir (const char* dir)
+{
+    auto gdir = g_dir_open (dir, 0, NULL);
+
+    while (auto name = g_dir_read_name (gdir))
+    {
+        auto path = g_build_filename (dir, name, NULL);
+        g_remove (path);
+        g_free (path);
+    }
+    g_dir_close (gdir);
+    g_rmdir (dir);
+}
+
+int
+main (int argc, char** argv)
+{
+    std::vector<guint> sizes;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        guint64 size = g_ascii_strtoull (argv[i], NULL, 10);
+        if (size == 0 || size > G_MAXUINT)
+        {
+            fprintf (stderr, "Usage: %s [TRANSACTIONS...]\n", argv[0]);
+            return 1;
+        }
+        sizes.push_back (size);
+    }
+    if (sizes.empty ())
+        sizes.assign (std::begin (default_sizes), std::end (default_sizes));
+
+    g_setenv ("GNC_UNINSTALLED", "1", TRUE);
+    qof_init ();
+    if (!cashobjects_register () ||
+        !qof_load_backend_library (GNC_LIB_REL_PATH, GNC_LIB_NAME))
+        return 1;
+    xaccLogDisable ();
+
+    /* Keep the generated books small in everything but transactions. */
+    set_max_kvp_depth (1);
+    set_max_kvp_frame_elements (1);
+    set_max_account_tree_depth (3);
+    set_max_accounts_per_level (4);
+
+    for (auto size : sizes)
+    {
+        auto dir = g_dir_make_tmp ("bench-xml-load-XXXXXX", NULL);
+
+        for (const auto& mode : save_modes)
+        {
+            srand (0);
+            bench_file (dir, size, mode);
+        }
+        remove_dir (dir);
+        g_free (dir);
+    }
+
+    qof_close ();
+    return 0;
+}
@@ -41,12 +41,16 @@ extern "C"
 #include <glib/gstdio.h>
 
 #include <cashobjects.h>
+#include <Account.h>
+#include <Transaction.h>
 #include <TransLog.h>
 #include <gnc-engine.h>
 #include <gnc-prefs.h>
 
 #include <unittest-support.h>
 #include <test-engine-stuff.h>
+
+#include <zlib.h>
 }
 
 #include "../gnc-backend-xml.h"
@@ -118,6 +122,243 @@ test_load_file (const char* filename)
     qof_session_end (session);
 }
 
+static QofBackendError
+load_error (const char* filename, guint* n_accounts)
+{
+    QofSession* session = qof_session_new ();
+    QofBackendError err;
+
+    qof_session_begin (session, filename, TRUE, FALSE, TRUE);
+    qof_session_load (session, NULL);
+    err = qof_session_get_error (session);
+    *n_accounts = gnc_account_n_descendants (
+                      gnc_book_get_root_account (qof_session_get_book (session)));
+    qof_session_end (session);
+    qof_session_destroy (session);
+    return err;
+}
+
+/* The file compressed in two gzip members, as a parallel save writes it,
+ * must load as it is; cut short, it mustn't load at all. */
+static void
+test_load_compressed (const char* filename)
+{
+    gchar* contents, *compressed;
+    gsize length, half;
+    guint n_plain, n_compressed;
+    gchar* dir;
+    gzFile file;
+
+    if (!g_file_get_contents (filename, &contents, &length, NULL))
+    {
+        failure_args ("read xml2 file", __FILE__, __LINE__, "%s", filename);
+        return;
+    }
+    dir = g_dir_make_tmp ("test-load-xml2-XXXXXX", NULL);
+    compressed = g_build_filename (dir, "compressed.gml2", NULL);
+    half = length / 2;
+
+    file = gzopen (compressed, "wb");
+    gzwrite (file, contents, half);
+    gzclose (file);
+    file = gzopen (compressed, "ab");
+    gzwrite (file, contents + half, length - half);
+    gzclose (file);
+    g_free (contents);
+
+    load_error (filename, &n_plain);
+    do_test_args (load_error (compressed, &n_compressed) == ERR_BACKEND_NO_ERR
+                  && n_compressed == n_plain, "load gzip members",
+                  __FILE__, __LINE__, "for file [%s]", filename);
+
+    if (g_file_get_contents (compressed, &contents, &length, NULL))
+    {
+        g_file_set_contents (compressed, contents, length - 4, NULL);
+        g_free (contents);
+        do_test_args (load_error (compressed, &n_compressed)
+                      != ERR_BACKEND_NO_ERR, "load cut-short gzip file",
+                      __FILE__, __LINE__, "for file [%s]", filename);
+    }
+
+    {
+        GDir* gdir = g_dir_open (dir, 0, NULL);
+        while (const gchar* name = g_dir_read_name (gdir))
+        {
+            gchar* path = g_build_filename (dir, name, NULL);
+            g_remove (path);
+            g_free (path);
+        }
+        g_dir_close (gdir);
+    }
+    g_rmdir (dir);
+    g_free (compressed);
+    g_free (dir);
+}
+
+static Transaction*
+make_transaction (QofBook* book, Account* from, Account* to,
+                  const char* description, gint64 cents)
+{
+    Transaction* trn = xaccMallocTransaction (book);
+    Account* accounts[] = {from, to};
+
+    xaccTransBeginEdit (trn);
+    xaccTransSetCurrency (trn, xaccAccountGetCommodity (from));
+    xaccTransSetDatePostedSecsNormalized (trn, gnc_time (NULL));
+    xaccTransSetDescription (trn, description);
+    for (auto account : accounts)
+    {
+        Split* split = xaccMallocSplit (book);
+        gnc_numeric value = gnc_numeric_create (account == from ? -cents : cents,
+                                                100);
+
+        xaccSplitSetParent (split, trn);
+        xaccSplitSetAccount (split, account);
+        xaccSplitSetValue (split, value);
+        xaccSplitSetAmount (split, value);
+    }
+    xaccTransCommitEdit (trn);
+    return trn;
+}
+
+static QofSession*
+journal_session (const char* uri, gboolean create)
+{
+    QofSession* session = qof_session_new ();
+
+    qof_session_begin (session, uri, TRUE, create, create);
+    if (!create)
+        qof_session_load (session, NULL);
+    return session;
+}
+
+static const char*
+description_of (QofBook* book, const GncGUID* guid)
+{
+    Transaction* trn = xaccTransLookup (guid, book);
+    return trn ? xaccTransGetDescription (trn) : NULL;
+}
+
+/* Saving only transactions appends them to the journal, which loading
+ * replays; anything else makes the save write the book file again. */
+static void
+test_journal (void)
+{
+    gchar* dir = g_dir_make_tmp ("test-load-xml2-XXXXXX", NULL);
+    gchar* filename = g_build_filename (dir, "journal.gnucash", NULL);
+    gchar* uri = g_strconcat ("xml://", filename, NULL);
+    gchar* journal = g_strconcat (filename, ".journal", NULL);
+    GncGUID changed, deleted, added, account_guid;
+
+    QofSession* session = journal_session (uri, TRUE);
+    QofBook* book = qof_session_get_book (session);
+    Account* root = gnc_book_get_root_account (book);
+    gnc_commodity* usd = gnc_commodity_table_lookup (
+                             gnc_commodity_table_get_table (book),
+                             GNC_COMMODITY_NS_CURRENCY, "USD");
+    Account* accounts[2];
+
+    for (auto& account : accounts)
+    {
+        account = xaccMallocAccount (book);
+        xaccAccountBeginEdit (account);
+        xaccAccountSetName (account, &account == accounts ? "From" : "To");
+        xaccAccountSetType (account, ACCT_TYPE_BANK);
+        xaccAccountSetCommodity (account, usd);
+        gnc_account_append_child (root, account);
+        xaccAccountCommitEdit (account);
+    }
+    account_guid = *qof_entity_get_guid (accounts[0]);
+    Transaction* trn = make_transaction (book, accounts[0], accounts[1],
+                                         "before", 100);
+    changed = *qof_entity_get_guid (trn);
+    deleted = *qof_entity_get_guid (make_transaction (book, accounts[0],
+                                                      accounts[1], "deleted",
+                                                      200));
+    gnc_prefs_set_file_save_journal (TRUE);
+    qof_session_save (session, NULL);
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR
+             && !g_file_test (journal, G_FILE_TEST_EXISTS),
+             "first save writes the book file");
+
+    xaccTransBeginEdit (trn);
+    xaccTransSetDescription (trn, "after");
+    xaccTransCommitEdit (trn);
+    trn = xaccTransLookup (&deleted, book);
+    xaccTransBeginEdit (trn);
+    xaccTransDestroy (trn);
+    xaccTransCommitEdit (trn);
+    added = *qof_entity_get_guid (make_transaction (book, accounts[1],
+                                                    accounts[0], "added",
+                                                    300));
+    qof_session_save (session, NULL);
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR
+             && g_file_test (journal, G_FILE_TEST_EXISTS),
+             "saving transactions appends to the journal");
+    qof_session_end (session);
+    qof_session_destroy (session);
+
+    /* A crash while appending leaves part of an entry behind. */
+    FILE* f = g_fopen (journal, "ab");
+    if (f)
+    {
+        fputs ("<gnc:journal-entry>\n<gnc:transaction version=", f);
+        fclose (f);
+    }
+
+    session = journal_session (uri, FALSE);
+    book = qof_session_get_book (session);
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+             "load book file with journal");
+    do_test (g_strcmp0 (description_of (book, &changed), "after") == 0,
+             "journal replays a changed transaction");
+    do_test (xaccTransLookup (&deleted, book) == NULL,
+             "journal replays a deleted transaction");
+    do_test (g_strcmp0 (description_of (book, &added), "added") == 0
+             && xaccTransCountSplits (xaccTransLookup (&added, book)) == 2,
+             "journal replays an added transaction");
+
+    Account* account = xaccAccountLookup (&account_guid, book);
+    xaccAccountBeginEdit (account);
+    xaccAccountSetName (account, "Renamed");
+    xaccAccountCommitEdit (account);
+    qof_session_save (session, NULL);
+    do_test (qof_session_get_error (session) == ERR_BACKEND_NO_ERR
+             && !g_file_test (journal, G_FILE_TEST_EXISTS),
+             "saving an account writes the book file");
+    qof_session_end (session);
+    qof_session_destroy (session);
+    gnc_prefs_set_file_save_journal (FALSE);
+
+    session = journal_session (uri, FALSE);
+    book = qof_session_get_book (session);
+    account = xaccAccountLookup (&account_guid, book);
+    do_test (account && g_strcmp0 (xaccAccountGetName (account),
+                                   "Renamed") == 0
+             && g_strcmp0 (description_of (book, &changed), "after") == 0
+             && g_strcmp0 (description_of (book, &added), "added") == 0
+             && xaccTransLookup (&deleted, book) == NULL,
+             "book file has the journal's transactions");
+    qof_session_end (session);
+    qof_session_destroy (session);
+
+    {
+        GDir* gdir = g_dir_open (dir, 0, NULL);
+        while (const gchar* name = g_dir_read_name (gdir))
+        {
+            gchar* path = g_build_filename (dir, name, NULL);
+            g_remove (path);
+            g_free (path);
+        }
+        g_dir_close (gdir);
+    }
+    g_rmdir (dir);
+    g_free (journal);
+    g_free (uri);
+    g_free (filename);
+    g_free (dir);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -154,6 +395,7 @@ main (int argc, char** argv)
                 if (!g_file_test (to_open, G_FILE_TEST_IS_DIR))
                 {
                     test_load_file (to_open);
+                    test_load_compressed (to_open);
                     files_tested++;
                 }
                 g_free (to_open);
@@ -163,6 +405,8 @@ main (int argc, char** argv)
 
     g_dir_close (xml2_dir);
 
+    test_journal ();
+
     if (files_tested == 0)
     {
         failure ("handled 0 files in test-load-xml2");
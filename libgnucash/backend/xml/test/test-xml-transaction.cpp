@@ -48,11 +48,15 @@ extern "C"
 
 #include "../gnc-xml-helper.h"
 #include "../gnc-xml.h"
+#include "../gnc-xml-writer.hpp"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
 #include "../io-gncxml-gen.h"
 #include "test-file-stuff.h"
 #include <test-stuff.h>
+
+#include <string>
+
 static QofBook* book;
 
 extern gboolean gnc_transaction_xml_v2_testing;
@@ -339,6 +343,28 @@ really_get_rid_of_transaction (Transaction* trn)
     xaccTransCommitEdit (trn);
 }
 
+/* Put each split in an account of its own whose SCU is the split's, so
+ * that setting the amount again doesn't round it. */
+static void
+give_splits_own_accounts (Transaction* trn, gnc_commodity* com)
+{
+    /* xaccAccountInsertSplit can reorder the splits. */
+    GList* list = g_list_copy (xaccTransGetSplitList (trn));
+    GList* node = list;
+    for (; node; node = node->next)
+    {
+        Split* s = static_cast<decltype (s)> (node->data);
+        Account* a = xaccMallocAccount (book);
+
+        xaccAccountBeginEdit (a);
+        xaccAccountSetCommodity (a, com);
+        xaccAccountSetCommoditySCU (a, xaccSplitGetAmount (s).denom);
+        xaccAccountInsertSplit (a, s);
+        xaccAccountCommitEdit (a);
+    }
+    g_list_free (list);
+}
+
 struct tran_data_struct
 {
     Transaction* trn;
@@ -395,23 +421,7 @@ test_transaction (void)
             return;
         }
 
-        {
-            /* xaccAccountInsertSplit can reorder the splits. */
-            GList* list = g_list_copy (xaccTransGetSplitList (ran_trn));
-            GList* node = list;
-            for (; node; node = node->next)
-            {
-                Split* s = static_cast<decltype (s)> (node->data);
-                Account* a = xaccMallocAccount (book);
-
-                xaccAccountBeginEdit (a);
-                xaccAccountSetCommodity (a, new_com);
-                xaccAccountSetCommoditySCU (a, xaccSplitGetAmount (s).denom);
-                xaccAccountInsertSplit (a, s);
-                xaccAccountCommitEdit (a);
-            }
-            g_list_free (list);
-        }
+        give_splits_own_accounts (ran_trn, new_com);
 
         com = xaccTransGetCurrency (ran_trn);
 
@@ -503,6 +513,104 @@ test_transaction (void)
     }
 }
 
+static std::string
+transaction_xml (Transaction* trn)
+{
+    std::string xml;
+    {
+        GncXmlWriter writer (xml);
+        gnc_transaction_write_xml (writer, trn);
+    }
+    return xml;
+}
+
+/* Read transactions with gnc_transaction_parse_xml as a load does on its
+ * worker threads.  Random strings can make elements that are left to the
+ * SAX parser, but most must be read. */
+static void
+test_transaction_without_dom (void)
+{
+    int n_read = 0;
+
+    for (int i = 0; i < 50; i++)
+    {
+        get_random_account_tree (book);
+        Transaction* ran_trn = get_random_transaction (book);
+        if (!ran_trn)
+        {
+            failure_args ("transaction_parse_xml", __FILE__, __LINE__,
+                          "get_random_transaction returned NULL");
+            return;
+        }
+        give_splits_own_accounts (ran_trn, get_random_commodity (book));
+
+        auto xml = transaction_xml (ran_trn);
+        auto data = gnc_transaction_parse_xml (xml.data (), xml.size ());
+        if (data)
+        {
+            Transaction* new_trn = gnc_transaction_from_xml_data (data, book);
+            gnc_transaction_xml_data_free (data);
+            if (do_test_args (new_trn != NULL, "gnc_transaction_from_xml_data",
+                              __FILE__, __LINE__, "%d", i))
+            {
+                do_test_args (xaccTransEqual (ran_trn, new_trn, TRUE, TRUE,
+                                              FALSE, FALSE),
+                              "gnc_transaction_parse_xml",
+                              __FILE__, __LINE__, "%d", i);
+                really_get_rid_of_transaction (new_trn);
+            }
+            n_read++;
+        }
+
+        /* Anything unusual is left to the SAX parser. */
+        auto commented = xml;
+        commented.insert (commented.find ('>') + 1, "<!-- x -->");
+        data = gnc_transaction_parse_xml (commented.data (), commented.size ());
+        do_test_args (data == NULL, "gnc_transaction_parse_xml comment",
+                      __FILE__, __LINE__, "%d", i);
+        gnc_transaction_xml_data_free (data);
+
+        really_get_rid_of_transaction (ran_trn);
+    }
+
+    do_test (n_read > 25, "gnc_transaction_parse_xml read most transactions");
+}
+
+/* A transaction whose account the book doesn't have is left alone. */
+static void
+test_transaction_missing_account (void)
+{
+    get_random_account_tree (book);
+    Transaction* ran_trn = get_random_transaction (book);
+    if (!ran_trn)
+        return;
+
+    auto xml = transaction_xml (ran_trn);
+    auto split = xaccTransGetSplit (ran_trn, 0);
+    auto account = guid_to_string (xaccAccountGetGUID (xaccSplitGetAccount (split)));
+    auto other_guid = guid_new_return ();
+    auto other = guid_to_string (&other_guid);
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+
+    for (size_t pos; (pos = xml.find (account)) != std::string::npos;)
+        xml.replace (pos, strlen (account), other);
+
+    auto data = gnc_transaction_parse_xml (xml.data (), xml.size ());
+    if (data)
+    {
+        auto count = qof_collection_count (transactions);
+        do_test (gnc_transaction_from_xml_data (data, book) == NULL,
+                 "gnc_transaction_from_xml_data missing account");
+        do_test (qof_collection_count (transactions) == count,
+                 "gnc_transaction_from_xml_data left the book alone");
+        gnc_transaction_xml_data_free (data);
+    }
+
+    g_free (account);
+    g_free (other);
+    really_get_rid_of_transaction (ran_trn);
+}
+
 static gboolean
 test_real_transaction (const char* tag, gpointer global_data, gpointer data)
 {
@@ -536,6 +644,8 @@ main (int argc, char** argv)
     else
     {
         test_transaction ();
+        test_transaction_without_dom ();
+        test_transaction_missing_account ();
     }
 
     print_test_results ();
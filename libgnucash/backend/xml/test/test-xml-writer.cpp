@@ -0,0 +1,362 @@
+/***************************************************************************
+ *            test-xml-writer.cpp
+ *
+ *  Check that GncXmlWriter writes the same bytes as xmlElemDump does for
+ *  the DOM trees the same objects make, and that a whole book written in
+ *  parallel chunks comes out in order.
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+extern "C"
+{
+#include <config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cashobjects.h"
+#include "qof.h"
+#include "test-engine-stuff.h"
+
+#include "Account.h"
+#include "Transaction.h"
+#include "TransLog.h"
+#include "gnc-pricedb.h"
+
+#include <zlib.h>
+}
+
+#include "gnc-xml-helper.h"
+#include "gnc-xml.h"
+#include "gnc-xml-writer.hpp"
+#include "io-gncxml-v2.h"
+#include "test-stuff.h"
+
+#include <qof-backend.hpp>
+#include <qofbook-p.h>
+
+#include <functional>
+#include <string>
+
+static QofBook* book;
+
+static std::string
+read_back (FILE* f)
+{
+    std::string contents;
+    char buf[4096];
+    size_t n;
+
+    rewind (f);
+    while ((n = fread (buf, 1, sizeof (buf), f)) > 0)
+        contents.append (buf, n);
+    fclose (f);
+    return contents;
+}
+
+/* What the file backend wrote for node before GncXmlWriter. */
+static std::string
+dom_output (xmlNodePtr node)
+{
+    FILE* f = tmpfile ();
+
+    if (node)
+    {
+        xmlElemDump (f, NULL, node);
+        xmlFreeNode (node);
+    }
+    return read_back (f);
+}
+
+static std::string
+writer_output (const std::function<void (GncXmlWriter&)>& write)
+{
+    FILE* f = tmpfile ();
+    {
+        GncXmlWriter writer (f);
+        write (writer);
+    }
+    return read_back (f);
+}
+
+static void
+check_same (const char* what, int i, const std::string& dom,
+            const std::string& written)
+{
+    if (!do_test_args (dom == written, what, __FILE__, __LINE__,
+                       "iteration %d", i))
+    {
+        printf ("DOM:\n%s\nwriter:\n%s\n", dom.c_str (), written.c_str ());
+        fflush (stdout);
+    }
+}
+
+static void
+test_transaction (void)
+{
+    for (int i = 0; i < 50; i++)
+    {
+        get_random_account_tree (book);
+        Transaction* trn = get_random_transaction (book);
+        if (!trn)
+        {
+            failure_args ("transaction writer", __FILE__, __LINE__,
+                          "get_random_transaction returned NULL");
+            return;
+        }
+
+        auto dom = dom_output (gnc_transaction_dom_tree_create (trn));
+        auto written = writer_output ([trn] (GncXmlWriter & writer)
+        {
+            gnc_transaction_write_xml (writer, trn);
+        });
+        check_same ("transaction writer", i, dom, written);
+
+        xaccTransBeginEdit (trn);
+        xaccTransDestroy (trn);
+        xaccTransCommitEdit (trn);
+    }
+}
+
+/* Strings that checked_char_cast or the escaping has to change. */
+static void
+test_awkward_strings (void)
+{
+    static const char* strings[] =
+    {
+        "", " ", "<&>\"'", "a\rb\nc\td", "\x01\x1f\x7f",
+        "caf\xc3\xa9", "bad \xc3 utf8 \xff\xfe", "]]>", "&amp;"
+    };
+    int i = 0;
+
+    for (auto str : strings)
+    {
+        Transaction* trn = get_random_transaction (book);
+        Split* split = xaccTransGetSplit (trn, 0);
+
+        xaccTransBeginEdit (trn);
+        xaccTransSetDescription (trn, str);
+        xaccTransSetNum (trn, str);
+        if (split)
+        {
+            xaccSplitSetMemo (split, str);
+            xaccSplitSetAction (split, str);
+        }
+        xaccTransSetNotes (trn, str);
+        xaccTransCommitEdit (trn);
+
+        auto dom = dom_output (gnc_transaction_dom_tree_create (trn));
+        auto written = writer_output ([trn] (GncXmlWriter & writer)
+        {
+            gnc_transaction_write_xml (writer, trn);
+        });
+        check_same ("awkward strings", i++, dom, written);
+
+        xaccTransBeginEdit (trn);
+        xaccTransDestroy (trn);
+        xaccTransCommitEdit (trn);
+    }
+}
+
+static void
+test_commodity (void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        gnc_commodity* com = get_random_commodity (book);
+
+        if (i % 2)
+        {
+            gnc_commodity_begin_edit (com);
+            gnc_commodity_set_quote_flag (com, TRUE);
+            gnc_commodity_set_quote_tz (com, "America/New_York");
+            gnc_commodity_commit_edit (com);
+        }
+
+        auto dom = dom_output (gnc_commodity_dom_tree_create (com));
+        auto written = writer_output ([com] (GncXmlWriter & writer)
+        {
+            gnc_commodity_write_xml (writer, com);
+        });
+        check_same ("commodity writer", i, dom, written);
+
+        gnc_commodity_destroy (com);
+    }
+
+    /* A currency is only written if it has quotes or slots. */
+    auto table = gnc_commodity_table_get_table (book);
+    auto currency = gnc_commodity_table_lookup (table,
+                                                GNC_COMMODITY_NS_CURRENCY,
+                                                "USD");
+    if (currency)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            auto dom = dom_output (gnc_commodity_dom_tree_create (currency));
+            auto written = writer_output ([currency] (GncXmlWriter & writer)
+            {
+                gnc_commodity_write_xml (writer, currency);
+            });
+            check_same ("currency writer", i, dom, written);
+
+            gnc_commodity_begin_edit (currency);
+            gnc_commodity_set_quote_flag (currency, TRUE);
+            gnc_commodity_commit_edit (currency);
+        }
+    }
+}
+
+static gboolean
+write_price (GNCPrice* p, gpointer data)
+{
+    gnc_price_write_xml (*static_cast<GncXmlWriter*> (data), p);
+    return TRUE;
+}
+
+static void
+test_pricedb (void)
+{
+    for (int i = 0; i < 20; i++)
+    {
+        QofSession* session = qof_session_new ();
+        QofBook* price_book = qof_session_get_book (session);
+        GNCPriceDB* db = get_random_pricedb (price_book);
+        if (!db)
+        {
+            failure_args ("pricedb writer", __FILE__, __LINE__,
+                          "get_random_pricedb returned NULL");
+            qof_session_end (session);
+            return;
+        }
+
+        auto dom = dom_output (gnc_pricedb_dom_tree_create (db));
+        auto written = writer_output ([db] (GncXmlWriter & writer)
+        {
+            if (!gnc_pricedb_is_writable (db))
+                return;
+            writer.start ("gnc:pricedb");
+            writer.attribute ("version", "1");
+            gnc_pricedb_foreach_price (db, write_price, &writer, TRUE);
+            writer.end ();
+        });
+        check_same ("pricedb writer", i, dom, written);
+
+        gnc_pricedb_destroy (db);
+        qof_session_end (session);
+    }
+}
+
+/* gnc_book_write_to_xml_filehandle_v2 wants a backend for its progress
+ * callback. */
+class WriterMockBackend : public QofBackend
+{
+public:
+    void session_begin (QofSession*, const char*, bool, bool, bool) override {}
+    void session_end () override {}
+    void load (QofBook*, QofBackendLoadType) override {}
+    void sync (QofBook*) override {}
+    void safe_sync (QofBook*) override {}
+};
+
+/* gzread reads uncompressed files as they are. */
+static std::string
+file_contents (const char* filename)
+{
+    std::string contents;
+    char buf[4096];
+    int n;
+    gzFile file = gzopen (filename, "rb");
+
+    if (!file)
+        return contents;
+    while ((n = gzread (file, buf, sizeof (buf))) > 0)
+        contents.append (buf, n);
+    gzclose (file);
+    return contents;
+}
+
+static int
+append_transaction (Transaction* trn, gpointer data)
+{
+    *static_cast<std::string*> (data) +=
+        dom_output (gnc_transaction_dom_tree_create (trn)) + "\n";
+    return 0;
+}
+
+/* A book big enough for its transactions to be written in several chunks
+ * and compressed in several gzip members: the chunks must come out in
+ * order and the members must read back as one file. */
+static void
+test_book_file (void)
+{
+    QofBook* file_book = qof_book_new ();
+    WriterMockBackend be;
+    std::string transactions;
+    auto plain = g_build_filename (g_get_tmp_dir (), "test-xml-writer.xml",
+                                   NULL);
+    auto compressed = g_build_filename (g_get_tmp_dir (),
+                                        "test-xml-writer.xml.gz", NULL);
+
+    qof_book_set_backend (file_book, &be);
+    get_random_account_tree (file_book);
+    add_random_transactions_to_book (file_book, 3000);
+    get_random_pricedb (file_book);
+
+    do_test (gnc_book_write_to_xml_file_v2 (file_book, plain, FALSE, -1),
+             "write uncompressed book");
+    do_test (gnc_book_write_to_xml_file_v2 (file_book, compressed, TRUE, -1),
+             "write compressed book");
+
+    auto written = file_contents (plain);
+    do_test (!written.empty (), "uncompressed book has content");
+    do_test (file_contents (compressed) == written,
+             "compressed book reads back the same");
+
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (file_book),
+                                       append_transaction, &transactions);
+    do_test (written.find (transactions) != std::string::npos,
+             "transactions written in order");
+
+    g_remove (plain);
+    g_remove (compressed);
+    g_free (plain);
+    g_free (compressed);
+    qof_book_set_backend (file_book, NULL);
+    qof_book_destroy (file_book);
+}
+
+int
+main (int argc, char** argv)
+{
+    qof_init ();
+    cashobjects_register ();
+    xaccLogDisable ();
+
+    book = qof_book_new ();
+
+    test_transaction ();
+    test_awkward_strings ();
+    test_commodity ();
+    test_pricedb ();
+    test_book_file ();
+
+    print_test_results ();
+    qof_close ();
+    exit (get_rv ());
+}
@@ -32,6 +32,9 @@ static gchar *namespace_regexp    = NULL;
 static gboolean is_debugging      = FALSE;
 static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
+static gint compression_level     = -1;   // zlib's default, also the default in the prefs backend
+static gint autosave_compression_level = 1; // This is also the default in the prefs backend
+static gboolean use_journal       = FALSE; // This is also the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
 
@@ -89,6 +92,42 @@ gnc_prefs_set_file_save_compressed(gboolean compressed)
     use_compression = compressed;
 }
 
+gint
+gnc_prefs_get_file_compression_level(void)
+{
+    return compression_level;
+}
+
+void
+gnc_prefs_set_file_compression_level(gint level)
+{
+    compression_level = level;
+}
+
+gint
+gnc_prefs_get_autosave_compression_level(void)
+{
+    return autosave_compression_level;
+}
+
+void
+gnc_prefs_set_autosave_compression_level(gint level)
+{
+    autosave_compression_level = level;
+}
+
+gboolean
+gnc_prefs_get_file_save_journal(void)
+{
+    return use_journal;
+}
+
+void
+gnc_prefs_set_file_save_journal(gboolean journal)
+{
+    use_journal = journal;
+}
+
 gint
 gnc_prefs_get_file_retention_policy(void)
 {
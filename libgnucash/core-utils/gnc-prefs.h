@@ -109,6 +109,21 @@ void gnc_prefs_set_extra(gboolean enabled);
 gboolean gnc_prefs_get_file_save_compressed(void);
 void gnc_prefs_set_file_save_compressed(gboolean compressed);
 
+/** The zlib compression level for saving compressed files, from 0 (none)
+ *  to 9 (smallest), or -1 for zlib's default. */
+gint gnc_prefs_get_file_compression_level(void);
+void gnc_prefs_set_file_compression_level(gint level);
+
+/** The zlib compression level for auto-saves, or -1 to use the level of
+ *  other saves. */
+gint gnc_prefs_get_autosave_compression_level(void);
+void gnc_prefs_set_autosave_compression_level(gint level);
+
+/** Whether saves append the changed transactions to a journal beside the
+ *  data file instead of rewriting all of it every time. */
+gboolean gnc_prefs_get_file_save_journal(void);
+void gnc_prefs_set_file_save_journal(gboolean journal);
+
 gint gnc_prefs_get_file_retention_policy(void);
 void gnc_prefs_set_file_retention_policy(gint policy);
 
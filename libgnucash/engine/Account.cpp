@@ -44,6 +44,7 @@
 #include "guid.hpp"
 
 #include <numeric>
+#include <algorithm>
 
 static QofLogModule log_module = GNC_MOD_ACCOUNT;
 
@@ -63,7 +64,18 @@ static const std::string AB_ACCOUNT_UID("account-uid");
 static const std::string AB_BANK_CODE("bank-code");
 static const std::string AB_TRANS_RETRIEVAL("trans-retrieval");
 
-static gnc_numeric GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing);
+typedef gnc_numeric (*xaccGetSplitBalanceFn) (const Split *split);
+
+static gnc_numeric GetBalanceAsOfDate (Account *acc, time64 date,
+                                       xaccGetBalanceFn acct_fn,
+                                       xaccGetSplitBalanceFn split_fn);
+
+/* One entry of AccountPrivate::split_index. */
+typedef struct
+{
+    time64 date_posted;
+    Split *split;
+} SplitIndexEntry;
 
 using FinalProbabilityVec=std::vector<std::pair<std::string, int32_t>>;
 using ProbabilityVec=std::vector<std::pair<std::string, struct AccountProbability>>;
@@ -135,6 +147,7 @@ enum
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void account_free_split_list (AccountPrivate *priv);
 
 
 /********************************************************************\
@@ -291,9 +304,14 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_date = G_MAXINT64;
 
-    priv->splits = NULL;
+    priv->splits = g_ptr_array_new ();
     priv->sort_dirty = FALSE;
+    priv->split_list = NULL;
+    priv->split_list_nodes = NULL;
+    priv->split_list_dirty = TRUE;
+    priv->split_index = g_array_new (FALSE, FALSE, sizeof (SplitIndexEntry));
 }
 
 static void
@@ -305,6 +323,19 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv = GET_PRIVATE(acctp);
+
+    if (priv->splits)
+    {
+        g_ptr_array_free (priv->splits, TRUE);
+        priv->splits = NULL;
+    }
+    account_free_split_list (priv);
+    if (priv->split_index)
+    {
+        g_array_free (priv->split_index, TRUE);
+        priv->split_index = NULL;
+    }
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -1203,6 +1234,134 @@ xaccCloneAccount(const Account *from, QofBook *book)
     return ret;
 }
 
+/********************************************************************\
+ * The split array                                                  *
+\********************************************************************/
+
+/* A copy of the account's splits, for walking them while they are
+ * destroyed or moved to another account. */
+static GPtrArray *
+account_copy_splits (const AccountPrivate *priv)
+{
+    GPtrArray *copy = g_ptr_array_sized_new (priv->splits->len);
+
+    for (guint i = 0; i < priv->splits->len; ++i)
+        g_ptr_array_add (copy, g_ptr_array_index (priv->splits, i));
+    return copy;
+}
+
+static bool
+split_less (const Split *a, const Split *b)
+{
+    return xaccSplitOrder (a, b) < 0;
+}
+
+/* The position at which s belongs in the split array, which must be
+ * sorted. */
+static guint
+account_split_lower_bound (const AccountPrivate *priv, const Split *s)
+{
+    auto begin = reinterpret_cast<Split**>(priv->splits->pdata);
+    auto end = begin + priv->splits->len;
+    return std::lower_bound (begin, end, s, split_less) - begin;
+}
+
+/* Look for s in the split array one element at a time. */
+static gboolean
+account_scan_for_split (const AccountPrivate *priv, const Split *s,
+                        guint *pos)
+{
+    for (guint i = 0; i < priv->splits->len; ++i)
+    {
+        if (g_ptr_array_index (priv->splits, i) != s)
+            continue;
+        if (pos)
+            *pos = i;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Build the GList handed out by xaccAccountGetSplitList from the split
+ * array.  From then on the list is kept in step with the array, one node
+ * per split, so lists callers already hold stay valid. */
+static void
+account_build_split_list (AccountPrivate *priv)
+{
+    GList *list = NULL;
+
+    priv->split_list_nodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (guint i = priv->splits->len; i > 0; --i)
+    {
+        list = g_list_prepend (list, g_ptr_array_index (priv->splits, i - 1));
+        g_hash_table_insert (priv->split_list_nodes, list->data, list);
+    }
+    priv->split_list = list;
+    priv->split_list_dirty = FALSE;
+}
+
+static void
+account_free_split_list (AccountPrivate *priv)
+{
+    g_list_free (priv->split_list);
+    priv->split_list = NULL;
+    if (priv->split_list_nodes)
+    {
+        g_hash_table_destroy (priv->split_list_nodes);
+        priv->split_list_nodes = NULL;
+    }
+    priv->split_list_dirty = TRUE;
+}
+
+/* Link s into the split list at pos, where the split array already has
+ * it.  Its neighbours in the array tell which node to link it next to. */
+static void
+account_split_list_insert (AccountPrivate *priv, Split *s, guint pos)
+{
+    GList *node = g_list_alloc ();
+
+    node->data = s;
+    if (pos + 1 < priv->splits->len)
+    {
+        GList *next = static_cast<GList*>(g_hash_table_lookup (
+            priv->split_list_nodes, g_ptr_array_index (priv->splits, pos + 1)));
+        node->next = next;
+        node->prev = next->prev;
+        if (next->prev)
+            next->prev->next = node;
+        else
+            priv->split_list = node;
+        next->prev = node;
+    }
+    else if (pos > 0)
+    {
+        GList *prev = static_cast<GList*>(g_hash_table_lookup (
+            priv->split_list_nodes, g_ptr_array_index (priv->splits, pos - 1)));
+        node->prev = prev;
+        prev->next = node;
+    }
+    else
+        priv->split_list = node;
+    g_hash_table_insert (priv->split_list_nodes, s, node);
+}
+
+static void
+account_split_list_remove (AccountPrivate *priv, Split *s)
+{
+    GList *node = static_cast<GList*>(g_hash_table_lookup (
+        priv->split_list_nodes, s));
+
+    g_hash_table_remove (priv->split_list_nodes, s);
+    priv->split_list = g_list_delete_link (priv->split_list, node);
+}
+
+static gint
+split_list_compare (gconstpointer a, gconstpointer b)
+{
+    return xaccSplitOrder (static_cast<const Split*>(a),
+                           static_cast<const Split*>(b));
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -1277,24 +1436,24 @@ xaccFreeAccount (Account *acc)
     /* NB there shouldn't be any splits by now ... they should
      * have been all been freed by CommitEdit().  We can remove this
      * check once we know the warning isn't occurring any more. */
-    if (priv->splits)
+    if (priv->splits->len)
     {
-        GList *slist;
+        GPtrArray *slist;
         PERR (" instead of calling xaccFreeAccount(), please call \n"
               " xaccAccountBeginEdit(); xaccAccountDestroy(); \n");
 
         qof_instance_reset_editlevel(acc);
 
-        slist = g_list_copy(priv->splits);
-        for (lp = slist; lp; lp = lp->next)
+        slist = account_copy_splits (priv);
+        for (guint i = 0; i < slist->len; ++i)
         {
-            Split *s = (Split *) lp->data;
+            Split *s = (Split *) g_ptr_array_index (slist, i);
             g_assert(xaccSplitGetAccount(s) == acc);
             xaccSplitDestroy (s);
         }
-        g_list_free(slist);
-/* Nothing here (or in xaccAccountCommitEdit) NULLs priv->splits, so this asserts every time.
-        g_assert(priv->splits == NULL);
+        g_ptr_array_free (slist, TRUE);
+/* Nothing here (or in xaccAccountCommitEdit) empties priv->splits, so this asserts every time.
+        g_assert(priv->splits->len == 0);
 */
     }
 
@@ -1384,7 +1543,7 @@ xaccAccountCommitEdit (Account *acc)
     priv = GET_PRIVATE(acc);
     if (qof_instance_get_destroying(acc))
     {
-        GList *lp, *slist;
+        GList *lp;
         QofCollection *col;
 
         qof_instance_increase_editlevel(acc);
@@ -1401,18 +1560,19 @@ xaccAccountCommitEdit (Account *acc)
            themselves will be destroyed by the transaction code */
         if (!qof_book_shutting_down(book))
         {
-            slist = g_list_copy(priv->splits);
-            for (lp = slist; lp; lp = lp->next)
+            GPtrArray *slist = account_copy_splits (priv);
+            for (guint i = 0; i < slist->len; ++i)
             {
-                Split *s = static_cast<Split *>(lp->data);
+                Split *s = static_cast<Split *>(g_ptr_array_index (slist, i));
                 xaccSplitDestroy (s);
             }
-            g_list_free(slist);
+            g_ptr_array_free (slist, TRUE);
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            g_ptr_array_set_size (priv->splits, 0);
+            account_free_split_list (priv);
+            g_array_set_size (priv->split_index, 0);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1420,7 +1580,7 @@ xaccAccountCommitEdit (Account *acc)
            deleting all the splits in it.  The splits will just get
            recreated and put right back into the same account!
 
-           g_assert(priv->splits == NULL || qof_book_shutting_down(acc->inst.book));
+           g_assert(priv->splits->len == 0 || qof_book_shutting_down(acc->inst.book));
         */
 
         if (!qof_book_shutting_down(book))
@@ -1723,34 +1883,31 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
     /* no parent; always compare downwards. */
 
     {
-        GList *la = priv_aa->splits;
-        GList *lb = priv_ab->splits;
+        guint na = priv_aa->splits->len;
+        guint nb = priv_ab->splits->len;
 
-        if ((la && !lb) || (!la && lb))
+        if ((na && !nb) || (!na && nb))
         {
             PWARN ("only one has splits");
             return FALSE;
         }
 
-        if (la && lb)
+        if (na && nb)
         {
             /* presume that the splits are in the same order */
-            while (la && lb)
+            for (guint i = 0; i < na && i < nb; ++i)
             {
-                Split *sa = (Split *) la->data;
-                Split *sb = (Split *) lb->data;
+                Split *sa = (Split *) g_ptr_array_index (priv_aa->splits, i);
+                Split *sb = (Split *) g_ptr_array_index (priv_ab->splits, i);
 
                 if (!xaccSplitEqual(sa, sb, check_guids, TRUE, FALSE))
                 {
                     PWARN ("splits differ");
                     return(FALSE);
                 }
-
-                la = la->next;
-                lb = lb->next;
             }
 
-            if ((la != NULL) || (lb != NULL))
+            if (na != nb)
             {
                 PWARN ("number of splits differs");
                 return(FALSE);
@@ -1769,6 +1926,17 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
 
 /********************************************************************\
 \********************************************************************/
+
+/* Flag the running balances of the splits posted on or after date as
+ * stale.  G_MININT64 flags all of them. */
+static void
+mark_balance_dirty (AccountPrivate *priv, time64 date)
+{
+    priv->balance_dirty = TRUE;
+    if (date < priv->balance_dirty_date)
+        priv->balance_dirty_date = date;
+}
+
 void
 gnc_account_set_sort_dirty (Account *acc)
 {
@@ -1794,7 +1962,21 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, G_MININT64);
+}
+
+void
+gnc_account_set_balance_dirty_from (Account *acc, time64 date)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    mark_balance_dirty (priv, date);
 }
 
 /********************************************************************\
@@ -1804,33 +1986,43 @@ gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
-        return FALSE;
-
-    if (qof_instance_get_editlevel(acc) == 0)
+    if (priv->sort_dirty)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        if (account_scan_for_split (priv, s, NULL))
+            return FALSE;
+        pos = priv->splits->len;
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        pos = account_split_lower_bound (priv, s);
+        if (pos < priv->splits->len &&
+            g_ptr_array_index (priv->splits, pos) == s)
+            return FALSE;
+    }
+
+    /* While the account is being edited, just append and sort once
+     * the edit is committed. */
+    if (qof_instance_get_editlevel(acc) > 0)
+    {
+        pos = priv->splits->len;
         priv->sort_dirty = TRUE;
     }
+    g_ptr_array_insert (priv->splits, pos, s);
+    if (!priv->split_list_dirty)
+        account_split_list_insert (priv, s, pos);
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, xaccTransRetDatePosted (s->parent));
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1840,23 +2032,28 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint pos = 0;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    if (!priv->sort_dirty)
+        pos = account_split_lower_bound (priv, s);
+    if ((priv->sort_dirty || pos >= priv->splits->len ||
+         g_ptr_array_index (priv->splits, pos) != s) &&
+        !account_scan_for_split (priv, s, &pos))
         return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
+    g_ptr_array_remove_index (priv->splits, pos);
+    if (!priv->split_list_dirty)
+        account_split_list_remove (priv, s);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, xaccTransRetDatePosted (s->parent));
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
@@ -1871,7 +2068,13 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+    std::sort (reinterpret_cast<Split**>(priv->splits->pdata),
+               reinterpret_cast<Split**>(priv->splits->pdata) +
+               priv->splits->len, split_less);
+    /* xaccSplitOrder is a total order, so the list sorts into the same
+     * order as the array. */
+    if (!priv->split_list_dirty)
+        priv->split_list = g_list_sort (priv->split_list, split_list_compare);
     priv->sort_dirty = FALSE;
     priv->balance_dirty = TRUE;
 }
@@ -2064,6 +2267,7 @@ void
 xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
 {
     AccountPrivate *from_priv;
+    GPtrArray *splits;
 
     /* errors */
     g_return_if_fail(GNC_IS_ACCOUNT(accfrom));
@@ -2071,7 +2275,7 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
 
     /* optimizations */
     from_priv = GET_PRIVATE(accfrom);
-    if (!from_priv->splits || accfrom == accto)
+    if (!from_priv->splits->len || accfrom == accto)
         return;
 
     /* check for book mix-up */
@@ -2081,7 +2285,8 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
     xaccAccountBeginEdit(accfrom);
     xaccAccountBeginEdit(accto);
     /* Begin editing both accounts and all transactions in accfrom. */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPreSplitMove, NULL);
+    splits = account_copy_splits (from_priv);
+    g_ptr_array_foreach(splits, (GFunc)xaccPreSplitMove, NULL);
 
     /* Concatenate accfrom's lists of splits and lots to accto's lists. */
     //to_priv->splits = g_list_concat(to_priv->splits, from_priv->splits);
@@ -2098,10 +2303,11 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
      * Convert each split's amount to accto's commodity.
      * Commit to editing each transaction.
      */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPostSplitMove, (gpointer)accto);
+    g_ptr_array_foreach(splits, (GFunc)xaccPostSplitMove, (gpointer)accto);
+    g_ptr_array_free (splits, TRUE);
 
     /* Finally empty accfrom. */
-    g_assert(from_priv->splits == NULL);
+    g_assert(from_priv->splits->len == 0);
     g_assert(from_priv->lots == NULL);
     xaccAccountCommitEdit(accfrom);
     xaccAccountCommitEdit(accto);
@@ -2134,6 +2340,13 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * in dollars.  Thus, two different mechanisms must be used to      *
  * compute balances, depending on account type.                     *
  *                                                                  *
+ * Only the tail of the split list is recomputed: the leading      *
+ * splits that are still in the position and on the posted date     *
+ * recorded in the split index, and that are older than             *
+ * balance_dirty_date, keep their running balances.  Entering a new *
+ * transaction at the end of a long account thus only touches the   *
+ * new split.                                                       *
+ *                                                                  *
  * Args:   account -- the account for which to recompute balances   *
  * Return: void                                                     *
 \********************************************************************/
@@ -2146,7 +2359,7 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  noclosing_balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
+    guint pos;
 
     if (NULL == acc) return;
 
@@ -2156,17 +2369,47 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    noclosing_balance  = priv->starting_noclosing_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* Skip the splits whose running balances are still good. */
+    for (pos = 0; pos < priv->splits->len && pos < priv->split_index->len;
+         ++pos)
+    {
+        Split *split = (Split *) g_ptr_array_index (priv->splits, pos);
+        const SplitIndexEntry& entry =
+            g_array_index (priv->split_index, SplitIndexEntry, pos);
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+        if (entry.split != split ||
+            entry.date_posted >= priv->balance_dirty_date ||
+            entry.date_posted != xaccTransRetDatePosted (split->parent))
+            break;
+    }
+
+    if (pos == 0)
     {
-        Split *split = (Split *) lp->data;
+        balance            = priv->starting_balance;
+        noclosing_balance  = priv->starting_noclosing_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
+    else
+    {
+        Split *last = g_array_index (priv->split_index, SplitIndexEntry,
+                                     pos - 1).split;
+        balance            = last->balance;
+        noclosing_balance  = last->noclosing_balance;
+        cleared_balance    = last->cleared_balance;
+        reconciled_balance = last->reconciled_balance;
+    }
+
+    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT
+           " at split %u", priv->accountName, balance.num, balance.denom, pos);
+    g_array_set_size (priv->split_index, pos);
+    for (; pos < priv->splits->len; ++pos)
+    {
+        Split *split = (Split *) g_ptr_array_index (priv->splits, pos);
         gnc_numeric amt = xaccSplitGetAmount (split);
+        SplitIndexEntry entry = {xaccTransRetDatePosted (split->parent), split};
+
+        g_array_append_val (priv->split_index, entry);
 
         balance = gnc_numeric_add_fixed(balance, amt);
 
@@ -2197,6 +2440,7 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_date = G_MAXINT64;
 }
 
 /********************************************************************\
@@ -2311,7 +2555,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    mark_balance_dirty (priv, G_MININT64); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2463,7 +2707,6 @@ void
 xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
 {
     AccountPrivate *priv;
-    GList *lp;
 
     /* errors */
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
@@ -2482,9 +2725,9 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     priv->non_standard_scu = FALSE;
 
     /* iterate over splits */
-    for (lp = priv->splits; lp; lp = lp->next)
+    for (guint i = 0; i < priv->splits->len; ++i)
     {
-        Split *s = (Split *) lp->data;
+        Split *s = (Split *) g_ptr_array_index (priv->splits, i);
         Transaction *trans = xaccSplitGetParent (s);
 
         xaccTransBeginEdit (trans);
@@ -2493,7 +2736,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, G_MININT64);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3279,7 +3522,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, G_MININT64);
 }
 
 void
@@ -3292,7 +3535,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, G_MININT64);
 }
 
 void
@@ -3305,7 +3548,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty (priv, G_MININT64);
 }
 
 gnc_numeric
@@ -3333,7 +3576,6 @@ gnc_numeric
 xaccAccountGetProjectedMinimumBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
     time64 today;
     gnc_numeric lowest = gnc_numeric_zero ();
     int seen_a_transaction = 0;
@@ -3342,9 +3584,10 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (guint i = priv->splits->len; i > 0; --i)
     {
-        Split *split = static_cast<Split*>(node->data);
+        Split *split = static_cast<Split*>(g_ptr_array_index (priv->splits,
+                                                              i - 1));
 
         if (!seen_a_transaction)
         {
@@ -3367,19 +3610,37 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
+/* Return the position in the split index of the first split posted at
+ * or after date, or the length of the index if there is none. */
+static guint
+split_index_lower_bound (const AccountPrivate *priv, time64 date)
+{
+    auto begin = reinterpret_cast<SplitIndexEntry*>(priv->split_index->data);
+    auto end = begin + priv->split_index->len;
+    auto it = std::lower_bound (begin, end, date,
+                                [](const SplitIndexEntry& entry, time64 t)
+                                { return entry.date_posted < t; });
+    return it - begin;
+}
+
+/* Return the position in the split index of the first split posted
+ * after date, or the length of the index if there is none. */
+static guint
+split_index_upper_bound (const AccountPrivate *priv, time64 date)
+{
+    auto begin = reinterpret_cast<SplitIndexEntry*>(priv->split_index->data);
+    auto end = begin + priv->split_index->len;
+    auto it = std::upper_bound (begin, end, date,
+                                [](time64 t, const SplitIndexEntry& entry)
+                                { return t < entry.date_posted; });
+    return it - begin;
+}
+
 static gnc_numeric
-GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing)
+GetBalanceAsOfDate (Account *acc, time64 date, xaccGetBalanceFn acct_fn,
+                    xaccGetSplitBalanceFn split_fn)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
     AccountPrivate *priv;
-    GList   *lp;
-    gboolean found = FALSE;
-    gnc_numeric balance;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
@@ -3387,81 +3648,117 @@ GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing)
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
     priv = GET_PRIVATE(acc);
-    if (ignclosing)
-        balance = priv->noclosing_balance;
-    else
-        balance = priv->balance;
 
-    lp = priv->splits;
-    while ( lp && !found )
+    if (!priv->balance_dirty)
     {
-        time64 trans_time = xaccTransRetDatePosted( xaccSplitGetParent( (Split *)lp->data ));
-        if ( trans_time >= date )
-            found = TRUE;
-        else
-            lp = lp->next;
+        guint pos = split_index_lower_bound (priv, date);
+
+        /* No splits posted on or after the given date, so the latest
+         * account balance is good enough. */
+        if (pos == priv->split_index->len)
+            return acct_fn (acc);
+
+        /* AsOf date must be before any entries, return zero. */
+        if (pos == 0)
+            return gnc_numeric_zero ();
+
+        /* Otherwise it's the running balance of the split just before. */
+        return split_fn (g_array_index (priv->split_index,
+                                        SplitIndexEntry, pos - 1).split);
     }
 
-    if ( lp )
+    /* The running balances can't be recomputed while the account is
+     * being edited, so fall back to walking the split list. */
+    for (guint i = 0; i < priv->splits->len; ++i)
     {
-        if ( lp->prev )
+        Split *split = (Split *) g_ptr_array_index (priv->splits, i);
+        time64 trans_time = xaccTransRetDatePosted( xaccSplitGetParent( split ));
+        if ( trans_time >= date )
         {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
+            /* Since split is past the given date, get the running
+             * balance of the previous split.
              */
-            if (ignclosing)
-                balance = xaccSplitGetNoclosingBalance( (Split *)lp->prev->data );
-            else
-                balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
-        {
+            if ( i > 0 )
+                return split_fn ((Split *) g_ptr_array_index (priv->splits,
+                                                              i - 1));
+
             /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
+            return gnc_numeric_zero();
         }
     }
 
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
+    /* There were no splits posted after the given date, so the latest
+     * account balance should be good enough.
      */
+    return acct_fn (acc);
+}
 
-    return( balance );
+static gnc_numeric
+xaccAccountGetNoclosingBalance (const Account *acc)
+{
+    return GET_PRIVATE(acc)->noclosing_balance;
 }
 
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, FALSE);
+    return GetBalanceAsOfDate (acc, date, xaccAccountGetBalance,
+                               xaccSplitGetBalance);
 }
 
 static gnc_numeric
 xaccAccountGetNoclosingBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, TRUE);
+    return GetBalanceAsOfDate (acc, date, xaccAccountGetNoclosingBalance,
+                               xaccSplitGetNoclosingBalance);
+}
+
+gnc_numeric
+xaccAccountGetClearedBalanceAsOfDate (Account *acc, time64 date)
+{
+    return GetBalanceAsOfDate (acc, date, xaccAccountGetClearedBalance,
+                               xaccSplitGetClearedBalance);
+}
+
+gnc_numeric
+xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)
+{
+    return GetBalanceAsOfDate (acc, date, xaccAccountGetReconciledBalance,
+                               xaccSplitGetReconciledBalance);
 }
 
 /*
  * Originally gsr_account_present_balance in gnc-split-reg.c
  *
- * How does this routine compare to xaccAccountGetBalanceAsOfDate just
- * above?  These two routines should eventually be collapsed into one.
- * Perhaps the startup logic from that one, and the logic from this
- * one that walks from the tail of the split list.
+ * This is the last running balance at or before the end of today,
+ * found in the split index when it is current and by walking back
+ * from the tail of the split list otherwise.
  */
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
     time64 today;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+
+    if (!priv->balance_dirty)
+    {
+        guint pos = split_index_upper_bound (priv, today);
+        if (pos == 0)
+            return gnc_numeric_zero ();
+        return xaccSplitGetBalance (g_array_index (priv->split_index,
+                                                   SplitIndexEntry,
+                                                   pos - 1).split);
+    }
+
+    for (guint i = priv->splits->len; i > 0; --i)
     {
-        Split *split = static_cast<Split*>(node->data);
+        Split *split = static_cast<Split*>(g_ptr_array_index (priv->splits,
+                                                              i - 1));
 
         if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
             return xaccSplitGetBalance (split);
@@ -3817,9 +4114,14 @@ xaccAccountGetNoclosingBalanceChangeForPeriod (Account *acc, time64 t1,
 SplitList *
 xaccAccountGetSplitList (const Account *acc)
 {
+    AccountPrivate *priv;
+
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
     xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
-    return GET_PRIVATE(acc)->splits;
+    priv = GET_PRIVATE(acc);
+    if (priv->split_list_dirty)
+        account_build_split_list (priv);
+    return priv->split_list;
 }
 
 gint64
@@ -3829,7 +4131,7 @@ xaccAccountCountSplits (const Account *acc, gboolean include_children)
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
 
-    nr = g_list_length(xaccAccountGetSplitList(acc));
+    nr = GET_PRIVATE(acc)->splits->len;
     if (include_children && (gnc_account_n_children(acc) != 0))
     {
         for (i=0; i < gnc_account_n_children(acc); i++)
@@ -4839,7 +5141,6 @@ finder_help_function(const Account *acc, const char *description,
                      Split **split, Transaction **trans )
 {
     AccountPrivate *priv;
-    GList *slp;
 
     /* First, make sure we set the data to NULL BEFORE we start */
     if (split) *split = NULL;
@@ -4852,9 +5153,10 @@ finder_help_function(const Account *acc, const char *description,
      * list is in date order, and the most recent matches should be
      * returned!?  */
     priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    for (guint i = priv->splits->len; i > 0; --i)
     {
-        Split *lsplit = static_cast<Split*>(slp->data);
+        Split *lsplit = static_cast<Split*>(g_ptr_array_index (priv->splits,
+                                                               i - 1));
         Transaction *ltrans = xaccSplitGetParent(lsplit);
 
         if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
@@ -4971,8 +5273,8 @@ gnc_account_merge_children (Account *parent)
             gnc_account_merge_children (acc_a);
 
             /* consolidate transactions */
-            while (priv_b->splits)
-                xaccSplitSetAccount (static_cast <Split*> (priv_b->splits->data), acc_a);
+            while (priv_b->splits->len)
+                xaccSplitSetAccount (static_cast <Split*> (g_ptr_array_index (priv_b->splits, 0)), acc_a);
 
             /* move back one before removal. next iteration around the loop
              * will get the node after node_b */
@@ -5005,6 +5307,14 @@ xaccSplitsBeginStagedTransactionTraversals (GList *splits)
     }
 }
 
+static void do_one_split (Split *s, gpointer data)
+{
+    Transaction *trans = s->parent;
+
+    if (trans)
+        trans->marker = 0;
+}
+
 /* original function */
 void
 xaccAccountBeginStagedTransactionTraversals (const Account *account)
@@ -5014,7 +5324,7 @@ xaccAccountBeginStagedTransactionTraversals (const Account *account)
     if (!account)
         return;
     priv = GET_PRIVATE(account);
-    xaccSplitsBeginStagedTransactionTraversals(priv->splits);
+    g_ptr_array_foreach(priv->splits, (GFunc)do_one_split, NULL);
 }
 
 gboolean
@@ -5031,16 +5341,10 @@ xaccTransactionTraverse (Transaction *trans, int stage)
     return FALSE;
 }
 
-static void do_one_split (Split *s, gpointer data)
-{
-    Transaction *trans = s->parent;
-    trans->marker = 0;
-}
-
 static void do_one_account (Account *account, gpointer data)
 {
     AccountPrivate *priv = GET_PRIVATE(account);
-    g_list_foreach(priv->splits, (GFunc)do_one_split, NULL);
+    g_ptr_array_foreach(priv->splits, (GFunc)do_one_split, NULL);
 }
 
 /* Replacement for xaccGroupBeginStagedTransactionTraversals */
@@ -5061,8 +5365,7 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
                                        void *cb_data)
 {
     AccountPrivate *priv;
-    GList *split_p;
-    GList *next;
+    guint i = 0;
     Transaction *trans;
     Split *s;
     int retval;
@@ -5070,15 +5373,9 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
     if (!acc) return 0;
 
     priv = GET_PRIVATE(acc);
-    for (split_p = priv->splits; split_p; split_p = next)
+    while (i < priv->splits->len)
     {
-        /* Get the next element in the split list now, just in case some
-         * naughty thunk destroys the one we're using. This reduces, but
-         * does not eliminate, the possibility of undefined results if
-         * a thunk removes splits from this account. */
-        next = g_list_next(split_p);
-
-        s = static_cast <Split*> (split_p->data);
+        s = static_cast <Split*> (g_ptr_array_index (priv->splits, i));
         trans = s->parent;
         if (trans && (trans->marker < stage))
         {
@@ -5089,6 +5386,17 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
                 if (retval) return retval;
             }
         }
+
+        /* Some naughty thunk may have added or removed splits in this
+         * account.  Carry on after s if it's still here, else start over:
+         * the transactions already visited have their marker at stage
+         * and will be skipped. */
+        if ((i < priv->splits->len &&
+             g_ptr_array_index (priv->splits, i) == s) ||
+            account_scan_for_split (priv, s, &i))
+            ++i;
+        else
+            i = 0;
     }
 
     return 0;
@@ -5101,7 +5409,7 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
         void *cb_data)
 {
     const AccountPrivate *priv;
-    GList *acc_p, *split_p;
+    GList *acc_p;
     Transaction *trans;
     Split *s;
     int retval;
@@ -5118,9 +5426,9 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
-    for (split_p = priv->splits; split_p; split_p = g_list_next(split_p))
+    for (guint i = 0; i < priv->splits->len; ++i)
     {
-        s = static_cast <Split*> (split_p->data);
+        s = static_cast <Split*> (g_ptr_array_index (priv->splits, i));
         trans = s->parent;
         if (trans && (trans->marker < stage))
         {
@@ -355,6 +355,16 @@ void gnc_account_set_start_reconciled_balance (Account *acc,
  *  @param acc Set the flag on this account. */
 void gnc_account_set_balance_dirty (Account *acc);
 
+/** Tell the account that the running balances of the splits posted
+ *  on or after the given date may be incorrect and need to be
+ *  recomputed.  Splits that have moved within the account since the
+ *  last recompute are always recomputed.
+ *
+ *  @param acc Set the flag on this account.
+ *
+ *  @param date The posted date of the earliest changed split. */
+void gnc_account_set_balance_dirty_from (Account *acc, time64 date);
+
 /** Tell the account believes that the splits may be incorrectly
  *  sorted and need to be resorted.
  *
@@ -557,6 +567,14 @@ gnc_numeric xaccAccountGetProjectedMinimumBalance (const Account *account);
 /** Get the balance of the account as of the date specified */
 gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
         time64 date);
+/** Get the balance of the account as of the date specified, only
+    including cleared transactions */
+gnc_numeric xaccAccountGetClearedBalanceAsOfDate (Account *account,
+        time64 date);
+/** Get the balance of the account as of the date specified, only
+    including reconciled transactions */
+gnc_numeric xaccAccountGetReconciledBalanceAsOfDate (Account *account,
+        time64 date);
 
 /* These two functions convert a given balance from one commodity to
    another.  The account argument is only used to get the Book, and
@@ -998,11 +1016,11 @@ gboolean xaccAccountIsEquityType(GNCAccountType t);
 
 /** The xaccAccountGetSplitList() routine returns a pointer to a GList of
  *    the splits in the account.
- * @note This GList is the account's internal
- *    data structure: do not delete it when done; treat it as a read-only
- *    structure.  Note that some routines (such as xaccAccountRemoveSplit())
- *    modify this list directly, and could leave you with a corrupted
- *    pointer.
+ * @note This GList belongs to the account: do not delete it when done;
+ *    treat it as a read-only structure.  The list is kept up to date as
+ *    splits are added to or removed from the account, so removing a
+ *    split (e.g. by xaccSplitSetAccount() or xaccSplitDestroy()) frees
+ *    its node; copy the list first to walk it while doing that.
  * @note This should be changed so that the returned value is a copy
  * of the list. No other part of the code should have access to the
  * internal data structure used by this object.
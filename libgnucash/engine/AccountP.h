@@ -115,10 +115,29 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
+    time64 balance_dirty_date;  /* splits posted from here on need a
+                                 * recompute, as do any that moved */
 
-    GList *splits;              /* list of split pointers */
+    GPtrArray *splits;          /* array of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
 
+    /* The GList copy of splits handed out by xaccAccountGetSplitList.
+     * Not built until it is first asked for (split_list_dirty is TRUE
+     * until then); afterwards kept in step with splits.
+     * split_list_nodes maps each split to its node in split_list, so
+     * keeping the list in step doesn't have to walk it. */
+    GList *split_list;
+    GHashTable *split_list_nodes;
+    gboolean split_list_dirty;
+
+    /* Copy of the sorted split array paired with each split's
+     * posted date, as of the last xaccAccountRecomputeBalance.  It lets
+     * the as-of-date balance lookups binary search instead of walking
+     * the splits, and lets the recompute skip the unchanged leading
+     * splits.  Only matches the split array while balance_dirty is
+     * FALSE. */
+    GArray *split_index;
+
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
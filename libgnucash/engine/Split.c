@@ -727,7 +727,9 @@ void mark_split (Split *s)
 {
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_sort_dirty (s->acc);
+        gnc_account_set_balance_dirty_from (s->acc,
+                                            xaccTransRetDatePosted (s->parent));
     }
 
     /* set dirty flag on lot too. */
@@ -1017,7 +1019,9 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_sort_dirty (acc);
+        gnc_account_set_balance_dirty_from (acc,
+                                            xaccTransRetDatePosted (s->parent));
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -2233,6 +2237,14 @@ qofSplitSetAccount(Split *s, QofInstance *ent)
     xaccSplitSetAccount(s, acc);
 }
 
+/* Changing a transaction's date or description only generates an
+ * event for the transaction, so its splits have to be re-indexed. */
+static GList *
+split_index_dependents (gpointer trans)
+{
+    return xaccTransGetSplitList (trans);
+}
+
 gboolean xaccSplitRegister (void)
 {
     static const QofParam params[] =
@@ -2333,6 +2345,26 @@ gboolean xaccSplitRegister (void)
     qof_class_register (SPLIT_CORR_ACCT_CODE,
                         (QofSortFunc)xaccSplitCompareOtherAccountCodes, NULL);
 
+    /* The parameters that register and report queries select on. */
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_ACCOUNT,
+                                                          QOF_PARAM_GUID, NULL),
+                              NULL, NULL);
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DATE_POSTED,
+                                                          NULL),
+                              GNC_ID_TRANS, split_index_dependents);
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_RECONCILE,
+                                                          NULL),
+                              NULL, NULL);
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DESCRIPTION,
+                                                          NULL),
+                              GNC_ID_TRANS, split_index_dependents);
+
     return qof_object_register (&split_object_def);
 }
 
@@ -29,6 +29,13 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+# include <io.h>
+# define fsync _commit
+#endif
 
 #include "Account.h"
 #include "Transaction.h"
@@ -80,14 +87,141 @@ static QofLogModule log_module = "gnc.translog";
  *     occurred at a certain time, it can be located.
  * (-) hack alert -- something better than just the account name
  *     is needed for identifying the account.
+ *
+ * If the durability is set to one of the asynchronous modes the records
+ * are written by a thread of their own.  xaccTransWriteLog formats each transaction into
+ * a string, since only the calling thread may look at the transaction,
+ * and puts it on a ring of LOG_QUEUE_SIZE slots.  The writer takes all
+ * the records queued since its last pass, writes them and flushes the
+ * file once for the lot.  Records are only ever added by the thread
+ * that edits the book and only removed by the writer, so each end of
+ * the ring is an index that just one thread moves; the mutex is only
+ * taken to sleep when there is nothing to write or no room to queue.
  */
 /* ------------------------------------------------------------------ */
 
+#define LOG_QUEUE_SIZE 256
 
 static int gen_logs = 1;
 static FILE * trans_log = NULL; /**< current log file handle */
 static char * trans_log_name = NULL; /**< current log file name */
 static char * log_base_name = NULL;
+static XaccLogDurability log_durability = XACC_LOG_SYNC;
+
+static GThread *log_writer = NULL;
+static GString *log_queue[LOG_QUEUE_SIZE];
+/* The count of records written and flushed, moved by the writer. */
+static gint log_queue_head = 0;
+/* The count of records queued, moved by xaccTransWriteLog. */
+static gint log_queue_tail = 0;
+static gint writer_waiting = 0;
+static gint logger_waiting = 0;
+static gint writer_stop = 0;
+static GMutex log_mutex;
+static GCond log_cond;
+
+/********************************************************************\
+\********************************************************************/
+
+static void
+wake_log_threads (void)
+{
+    g_mutex_lock (&log_mutex);
+    g_cond_broadcast (&log_cond);
+    g_mutex_unlock (&log_mutex);
+}
+
+static gpointer
+log_writer_thread (gpointer data)
+{
+    FILE *log = data;
+    gboolean sync_file = (log_durability == XACC_LOG_ASYNC_FSYNC);
+    guint head = (guint) log_queue_head;
+
+    while (TRUE)
+    {
+        guint tail = g_atomic_int_get (&log_queue_tail);
+
+        if (tail == head)
+        {
+            g_mutex_lock (&log_mutex);
+            g_atomic_int_set (&writer_waiting, 1);
+            while ((guint) g_atomic_int_get (&log_queue_tail) == head &&
+                   !g_atomic_int_get (&writer_stop))
+                g_cond_wait (&log_cond, &log_mutex);
+            g_atomic_int_set (&writer_waiting, 0);
+            g_mutex_unlock (&log_mutex);
+            /* Stopping only once everything queued is written. */
+            if ((guint) g_atomic_int_get (&log_queue_tail) == head)
+                break;
+            continue;
+        }
+
+        for (; head != tail; head++)
+        {
+            GString *record = log_queue[head % LOG_QUEUE_SIZE];
+            fwrite (record->str, 1, record->len, log);
+            g_string_free (record, TRUE);
+        }
+        fflush (log);
+        if (sync_file)
+            fsync (fileno (log));
+
+        /* The slots can only be reused once the records are out. */
+        g_atomic_int_set (&log_queue_head, (gint) head);
+        if (g_atomic_int_get (&logger_waiting))
+            wake_log_threads ();
+    }
+    return NULL;
+}
+
+/* Wait until the writer has no more than max_queued records left. */
+static void
+wait_for_log_writer (guint max_queued)
+{
+    if ((guint) log_queue_tail - (guint) g_atomic_int_get (&log_queue_head) <= max_queued)
+        return;
+
+    g_mutex_lock (&log_mutex);
+    g_atomic_int_set (&logger_waiting, 1);
+    while ((guint) log_queue_tail - (guint) g_atomic_int_get (&log_queue_head) >
+           max_queued)
+        g_cond_wait (&log_cond, &log_mutex);
+    g_atomic_int_set (&logger_waiting, 0);
+    g_mutex_unlock (&log_mutex);
+}
+
+static void
+queue_log_record (GString *record)
+{
+    guint tail = (guint) log_queue_tail;
+
+    wait_for_log_writer (LOG_QUEUE_SIZE - 1);
+    log_queue[tail % LOG_QUEUE_SIZE] = record;
+    g_atomic_int_set (&log_queue_tail, (gint) (tail + 1));
+    if (g_atomic_int_get (&writer_waiting))
+        wake_log_threads ();
+}
+
+static void
+start_log_writer (void)
+{
+    if (log_writer || !trans_log || log_durability == XACC_LOG_SYNC)
+        return;
+    log_writer = g_thread_new ("translog", log_writer_thread, trans_log);
+}
+
+/* Returns once everything queued has been written. */
+static void
+stop_log_writer (void)
+{
+    if (!log_writer) return;
+    g_atomic_int_set (&writer_stop, 1);
+    wake_log_threads ();
+    g_thread_join (log_writer);
+    log_writer = NULL;
+    writer_stop = 0;
+}
 
 /********************************************************************\
 \********************************************************************/
@@ -101,6 +235,30 @@ void xaccLogEnable  (void)
     gen_logs = 1;
 }
 
+void
+xaccLogSetDurability (XaccLogDurability durability)
+{
+    if (durability == log_durability) return;
+    stop_log_writer ();
+    log_durability = durability;
+    start_log_writer ();
+}
+
+XaccLogDurability
+xaccLogGetDurability (void)
+{
+    return log_durability;
+}
+
+void
+xaccLogFlush (void)
+{
+    if (log_writer)
+        wait_for_log_writer (0);
+    else if (trans_log)
+        fflush (trans_log);
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -202,6 +360,8 @@ xaccOpenLog (void)
              "notes\tmemo\taction\treconciled\t"
              "amount\tvalue\tdate_reconciled\n");
     fprintf (trans_log, "-----------------\n");
+
+    start_log_writer ();
 }
 
 /********************************************************************\
@@ -211,6 +371,7 @@ void
 xaccCloseLog (void)
 {
     if (!trans_log) return;
+    stop_log_writer ();
     fflush (trans_log);
     fclose (trans_log);
     trans_log = NULL;
@@ -219,6 +380,22 @@ xaccCloseLog (void)
 /********************************************************************\
 \********************************************************************/
 
+/* Add to the record being queued for the writer if there is one, or
+ * write straight to the file. */
+static void log_printf (GString *record, const char *format, ...) G_GNUC_PRINTF (2, 3);
+static void
+log_printf (GString *record, const char *format, ...)
+{
+    va_list args;
+
+    va_start (args, format);
+    if (record)
+        g_string_append_vprintf (record, format, args);
+    else
+        vfprintf (trans_log, format, args);
+    va_end (args);
+}
+
 void
 xaccTransWriteLog (Transaction *trans, char flag)
 {
@@ -227,6 +404,7 @@ xaccTransWriteLog (Transaction *trans, char flag)
     char split_guid_str[GUID_ENCODING_LENGTH + 1];
     const char *trans_notes;
     char dnow[100], dent[100], dpost[100], drecn[100];
+    GString *record;
 
     if (!gen_logs)
     {
@@ -240,7 +418,8 @@ xaccTransWriteLog (Transaction *trans, char flag)
     gnc_time64_to_iso8601_buff (trans->date_posted, dpost);
     guid_to_string_buff (xaccTransGetGUID(trans), trans_guid_str);
     trans_notes = xaccTransGetNotes(trans);
-    fprintf (trans_log, "===== START\n");
+    record = log_writer ? g_string_sized_new (512) : NULL;
+    log_printf (record, "===== START\n");
 
     for (node = trans->splits; node; node = node->next)
     {
@@ -268,33 +447,39 @@ xaccTransWriteLog (Transaction *trans, char flag)
         val = xaccSplitGetValue (split);
 
         /* use tab-separated fields */
-        fprintf (trans_log,
-                 "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
-                 "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
-                 flag,
-                 trans_guid_str, split_guid_str,  /* trans+split make up unique id */
-                 /* Note that the next three strings always exist,
-                 		* so we don't need to test them. */
-                 dnow,
-                 dent,
-                 dpost,
-                 acc_guid_str,
-                 accname ? accname : "",
-                 trans->num ? trans->num : "",
-                 trans->description ? trans->description : "",
-                 trans_notes ? trans_notes : "",
-                 split->memo ? split->memo : "",
-                 split->action ? split->action : "",
-                 split->reconciled,
-                 gnc_numeric_num(amt),
-                 gnc_numeric_denom(amt),
-                 gnc_numeric_num(val),
-                 gnc_numeric_denom(val),
-                 /* The next string always exists. No need to test it. */
-                 drecn);
+        log_printf (record,
+                    "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
+                    "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
+                    flag,
+                    trans_guid_str, split_guid_str,  /* trans+split make up unique id */
+                    /* Note that the next three strings always exist,
+                    		* so we don't need to test them. */
+                    dnow,
+                    dent,
+                    dpost,
+                    acc_guid_str,
+                    accname ? accname : "",
+                    trans->num ? trans->num : "",
+                    trans->description ? trans->description : "",
+                    trans_notes ? trans_notes : "",
+                    split->memo ? split->memo : "",
+                    split->action ? split->action : "",
+                    split->reconciled,
+                    gnc_numeric_num(amt),
+                    gnc_numeric_denom(amt),
+                    gnc_numeric_num(val),
+                    gnc_numeric_denom(val),
+                    /* The next string always exists. No need to test it. */
+                    drecn);
     }
 
-    fprintf (trans_log, "===== END\n");
+    log_printf (record, "===== END\n");
+
+    if (record)
+    {
+        queue_log_record (record);
+        return;
+    }
 
     /* get data out to the disk */
     fflush (trans_log);
@@ -46,7 +46,23 @@
 #include "Account.h"
 #include "Transaction.h"
 
+/** How far xaccTransWriteLog goes to get a transaction to the disk. */
+typedef enum
+{
+    /** Write and flush each transaction before returning.  This is the
+     *  default, so that the log has every transaction if GnuCash crashes. */
+    XACC_LOG_SYNC,
+    /** Queue each transaction for a writer thread, which writes what
+     *  has queued up and flushes once per batch.  Transactions still
+     *  queued are lost if GnuCash crashes. */
+    XACC_LOG_ASYNC,
+    /** As XACC_LOG_ASYNC, and also fsync the file after each batch so
+     *  that the log survives a crash of the whole system. */
+    XACC_LOG_ASYNC_FSYNC
+} XaccLogDurability;
+
 void    xaccOpenLog (void);
+/** Closes the log once everything queued for it has been written. */
 void    xaccCloseLog (void);
 void    xaccReopenLog (void);
 
@@ -71,6 +87,16 @@ void    xaccLogEnable (void);
 /** document me */
 void    xaccLogDisable (void);
 
+/** Set how transactions get to the disk; the log is written synchronously
+ *  unless this asks for otherwise.  Records already queued are written out
+ *  before the mode changes. */
+void    xaccLogSetDurability (XaccLogDurability durability);
+XaccLogDurability xaccLogGetDurability (void);
+
+/** Wait until every transaction logged so far has been written and
+ *  flushed to the file. */
+void    xaccLogFlush (void);
+
 /** The xaccLogSetBaseName() method sets the base filepath and the
  *    root part of the journal file name.  If the journal file is
  *    already open, it will close it and reopen it with the new
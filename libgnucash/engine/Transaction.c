@@ -234,6 +234,15 @@ void mark_trans (Transaction *trans)
     FOR_EACH_SPLIT(trans, mark_split(s));
 }
 
+/* Whether the transaction's slots mark it as closing a book. */
+static gboolean
+trans_kvp_is_closing (const Transaction *trans)
+{
+    GValue v = G_VALUE_INIT;
+    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, trans_is_closing_str);
+    return G_VALUE_HOLDS_INT64 (&v) && g_value_get_int64 (&v) != 0;
+}
+
 static inline void gen_event_trans (Transaction *trans);
 void gen_event_trans (Transaction *trans)
 {
@@ -1553,6 +1562,102 @@ static gboolean was_trans_emptied(Transaction *trans)
     return TRUE;
 }
 
+/* A book's bulk edit, kept in the book's data. */
+#define TRANS_BULK_EDIT "gnc-trans-bulk-edit"
+
+typedef struct
+{
+    gint depth;
+    /* The accounts held open until the bulk edit ends. */
+    GHashTable *accounts;
+} TransBulkEdit;
+
+static void
+bulk_edit_free (QofBook *book, gpointer key, gpointer data)
+{
+    TransBulkEdit *bulk = data;
+
+    g_hash_table_destroy (bulk->accounts);
+    g_free (bulk);
+}
+
+static void
+bulk_edit_hold_account (TransBulkEdit *bulk, Account *acc)
+{
+    if (!GNC_IS_ACCOUNT (acc) || g_hash_table_contains (bulk->accounts, acc))
+        return;
+    xaccAccountBeginEdit (acc);
+    g_hash_table_add (bulk->accounts, acc);
+}
+
+/* If the transaction's book is in a bulk edit, open the accounts its
+ * splits are joining or leaving, so that their splits are sorted and
+ * their balances computed when the bulk edit ends. */
+static void
+bulk_edit_hold_accounts (Transaction *trans)
+{
+    TransBulkEdit *bulk = qof_book_get_data (xaccTransGetBook (trans),
+                                             TRANS_BULK_EDIT);
+    GList *node;
+
+    if (!bulk || !bulk->depth) return;
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        bulk_edit_hold_account (bulk, s->acc);
+        bulk_edit_hold_account (bulk, s->orig_acc);
+    }
+}
+
+void
+gnc_book_begin_bulk_edit (QofBook *book)
+{
+    TransBulkEdit *bulk;
+
+    g_return_if_fail (book);
+    bulk = qof_book_get_data (book, TRANS_BULK_EDIT);
+    if (!bulk)
+    {
+        bulk = g_new0 (TransBulkEdit, 1);
+        bulk->accounts = g_hash_table_new (NULL, NULL);
+        qof_book_set_data_fin (book, TRANS_BULK_EDIT, bulk, bulk_edit_free);
+    }
+    if (bulk->depth++ > 0) return;
+
+    qof_event_begin_batch ();
+    qof_book_begin_deferred_commits (book);
+}
+
+void
+gnc_book_commit_bulk_edit (QofBook *book)
+{
+    TransBulkEdit *bulk;
+    GList *accounts, *node;
+    QofBackendError errcode;
+
+    g_return_if_fail (book);
+    bulk = qof_book_get_data (book, TRANS_BULK_EDIT);
+    if (!bulk || !bulk->depth)
+    {
+        PERR ("no bulk edit to commit");
+        return;
+    }
+    if (--bulk->depth > 0) return;
+
+    /* Committing the accounts can destroy splits, which mustn't
+     * hold any more accounts open. */
+    accounts = g_hash_table_get_keys (bulk->accounts);
+    g_hash_table_remove_all (bulk->accounts);
+    for (node = accounts; node; node = node->next)
+        xaccAccountCommitEdit (node->data);
+    g_list_free (accounts);
+
+    errcode = qof_book_end_deferred_commits (book);
+    if (errcode != ERR_BACKEND_NO_ERR)
+        gnc_engine_signal_commit_error (errcode);
+    qof_event_end_batch ();
+}
+
 static void trans_on_error(Transaction *trans, QofBackendError errcode)
 {
     /* If the backend puked, then we must roll-back
@@ -1685,6 +1790,12 @@ xaccTransCommitEdit (Transaction *trans)
         qof_instance_set_dirty(QOF_INSTANCE(trans));
     }
 
+    bulk_edit_hold_accounts (trans);
+
+    /* Cache the closing flag now, while only this thread can be looking
+     * at the transaction, so that xaccTransGetIsClosingTxn never writes. */
+    trans->isClosingTxn_cached = trans_kvp_is_closing (trans) ? 1 : 0;
+
     qof_commit_edit_part2(QOF_INSTANCE(trans),
                           (void (*) (QofInstance *, QofBackendError))
                           trans_on_error,
@@ -1738,6 +1849,7 @@ xaccTransRollbackEdit (Transaction *trans)
     trans->date_posted = orig->date_posted;
     SWAP(trans->common_currency, orig->common_currency);
     qof_instance_swap_kvp (QOF_INSTANCE (trans), QOF_INSTANCE (orig));
+    trans->isClosingTxn_cached = trans_kvp_is_closing (trans) ? 1 : 0;
 
     /* The splits at the front of trans->splits are exactly the same
        splits as in the original, but some of them may have changed, so
@@ -2360,16 +2472,10 @@ gboolean
 xaccTransGetIsClosingTxn (const Transaction *trans)
 {
     if (!trans) return FALSE;
+    /* The cache is only filled in on commit, so that this getter only
+     * reads and may be called from several threads at once. */
     if (trans->isClosingTxn_cached == -1)
-    {
-        Transaction* trans_nonconst = (Transaction*) trans;
-        GValue v = G_VALUE_INIT;
-        qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, trans_is_closing_str);
-        if (G_VALUE_HOLDS_INT64 (&v))
-            trans_nonconst->isClosingTxn_cached = (g_value_get_int64 (&v) ? 1 : 0);
-        else
-            trans_nonconst->isClosingTxn_cached = 0;
-    }
+        return trans_kvp_is_closing (trans);
     return (trans->isClosingTxn_cached == 1)
             ? TRUE
             : FALSE;
@@ -223,6 +223,26 @@ void          xaccTransRollbackEdit (Transaction *trans);
  */
 gboolean      xaccTransIsOpen (const Transaction *trans);
 
+/** The gnc_book_begin_bulk_edit() routine starts a bulk edit of the
+    book's transactions, for code that creates or changes many of
+    them at once.  Until the matching gnc_book_commit_bulk_edit():
+    - each account that a committed transaction touches is held open
+      for editing, so its splits are sorted and its balances computed
+      once, at the end, and reading them in the meantime gives stale
+      values;
+    - commits to the backend are held back (see
+      qof_book_begin_deferred_commits());
+    - events go to batch handlers in one batch (see
+      qof_event_begin_batch()).
+    Each commit still scrubs the transaction and writes it to the
+    transaction log.  Calls may be nested. */
+void          gnc_book_begin_bulk_edit (QofBook *book);
+
+/** The gnc_book_commit_bulk_edit() routine ends a bulk edit, committing
+    the accounts it held open and the backend commits it held back.  A
+    backend error is reported through gnc_engine_signal_commit_error(). */
+void          gnc_book_commit_bulk_edit (QofBook *book);
+
 /** The xaccTransLookup() subroutine will return the
     transaction associated with the given id, or NULL
     if there is no such transaction. */
@@ -226,6 +226,7 @@ SplitList * qof_query_run_subquery (QofQuery *q, const QofQuery *q);
 %ignore GNC_ERROR_OVERFLOW;
 %ignore GNC_ERROR_DENOM_DIFF;
 %ignore GNC_ERROR_REMAINDER;
+%ignore gnc_numeric_sum;
 %include <gnc-numeric.h>
 
 time64 time64CanonicalDayTime(time64 t);
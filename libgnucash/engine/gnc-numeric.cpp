@@ -40,6 +40,7 @@ extern "C"
 #include <boost/locale/encoding_utf.hpp>
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
 
 #include "gnc-numeric.hpp"
 #include "gnc-rational.hpp"
@@ -799,6 +800,102 @@ gnc_numeric_add(gnc_numeric a, gnc_numeric b,
     }
 }
 
+/* *******************************************************************
+ *  gnc_numeric_sum
+ ********************************************************************/
+
+/* Add up the numerators of n values.  Each is split into its high and
+ * low 32 bits, whose sums can't overflow 64-bit integers for up to 2^31
+ * values, so the inner loop is plain branch-free integer addition that
+ * the compiler can vectorize. */
+static GncInt128
+sum_numerators (const gnc_numeric *values, size_t n)
+{
+    const size_t block = size_t (1) << 31;
+    GncInt128 total;
+
+    while (n > 0)
+    {
+        size_t len = std::min (n, block);
+        int64_t high = 0;
+        uint64_t low = 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            high += values[i].num >> 32;
+            low += static_cast<uint64_t>(values[i].num) & UINT64_C(0xffffffff);
+        }
+        total += (GncInt128 (high) << 32) + GncInt128 (low);
+        values += len;
+        n -= len;
+    }
+    return total;
+}
+
+gnc_numeric
+gnc_numeric_sum(const gnc_numeric *values, gsize n_values,
+                gint64 denom, gint how)
+{
+    GncRational sum;
+    gsize i = 0;
+
+    if (!values && n_values)
+        return gnc_numeric_error(GNC_ERROR_ARG);
+    try
+    {
+        while (i < n_values)
+        {
+            gint64 run_denom = values[i].denom;
+            gsize end = i + 1;
+
+            if (run_denom <= 0)
+            {
+                if (gnc_numeric_check(values[i]))
+                    return gnc_numeric_error(GNC_ERROR_ARG);
+                sum += GncRational(values[i]);
+                i = end;
+                continue;
+            }
+            /* The common case: a run of values with the same
+             * denominator is summed as integers. */
+            while (end < n_values && values[end].denom == run_denom)
+                ++end;
+            sum += GncRational(sum_numerators(values + i, end - i),
+                               run_denom);
+            i = end;
+        }
+        if ((how & GNC_NUMERIC_DENOM_MASK) != GNC_HOW_DENOM_EXACT)
+            return static_cast<gnc_numeric>(convert(GncNumeric(sum), denom,
+                                                    how));
+        if (denom == GNC_DENOM_AUTO &&
+            (how & GNC_NUMERIC_RND_MASK) != GNC_HOW_RND_NEVER)
+            return static_cast<gnc_numeric>(sum.round_to_numeric());
+        sum = convert(sum, denom, how);
+        if (sum.is_big() || !sum.valid())
+            return gnc_numeric_error(GNC_ERROR_OVERFLOW);
+        return static_cast<gnc_numeric>(sum);
+    }
+    catch (const std::overflow_error& err)
+    {
+        PWARN("%s", err.what());
+        return gnc_numeric_error(GNC_ERROR_OVERFLOW);
+    }
+    catch (const std::invalid_argument& err)
+    {
+        PWARN("%s", err.what());
+        return gnc_numeric_error(GNC_ERROR_ARG);
+    }
+    catch (const std::underflow_error& err)
+    {
+        PWARN("%s", err.what());
+        return gnc_numeric_error(GNC_ERROR_OVERFLOW);
+    }
+    catch (const std::domain_error& err)
+    {
+        PWARN("%s", err.what());
+        return gnc_numeric_error(GNC_ERROR_REMAINDER);
+    }
+}
+
 /* *******************************************************************
  *  gnc_numeric_sub
  ********************************************************************/
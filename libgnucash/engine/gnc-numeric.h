@@ -444,6 +444,25 @@ gnc_numeric gnc_numeric_sub_fixed(gnc_numeric a, gnc_numeric b)
     return gnc_numeric_sub(a, b, GNC_DENOM_AUTO,
                            GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
 }
+
+/** Return the sum of n_values values.
+ *
+ *  The sum is computed exactly and then converted to denom as directed
+ *  by how, so unlike a chain of gnc_numeric_add() calls it is rounded
+ *  only once.  Runs of values sharing a denominator, the usual case
+ *  for amounts in one commodity, are summed as plain integers.  With
+ *  GNC_DENOM_AUTO and GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER, values
+ *  that all share a denominator sum to what adding them with
+ *  gnc_numeric_add_fixed() gives, in that denominator.  Values with
+ *  different denominators are not an error as they are for
+ *  gnc_numeric_add_fixed(): they sum exactly over their least common
+ *  denominator.
+ *
+ *  Returns an error if any of the values is one or if the sum doesn't
+ *  fit, and zero if n_values is 0.
+ */
+gnc_numeric gnc_numeric_sum(const gnc_numeric *values, gsize n_values,
+                            gint64 denom, gint how);
 /** @} */
 
 
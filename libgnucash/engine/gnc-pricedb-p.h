@@ -56,6 +56,9 @@ struct gnc_price_db_s
 {
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
+    GHashTable *pair_index;        /* sorted price arrays per commodity pair */
+    GHashTable *conversion_cache;  /* prices used by balance conversions */
+    gint price_event_handler_id;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
     gboolean reset_nth_price_cache;
 };
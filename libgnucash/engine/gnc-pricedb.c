@@ -40,10 +40,6 @@ static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         time64 t, gboolean sameday);
-static gboolean
-pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
-                            gpointer user_data);
 
 enum
 {
@@ -831,8 +827,199 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
    description of GNCPrice lists).  The top-level key is the commodity
    you want the prices for, and the second level key is the commodity
    that the value is expressed in terms of.
+
+   Alongside that it keeps a pair index: for each unordered pair of
+   commodities that has been looked up, a contiguous array of the
+   prices in both directions sorted most-recent-first, so that the
+   time based lookups can binary search instead of merging and walking
+   the two lists.  An entry is dropped whenever a price of that pair is
+   added or removed and rebuilt on the next lookup.
  */
 
+typedef struct
+{
+    const gnc_commodity *first;   /* the lower addressed of the two */
+    const gnc_commodity *second;
+} PricePair;
+
+typedef struct
+{
+    time64 time;
+    GNCPrice *price;
+} PriceIndexEntry;
+
+static void
+price_pair_init (PricePair *pair, const gnc_commodity *a,
+                 const gnc_commodity *b)
+{
+    pair->first = a < b ? a : b;
+    pair->second = a < b ? b : a;
+}
+
+static guint
+price_pair_hash (gconstpointer key)
+{
+    const PricePair *pair = key;
+    return g_direct_hash (pair->first) * 33 + g_direct_hash (pair->second);
+}
+
+static gboolean
+price_pair_equal (gconstpointer a, gconstpointer b)
+{
+    const PricePair *pa = a, *pb = b;
+    return pa->first == pb->first && pa->second == pb->second;
+}
+
+static void
+price_index_free (gpointer data)
+{
+    g_array_free ((GArray *) data, TRUE);
+}
+
+static GList *
+pricedb_lookup_price_list (GNCPriceDB *db, const gnc_commodity *commodity,
+                           const gnc_commodity *currency)
+{
+    GHashTable *currency_hash = g_hash_table_lookup (db->commodity_hash,
+                                                     commodity);
+    return currency_hash ? g_hash_table_lookup (currency_hash, currency) : NULL;
+}
+
+/* Return the index of the prices between a and b, building it from the
+ * two price lists if need be, or NULL if there are no such prices.  The
+ * prices in the index are not reffed; the index belongs to the db. */
+static const GArray *
+pricedb_get_pair_index (GNCPriceDB *db, const gnc_commodity *a,
+                        const gnc_commodity *b)
+{
+    PricePair pair, *key;
+    GArray *index;
+    GList *forward, *reverse;
+
+    price_pair_init (&pair, a, b);
+    index = g_hash_table_lookup (db->pair_index, &pair);
+    if (index)
+        return index;
+
+    forward = pricedb_lookup_price_list (db, a, b);
+    reverse = pricedb_lookup_price_list (db, b, a);
+    if (!forward && !reverse)
+        return NULL;
+
+    /* Both lists are already sorted most recent first, so merge them. */
+    index = g_array_sized_new (FALSE, FALSE, sizeof (PriceIndexEntry),
+                               g_list_length (forward) +
+                               g_list_length (reverse));
+    while (forward || reverse)
+    {
+        PriceIndexEntry entry;
+        if (!reverse ||
+            (forward && compare_prices_by_date (forward->data,
+                                                reverse->data) < 0))
+        {
+            entry.price = forward->data;
+            forward = forward->next;
+        }
+        else
+        {
+            entry.price = reverse->data;
+            reverse = reverse->next;
+        }
+        entry.time = gnc_price_get_time64 (entry.price);
+        g_array_append_val (index, entry);
+    }
+
+    key = g_new (PricePair, 1);
+    *key = pair;
+    g_hash_table_insert (db->pair_index, key, index);
+    return index;
+}
+
+static void
+pricedb_invalidate_pair_index (GNCPriceDB *db, const gnc_commodity *a,
+                               const gnc_commodity *b)
+{
+    PricePair pair;
+    if (!db->pair_index) return;
+    price_pair_init (&pair, a, b);
+    g_hash_table_remove (db->pair_index, &pair);
+}
+
+/* Return the position of the first (i.e. most recent) price among the
+ * first hi entries of index that isn't newer than t, or hi if all are. */
+static guint
+price_index_first_not_after (const GArray *index, guint hi, time64 t)
+{
+    guint lo = 0;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index (index, PriceIndexEntry, mid).time > t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The conversion cache remembers, for each (from, to, time) that
+ * gnc_pricedb_convert_balance_* has been asked about, which prices the
+ * conversion uses.  Like the pair index it doesn't ref the prices: the
+ * whole cache is flushed whenever a price is added, removed or changed. */
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    time64 time;
+} ConversionKey;
+
+typedef struct
+{
+    ConversionKey key;
+    GNCPrice *direct;           /* price between from and to, if any */
+    gboolean indirect_done;     /* via_from and via_to have been looked up */
+    GNCPrice *via_from;         /* prices linking from and to through */
+    GNCPrice *via_to;           /* a third commodity, if any */
+} ConversionRate;
+
+static guint
+conversion_key_hash (gconstpointer key)
+{
+    const ConversionKey *ck = key;
+    return (g_direct_hash (ck->from) * 33 + g_direct_hash (ck->to)) * 33 +
+           g_int64_hash (&ck->time);
+}
+
+static gboolean
+conversion_key_equal (gconstpointer a, gconstpointer b)
+{
+    const ConversionKey *ka = a, *kb = b;
+    return ka->from == kb->from && ka->to == kb->to && ka->time == kb->time;
+}
+
+static void
+pricedb_flush_conversion_cache (GNCPriceDB *db)
+{
+    if (db->conversion_cache)
+        g_hash_table_remove_all (db->conversion_cache);
+}
+
+static void
+pricedb_price_event_handler (QofInstance *ent, QofEventId event_type,
+                             gpointer user_data, gpointer event_data)
+{
+    GNCPriceDB *db = user_data;
+
+    if (!GNC_IS_PRICE (ent))
+        return;
+    if ((event_type & (QOF_EVENT_MODIFY | QOF_EVENT_ADD | QOF_EVENT_REMOVE |
+                       QOF_EVENT_DESTROY)) == 0)
+        return;
+    if (qof_instance_get_book (ent) != qof_instance_get_book (&db->inst))
+        return;
+    pricedb_flush_conversion_cache (db);
+}
+
 /* GObject Initialization */
 QOF_GOBJECT_IMPL(gnc_pricedb, GNCPriceDB, QOF_TYPE_INSTANCE);
 
@@ -882,6 +1069,14 @@ gnc_pricedb_create(QofBook * book)
 
     result->commodity_hash = g_hash_table_new(NULL, NULL);
     g_return_val_if_fail (result->commodity_hash, NULL);
+    result->pair_index = g_hash_table_new_full (price_pair_hash,
+                                                price_pair_equal,
+                                                g_free, price_index_free);
+    result->conversion_cache = g_hash_table_new_full (conversion_key_hash,
+                                                      conversion_key_equal,
+                                                      NULL, g_free);
+    result->price_event_handler_id =
+        qof_event_register_handler (pricedb_price_event_handler, result);
     return result;
 }
 
@@ -921,6 +1116,12 @@ void
 gnc_pricedb_destroy(GNCPriceDB *db)
 {
     if (!db) return;
+    if (db->price_event_handler_id)
+        qof_event_unregister_handler (db->price_event_handler_id);
+    db->price_event_handler_id = 0;
+    if (db->conversion_cache)
+        g_hash_table_destroy (db->conversion_cache);
+    db->conversion_cache = NULL;
     if (db->commodity_hash)
     {
         g_hash_table_foreach (db->commodity_hash,
@@ -929,6 +1130,9 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    if (db->pair_index)
+        g_hash_table_destroy (db->pair_index);
+    db->pair_index = NULL;
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -1137,6 +1341,8 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         LEAVE ("gnc_price_list_insert failed");
         return FALSE;
     }
+    pricedb_invalidate_pair_index (db, commodity, currency);
+    pricedb_flush_conversion_cache (db);
 
     if (!price_list)
     {
@@ -1239,6 +1445,8 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
         LEAVE (" cannot remove price list");
         return FALSE;
     }
+    pricedb_invalidate_pair_index (db, commodity, currency);
+    pricedb_flush_conversion_cache (db);
 
     /* if the price list is empty, then remove this currency from the
        commodity hash */
@@ -1789,92 +1997,87 @@ GNCPrice *gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
+    const GArray *index;
     GNCPrice *result;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+    index = pricedb_get_pair_index(db, commodity, currency);
+    if (!index) return NULL;
+    /* The index is sorted most recent first, so return the first. */
+    result = g_array_index (index, PriceIndexEntry, 0).price;
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE("price is %p", result);
     return result;
 }
 
 typedef struct
 {
-    GList **list;
     const gnc_commodity *com;
-    time64 t;
-} UsesCommodity;
-
-/* price_list_scan_any_currency is the helper function used with
- * pricedb_pricelist_traversal by the "any_currency" price lookup functions. It
- * builds a list of prices that are either to or from the commodity "com".
- * The resulting list will include the last price newer than "t" and the first
- * price older than "t".  All other prices will be ignored.  Since in the most
- * common cases we will be looking for recent prices which are at the front of
- * the various price lists, this is considerably faster than concatenating all
- * the relevant price lists and sorting the result.
-*/
+    GHashTable *others;
+} PricedCommodities;
 
-static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+static void
+add_priced_currency (gpointer key, gpointer val, gpointer user_data)
 {
-    UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
-    gnc_commodity *com;
-    gnc_commodity *cur;
+    g_hash_table_insert ((GHashTable*)user_data, key, key);
+}
 
-    if (!price_list)
-        return TRUE;
+static void
+add_priced_commodity (gpointer key, gpointer val, gpointer user_data)
+{
+    PricedCommodities *data = (PricedCommodities*)user_data;
+    if (g_hash_table_lookup ((GHashTable*)val, data->com))
+        g_hash_table_insert (data->others, key, key);
+}
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
+/* pricedb_scan_any_currency is the helper used by the "any_currency" price
+ * lookup functions. For each commodity that has prices to or from com it
+ * returns the last price newer than "t" and the first price older than "t",
+ * found by binary search in the pair index.  All other prices are ignored.
+ * The prices in the returned list are reffed.
+ */
+static PriceList *
+pricedb_scan_any_currency (GNCPriceDB *db, const gnc_commodity *com, time64 t)
+{
+    PricedCommodities data = {com, g_hash_table_new (NULL, NULL)};
+    GHashTable *currency_hash;
+    GHashTableIter iter;
+    gpointer other;
+    PriceList *result = NULL;
 
-    /* if this price list isn't for the commodity we are interested in,
-       ignore it. */
-    if (com != helper->com && cur != helper->com)
-        return TRUE;
+    currency_hash = g_hash_table_lookup (db->commodity_hash, com);
+    if (currency_hash)
+        g_hash_table_foreach (currency_hash, add_priced_currency, data.others);
+    g_hash_table_foreach (db->commodity_hash, add_priced_commodity, &data);
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    while (node != NULL)
+    g_hash_table_iter_init (&iter, data.others);
+    while (g_hash_table_iter_next (&iter, &other, NULL))
     {
-        GNCPrice *price = node->data;
-        time64 price_t = gnc_price_get_time64(price);
-        if (price_t < helper->t)
+        const GArray *index = pricedb_get_pair_index (db, com, other);
+        guint pos;
+        GNCPrice *price;
+
+        if (!index) continue;
+        /* The first price older than t ... */
+        pos = price_index_first_not_after (index, index->len, t - 1);
+        if (pos < index->len)
         {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
+            price = g_array_index (index, PriceIndexEntry, pos).price;
+            gnc_price_ref (price);
+            result = g_list_prepend (result, price);
         }
-        else if (node->next == NULL)
+        /* ... and the one just before it, or the oldest if all are newer. */
+        if (pos > 0)
         {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
+            price = g_array_index (index, PriceIndexEntry, pos - 1).price;
+            gnc_price_ref (price);
+            result = g_list_prepend (result, price);
         }
-        node = node->next;
     }
-
-    return TRUE;
+    g_hash_table_destroy (data.others);
+    return result;
 }
 
 static gboolean
@@ -2033,13 +2236,12 @@ gnc_pricedb_lookup_nearest_in_time_any_currency_t64(GNCPriceDB *db,
                                                     time64 t)
 {
     GList *prices = NULL, *result;
-    UsesCommodity helper = {&prices, commodity, t};
     result = NULL;
 
     if (!db || !commodity) return NULL;
     ENTER ("db=%p commodity=%p", db, commodity);
 
-    pricedb_pricelist_traversal(db, price_list_scan_any_currency, &helper);
+    prices = pricedb_scan_any_currency(db, commodity, t);
     prices = g_list_sort(prices, compare_prices_by_date);
     result = nearest_to(prices, commodity, t);
     gnc_price_list_destroy(prices);
@@ -2053,14 +2255,12 @@ gnc_pricedb_lookup_latest_before_any_currency_t64(GNCPriceDB *db,
                                                   time64 t)
 {
     GList *prices = NULL, *result;
-    UsesCommodity helper = {&prices, commodity, t};
     result = NULL;
 
     if (!db || !commodity) return NULL;
     ENTER ("db=%p commodity=%p", db, commodity);
 
-    pricedb_pricelist_traversal(db, price_list_scan_any_currency,
-                                       &helper);
+    prices = pricedb_scan_any_currency(db, commodity, t);
     prices = g_list_sort(prices, compare_prices_by_date);
     result = latest_before(prices, commodity, t);
     gnc_price_list_destroy(prices);
@@ -2255,140 +2455,134 @@ gnc_pricedb_lookup_at_time64(GNCPriceDB *db,
                              const gnc_commodity *currency,
                              time64 t)
 {
-    GList *price_list;
-    GList *item = NULL;
+    const GArray *index;
+    guint pos;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    index = pricedb_get_pair_index (db, c, currency);
+    if (index)
     {
-        GNCPrice *p = item->data;
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time == t)
+        pos = price_index_first_not_after (index, index->len, t);
+        if (pos < index->len &&
+            g_array_index (index, PriceIndexEntry, pos).time == t)
         {
+            GNCPrice *p = g_array_index (index, PriceIndexEntry, pos).price;
             gnc_price_ref(p);
-            g_list_free (price_list);
             LEAVE("price is %p", p);
             return p;
         }
-        item = item->next;
     }
-    g_list_free (price_list);
     LEAVE (" ");
     return NULL;
 }
 
+/* Pick the price in index nearest to t, given the position of the
+ * first price that isn't newer than t.  Returns an unreffed price. */
 static GNCPrice *
-lookup_nearest_in_time(GNCPriceDB *db,
-                       const gnc_commodity *c,
-                       const gnc_commodity *currency,
-                       time64 t,
-                       gboolean sameday)
+price_index_nearest (const GArray *index, guint pos, time64 t,
+                     gboolean sameday)
 {
-    GList *price_list;
-    GNCPrice *current_price = NULL;
+    GNCPrice *current_price;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
-
-    if (!db || !c || !currency) return NULL;
-    if (t == INT64_MAX) return NULL;
-    ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
 
-    /* default answer */
-    current_price = item->data;
+    /* current_price is the oldest price newer than t, or the latest price
+     * if there is none; next_price the first one that isn't newer. */
+    current_price = g_array_index (index, PriceIndexEntry,
+                                   pos > 0 ? pos - 1 : 0).price;
+    if (pos < index->len)
+        next_price = g_array_index (index, PriceIndexEntry, pos).price;
 
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
+    if (!next_price)
     {
-        GNCPrice *p = item->data;
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time <= t)
+        /* It's earlier than the last price on the list */
+        result = current_price;
+        if (sameday)
         {
-            next_price = item->data;
-            break;
+            /* Must be on the same day. */
+            time64 price_day;
+            time64 t_day;
+            price_day = time64CanonicalDayTime(gnc_price_get_time64(current_price));
+            t_day = time64CanonicalDayTime(t);
+            if (price_day != t_day)
+                result = NULL;
         }
-        current_price = item->data;
-        item = item->next;
     }
-
-    if (current_price)      /* How can this be null??? */
+    else
     {
-        if (!next_price)
+        /* If the requested time is not earlier than the first price on the
+           list, then current_price and next_price will be the same. */
+        time64 current_t = gnc_price_get_time64(current_price);
+        time64 next_t = gnc_price_get_time64(next_price);
+        time64 diff_current = current_t - t;
+        time64 diff_next = next_t - t;
+        time64 abs_current = llabs(diff_current);
+        time64 abs_next = llabs(diff_next);
+
+        if (sameday)
         {
-            /* It's earlier than the last price on the list */
-            result = current_price;
-            if (sameday)
+            /* Result must be on same day, see if either of the two isn't */
+            time64 t_day = time64CanonicalDayTime(t);
+            time64 current_day = time64CanonicalDayTime(current_t);
+            time64 next_day = time64CanonicalDayTime(next_t);
+            if (current_day == t_day)
             {
-                /* Must be on the same day. */
-                time64 price_day;
-                time64 t_day;
-                price_day = time64CanonicalDayTime(gnc_price_get_time64(current_price));
-                t_day = time64CanonicalDayTime(t);
-                if (price_day != t_day)
-                    result = NULL;
+                if (next_day == t_day)
+                {
+                    /* Both on same day, return nearest */
+                    if (abs_current < abs_next)
+                        result = current_price;
+                    else
+                        result = next_price;
+                }
+                else
+                    /* current_price on same day, next_price not */
+                    result = current_price;
             }
+            else if (next_day == t_day)
+                /* next_price on same day, current_price not */
+                result = next_price;
         }
         else
         {
-            /* If the requested time is not earlier than the first price on the
-               list, then current_price and next_price will be the same. */
-            time64 current_t = gnc_price_get_time64(current_price);
-            time64 next_t = gnc_price_get_time64(next_price);
-            time64 diff_current = current_t - t;
-            time64 diff_next = next_t - t;
-            time64 abs_current = llabs(diff_current);
-            time64 abs_next = llabs(diff_next);
-
-            if (sameday)
+            /* Choose the price that is closest to the given time. In case of
+             * a tie, prefer the older price since it actually existed at the
+             * time. (This also fixes bug #541970.) */
+            if (abs_current < abs_next)
             {
-                /* Result must be on same day, see if either of the two isn't */
-                time64 t_day = time64CanonicalDayTime(t);
-                time64 current_day = time64CanonicalDayTime(current_t);
-                time64 next_day = time64CanonicalDayTime(next_t);
-                if (current_day == t_day)
-                {
-                    if (next_day == t_day)
-                    {
-                        /* Both on same day, return nearest */
-                        if (abs_current < abs_next)
-                            result = current_price;
-                        else
-                            result = next_price;
-                    }
-                    else
-                        /* current_price on same day, next_price not */
-                        result = current_price;
-                }
-                else if (next_day == t_day)
-                    /* next_price on same day, current_price not */
-                    result = next_price;
+                result = current_price;
             }
             else
             {
-                /* Choose the price that is closest to the given time. In case of
-                 * a tie, prefer the older price since it actually existed at the
-                 * time. (This also fixes bug #541970.) */
-                if (abs_current < abs_next)
-                {
-                    result = current_price;
-                }
-                else
-                {
-                    result = next_price;
-                }
+                result = next_price;
             }
         }
     }
+    return result;
+}
+
+static GNCPrice *
+lookup_nearest_in_time(GNCPriceDB *db,
+                       const gnc_commodity *c,
+                       const gnc_commodity *currency,
+                       time64 t,
+                       gboolean sameday)
+{
+    const GArray *index;
+    GNCPrice *result;
 
+    if (!db || !c || !currency) return NULL;
+    if (t == INT64_MAX) return NULL;
+    ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
+    index = pricedb_get_pair_index (db, c, currency);
+    if (!index) return NULL;
+
+    result = price_index_nearest (index,
+                                  price_index_first_not_after (index,
+                                                               index->len, t),
+                                  t, sameday);
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2403,66 +2597,108 @@ gnc_pricedb_lookup_nearest_in_time64(GNCPriceDB *db,
 }
 
 
+/* Order lookup requests by commodity, then by time. */
+static gint
+compare_price_requests (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const GNCPriceRequest *requests = user_data;
+    const GNCPriceRequest *ra = &requests[*(const guint*)a];
+    const GNCPriceRequest *rb = &requests[*(const guint*)b];
+
+    if (ra->commodity != rb->commodity)
+        return ra->commodity < rb->commodity ? -1 : 1;
+    return time64_cmp (ra->time, rb->time);
+}
+
+void
+gnc_pricedb_lookup_nearest_in_time64_batch (GNCPriceDB *db,
+                                            const gnc_commodity *currency,
+                                            GNCPriceRequest *requests,
+                                            guint n_requests)
+{
+    guint *order;
+    guint i = 0;
+
+    if (!requests) return;
+    for (i = 0; i < n_requests; ++i)
+        requests[i].price = NULL;
+    if (!db || !currency) return;
+    ENTER ("db=%p currency=%p requests=%u", db, currency, n_requests);
+
+    /* Visit the requests grouped by commodity in increasing time, so that
+     * each pair index is looked up once and, since it is sorted most
+     * recent first, each search only needs to look in front of the
+     * previous position. */
+    order = g_new (guint, n_requests);
+    for (i = 0; i < n_requests; ++i)
+        order[i] = i;
+    g_qsort_with_data (order, n_requests, sizeof (guint),
+                       compare_price_requests, requests);
+
+    i = 0;
+    while (i < n_requests)
+    {
+        const gnc_commodity *commodity = requests[order[i]].commodity;
+        const GArray *index = NULL;
+        guint limit;
+
+        if (commodity)
+            index = pricedb_get_pair_index (db, commodity, currency);
+        limit = index ? index->len : 0;
+
+        for (; i < n_requests && requests[order[i]].commodity == commodity; ++i)
+        {
+            GNCPriceRequest *request = &requests[order[i]];
+            guint pos;
+
+            if (!index || request->time == INT64_MAX) continue;
+            pos = price_index_first_not_after (index, limit, request->time);
+            request->price = price_index_nearest (index, pos, request->time,
+                                                  FALSE);
+            gnc_price_ref (request->price);
+            limit = pos;
+        }
+    }
+
+    g_free (order);
+    LEAVE (" ");
+}
+
 GNCPrice *
 gnc_pricedb_lookup_latest_before_t64 (GNCPriceDB *db,
                                       gnc_commodity *c,
                                       gnc_commodity *currency,
                                       time64 t)
 {
-    GList *price_list;
+    const GArray *index;
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    time64 price_time;
+    guint pos;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time64 (item->data);
-        if (price_time <= t)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (price_time > t && item);
+    index = pricedb_get_pair_index (db, c, currency);
+    if (!index) return NULL;
+    pos = price_index_first_not_after (index, index->len, t);
+    if (pos < index->len)
+        current_price = g_array_index (index, PriceIndexEntry, pos).price;
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
 
 static gnc_numeric
-direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                           const gnc_commodity *from, const gnc_commodity *to,
-                           time64 t)
+direct_balance_conversion (gnc_numeric bal, const gnc_commodity *from,
+                           const gnc_commodity *to, GNCPrice *price)
 {
-    GNCPrice *price;
-    gnc_numeric retval = gnc_numeric_zero();
-    if (from == NULL || to == NULL)
-        return retval;
-    if (gnc_numeric_zero_p(bal))
-        return retval;
-    if (t != INT64_MAX)
-        price = gnc_pricedb_lookup_nearest_in_time64(db, from, to, t);
-    else
-        price = gnc_pricedb_lookup_latest(db, from, to);
     if (price == NULL)
-        return retval;
+        return gnc_numeric_zero();
     if (gnc_price_get_commodity(price) == from)
-        retval = gnc_numeric_mul (bal, gnc_price_get_value (price),
-                                  gnc_commodity_get_fraction (to),
-                                  GNC_HOW_RND_ROUND);
-    else
-        retval = gnc_numeric_div (bal, gnc_price_get_value (price),
-                                  gnc_commodity_get_fraction (to),
-                                  GNC_HOW_RND_ROUND);
-    gnc_price_unref (price);
-    return retval;
-
+        return gnc_numeric_mul (bal, gnc_price_get_value (price),
+                                gnc_commodity_get_fraction (to),
+                                GNC_HOW_RND_ROUND);
+    return gnc_numeric_div (bal, gnc_price_get_value (price),
+                            gnc_commodity_get_fraction (to),
+                            GNC_HOW_RND_ROUND);
 }
 
 typedef struct
@@ -2543,18 +2779,43 @@ convert_balance(gnc_numeric bal, const gnc_commodity *from,
                            fraction, GNC_HOW_RND_ROUND);
 
 }
-static gnc_numeric
-indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                             const gnc_commodity *from, const gnc_commodity *to,
-                             time64 t )
+/* Return the cached conversion between from and to at time t, where
+ * INT64_MAX stands for the latest price, looking up the direct price the
+ * first time the triple is seen. */
+static ConversionRate *
+pricedb_lookup_conversion_rate (GNCPriceDB *db, const gnc_commodity *from,
+                                const gnc_commodity *to, time64 t)
+{
+    ConversionKey key = {from, to, t};
+    ConversionRate *rate = g_hash_table_lookup (db->conversion_cache, &key);
+    GNCPrice *price;
+
+    if (rate)
+        return rate;
+
+    if (t != INT64_MAX)
+        price = gnc_pricedb_lookup_nearest_in_time64(db, from, to, t);
+    else
+        price = gnc_pricedb_lookup_latest(db, from, to);
+    rate = g_new0 (ConversionRate, 1);
+    rate->key = key;
+    rate->direct = price;
+    /* The db holds on to the price; the cache doesn't need a ref. */
+    gnc_price_unref (price);
+    g_hash_table_insert (db->conversion_cache, &rate->key, rate);
+    return rate;
+}
+
+/* Fill in the prices for converting through a third commodity. */
+static void
+conversion_rate_find_indirect (GNCPriceDB *db, ConversionRate *rate)
 {
     GList *from_prices = NULL, *to_prices = NULL;
+    const gnc_commodity *from = rate->key.from, *to = rate->key.to;
+    time64 t = rate->key.time;
     PriceTuple tuple;
-    gnc_numeric zero = gnc_numeric_zero();
-    if (from == NULL || to == NULL)
-        return zero;
-    if (gnc_numeric_zero_p(bal))
-        return zero;
+
+    rate->indirect_done = TRUE;
     if (t == INT64_MAX)
     {
         from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
@@ -2572,34 +2833,41 @@ indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
                                                                     to, t);
     }
     if (from_prices == NULL || to_prices == NULL)
-        return zero;
+    {
+        gnc_price_list_destroy(from_prices);
+        gnc_price_list_destroy(to_prices);
+        return;
+    }
     tuple = extract_common_prices(from_prices, to_prices, from, to);
     gnc_price_list_destroy(from_prices);
     gnc_price_list_destroy(to_prices);
-    if (tuple.from)
-        return convert_balance(bal, from, to, tuple);
-    return zero;
+    rate->via_from = tuple.from;
+    rate->via_to = tuple.to;
+    gnc_price_unref (tuple.from);
+    gnc_price_unref (tuple.to);
 }
 
-
-/*
- * Convert a balance from one currency to another.
- */
-gnc_numeric
-gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
-        gnc_numeric balance,
-        const gnc_commodity *balance_currency,
-        const gnc_commodity *new_currency)
+static gnc_numeric
+pricedb_convert_balance (GNCPriceDB *pdb, gnc_numeric balance,
+                         const gnc_commodity *balance_currency,
+                         const gnc_commodity *new_currency, time64 t)
 {
+    ConversionRate *rate;
+    PriceTuple tuple;
     gnc_numeric new_value;
 
     if (gnc_numeric_zero_p (balance) ||
-            gnc_commodity_equiv (balance_currency, new_currency))
+        gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
+    if (!pdb || balance_currency == NULL || new_currency == NULL)
+        return gnc_numeric_zero();
+
+    rate = pricedb_lookup_conversion_rate (pdb, balance_currency,
+                                           new_currency, t);
 
     /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, INT64_MAX);
+    new_value = direct_balance_conversion(balance, balance_currency,
+                                          new_currency, rate->direct);
     if (!gnc_numeric_zero_p(new_value))
         return new_value;
 
@@ -2607,8 +2875,26 @@ gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
      * no direct price found, try if we find a price in another currency
      * and convert in two stages
      */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, INT64_MAX);
+    if (!rate->indirect_done)
+        conversion_rate_find_indirect (pdb, rate);
+    if (rate->via_from == NULL)
+        return gnc_numeric_zero();
+    tuple.from = rate->via_from;
+    tuple.to = rate->via_to;
+    return convert_balance(balance, balance_currency, new_currency, tuple);
+}
+
+/*
+ * Convert a balance from one currency to another.
+ */
+gnc_numeric
+gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
+        gnc_numeric balance,
+        const gnc_commodity *balance_currency,
+        const gnc_commodity *new_currency)
+{
+    return pricedb_convert_balance (pdb, balance, balance_currency,
+                                    new_currency, INT64_MAX);
 }
 
 gnc_numeric
@@ -2618,24 +2904,8 @@ gnc_pricedb_convert_balance_nearest_price_t64(GNCPriceDB *pdb,
                                               const gnc_commodity *new_currency,
                                               time64 t)
 {
-    gnc_numeric new_value;
-
-    if (gnc_numeric_zero_p (balance) ||
-        gnc_commodity_equiv (balance_currency, new_currency))
-        return balance;
-
-    /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, t);
-    if (!gnc_numeric_zero_p(new_value))
-        return new_value;
-
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, t);
+    return pricedb_convert_balance (pdb, balance, balance_currency,
+                                    new_currency, t);
 }
 
 
@@ -2695,54 +2965,6 @@ unstable_price_traversal(GNCPriceDB *db,
     return foreach_data.ok;
 }
 
-/* foreach_pricelist */
-typedef struct
-{
-    gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
-    gpointer user_data;
-} GNCPriceListForeachData;
-
-static void
-pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
-{
-    GList *price_list = (GList *) val;
-    GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
-    if (foreach_data->ok)
-    {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
-    }
-}
-
-static void
-pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer user_data)
-{
-    GHashTable *currencies_hash = (GHashTable *) val;
-    g_hash_table_foreach(currencies_hash, pricedb_pricelist_foreach_pricelist, user_data);
-}
-
-static gboolean
-pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
-                         gpointer user_data)
-{
-    GNCPriceListForeachData foreach_data;
-
-    if (!db || !f) return FALSE;
-    foreach_data.ok = TRUE;
-    foreach_data.func = f;
-    foreach_data.user_data = user_data;
-    if (db->commodity_hash == NULL)
-    {
-        return FALSE;
-    }
-    g_hash_table_foreach(db->commodity_hash,
-                         pricedb_pricelist_foreach_currencies_hash,
-                         &foreach_data);
-
-    return foreach_data.ok;
-}
-
 static gint
 compare_hash_entries_by_commodity_key(gconstpointer a, gconstpointer b)
 {
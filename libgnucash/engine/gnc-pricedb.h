@@ -510,6 +510,31 @@ GNCPrice   * gnc_pricedb_lookup_nearest_in_time64(GNCPriceDB *db,
                                                   const gnc_commodity *currency,
                                                   time64 t);
 
+/** @brief A single request for gnc_pricedb_lookup_nearest_in_time64_batch. */
+typedef struct
+{
+    const gnc_commodity *commodity; /**< The commodity to find a price for */
+    time64 time;                    /**< The time the price should be nearest */
+    GNCPrice *price;                /**< Set to the price found or NULL */
+} GNCPriceRequest;
+
+/** @brief Look up the prices nearest in time for many commodity and time
+ * pairs against one currency in a single pass.
+ *
+ * Each request gets the same price that gnc_pricedb_lookup_nearest_in_time64
+ * would return for it, but the requests are resolved grouped by commodity so
+ * that each commodity's prices are only located once.
+ * @param db The pricedb
+ * @param currency The commodity all the prices are wanted in
+ * @param requests The requests; the price of each is set to a price, which
+ * the caller must unref, or to NULL if there are no prices for it.
+ * @param n_requests The number of requests
+ */
+void gnc_pricedb_lookup_nearest_in_time64_batch (GNCPriceDB *db,
+                                                 const gnc_commodity *currency,
+                                                 GNCPriceRequest *requests,
+                                                 guint n_requests);
+
 /** @brief Return the price nearest in time to that given between the given
  * commodity and every other.
  *
@@ -0,0 +1,340 @@
+/********************************************************************
+ * gnc-split-store.cpp -- packed, read-only mirror of a book's       *
+ * splits                                                           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include "gnc-split-store.h"
+#include "Split.h"
+#include "Transaction.h"
+}
+
+#include <vector>
+#include <unordered_map>
+#include <array>
+#include "gnc-int128.hpp"
+
+static QofLogModule log_module = GNC_MOD_ENGINE;
+
+namespace
+{
+/* Which reconcile states a query wants, indexed by the state char. */
+class StateFilter
+{
+public:
+    StateFilter (const char *states)
+    {
+        m_wanted.fill (states == nullptr);
+        for (; states && *states; ++states)
+            m_wanted[static_cast<unsigned char>(*states)] = true;
+    }
+    bool operator() (char state) const
+    {
+        return m_wanted[static_cast<unsigned char>(state)];
+    }
+private:
+    std::array<bool, 256> m_wanted;
+};
+
+/* Adds up amounts one at a time as gnc_numeric_sum with GNC_DENOM_AUTO
+ * and GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER would add them all at
+ * once.  A run of amounts with the same denominator, the usual case, is
+ * added up as integers, split into high and low 32 bits like
+ * gnc_numeric_sum does so that fewer than 2^31 of them can't overflow;
+ * only a change of denominator goes through gnc_numeric_sum. */
+class AmountSum
+{
+public:
+    void add (const gnc_numeric& amount) noexcept
+    {
+        if (amount.denom != m_denom || !m_in_run)
+        {
+            flush ();
+            m_denom = amount.denom;
+            m_in_run = true;
+        }
+        m_high += amount.num >> 32;
+        m_low += static_cast<uint64_t>(amount.num) & UINT64_C(0xffffffff);
+        m_empty = false;
+    }
+    bool empty () const noexcept { return m_empty; }
+    gnc_numeric total () noexcept
+    {
+        flush ();
+        return gnc_numeric_sum (&m_total, 1, GNC_DENOM_AUTO,
+                                GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    }
+private:
+    void flush () noexcept
+    {
+        if (!m_in_run)
+            return;
+        auto num = (GncInt128 (m_high) << 32) + GncInt128 (m_low);
+        gnc_numeric parts[] = {m_total, num.isBig () ?
+                               gnc_numeric_error (GNC_ERROR_OVERFLOW) :
+                               gnc_numeric_create (static_cast<int64_t>(num),
+                                                   m_denom)};
+        m_total = gnc_numeric_sum (parts, 2, GNC_DENOM_AUTO,
+                                   GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER);
+        m_high = 0;
+        m_low = 0;
+        m_in_run = false;
+    }
+
+    gnc_numeric m_total = gnc_numeric_zero ();
+    gint64 m_denom = 0;
+    int64_t m_high = 0;
+    uint64_t m_low = 0;
+    bool m_in_run = false;
+    bool m_empty = true;
+};
+}
+
+struct GncSplitStore
+{
+    GncSplitStore (QofBook *book) : m_book {book} {}
+    void update (Split *split);
+    void remove (Split *split);
+    guint32 account_index (const Account *acc);
+
+    QofBook *m_book;
+    gint m_handler_id = 0;
+    /* The columns, one row per split. */
+    std::vector<Split*> m_split;
+    std::vector<guint32> m_account;
+    std::vector<time64> m_posted;
+    std::vector<gnc_numeric> m_amount;
+    std::vector<char> m_reconcile;
+    /* Where each split's row is, and the accounts m_account refers to. */
+    std::unordered_map<const Split*, size_t> m_rows;
+    std::vector<const Account*> m_accounts;
+    std::unordered_map<const Account*, guint32> m_account_indexes;
+};
+
+guint32
+GncSplitStore::account_index (const Account *acc)
+{
+    auto iter = m_account_indexes.find (acc);
+    if (iter != m_account_indexes.end ())
+        return iter->second;
+    m_accounts.push_back (acc);
+    return m_account_indexes[acc] = m_accounts.size () - 1;
+}
+
+void
+GncSplitStore::update (Split *split)
+{
+    Account *acc = xaccSplitGetAccount (split);
+    Transaction *trans = xaccSplitGetParent (split);
+    size_t row;
+
+    if (!acc || !trans)
+    {
+        remove (split);
+        return;
+    }
+
+    auto iter = m_rows.find (split);
+    if (iter == m_rows.end ())
+    {
+        row = m_split.size ();
+        m_rows[split] = row;
+        m_split.push_back (split);
+        m_account.push_back (0);
+        m_posted.push_back (0);
+        m_amount.push_back (gnc_numeric_zero ());
+        m_reconcile.push_back (NREC);
+    }
+    else
+        row = iter->second;
+
+    m_account[row] = account_index (acc);
+    m_posted[row] = xaccTransRetDatePosted (trans);
+    m_amount[row] = xaccSplitGetAmount (split);
+    m_reconcile[row] = xaccSplitGetReconcile (split);
+}
+
+void
+GncSplitStore::remove (Split *split)
+{
+    auto iter = m_rows.find (split);
+    size_t row, last = m_split.size () - 1;
+
+    if (iter == m_rows.end ())
+        return;
+    row = iter->second;
+    m_rows.erase (iter);
+
+    /* Keep the columns packed by moving the last row into the hole. */
+    if (row != last)
+    {
+        m_split[row] = m_split[last];
+        m_account[row] = m_account[last];
+        m_posted[row] = m_posted[last];
+        m_amount[row] = m_amount[last];
+        m_reconcile[row] = m_reconcile[last];
+        m_rows[m_split[row]] = row;
+    }
+    m_split.pop_back ();
+    m_account.pop_back ();
+    m_posted.pop_back ();
+    m_amount.pop_back ();
+    m_reconcile.pop_back ();
+}
+
+static void
+split_store_event_handler (QofInstance *ent, QofEventId event_type,
+                           gpointer user_data, gpointer event_data)
+{
+    auto store = static_cast<GncSplitStore*>(user_data);
+
+    if (qof_instance_get_book (ent) != store->m_book)
+        return;
+
+    if (GNC_IS_SPLIT (ent))
+    {
+        auto split = GNC_SPLIT (ent);
+        if ((event_type & QOF_EVENT_DESTROY) ||
+            qof_instance_get_destroying (ent))
+            store->remove (split);
+        else if (event_type & (QOF_EVENT_MODIFY | QOF_EVENT_REMOVE))
+            store->update (split);
+    }
+    /* Changing a transaction's date only generates an event for the
+     * transaction. */
+    else if (GNC_IS_TRANSACTION (ent) && (event_type & QOF_EVENT_MODIFY))
+    {
+        for (auto node = xaccTransGetSplitList (GNC_TRANSACTION (ent));
+             node; node = node->next)
+        {
+            auto split = static_cast<Split*>(node->data);
+            if (!qof_instance_get_destroying (split))
+                store->update (split);
+        }
+    }
+}
+
+static void
+split_store_add_split (QofInstance *ent, gpointer user_data)
+{
+    static_cast<GncSplitStore*>(user_data)->update (GNC_SPLIT (ent));
+}
+
+GncSplitStore *
+gnc_split_store_new (QofBook *book)
+{
+    GncSplitStore *store;
+    QofCollection *col;
+
+    g_return_val_if_fail (book, NULL);
+
+    ENTER ("book=%p", book);
+    store = new GncSplitStore (book);
+    col = qof_book_get_collection (book, GNC_ID_SPLIT);
+    qof_collection_foreach (col, split_store_add_split, store);
+    store->m_handler_id = qof_event_register_handler (split_store_event_handler,
+                                                      store);
+    LEAVE ("%zu splits", store->m_split.size ());
+    return store;
+}
+
+void
+gnc_split_store_destroy (GncSplitStore *store)
+{
+    if (!store) return;
+    qof_event_unregister_handler (store->m_handler_id);
+    delete store;
+}
+
+guint
+gnc_split_store_get_size (const GncSplitStore *store)
+{
+    g_return_val_if_fail (store, 0);
+    return store->m_split.size ();
+}
+
+gnc_numeric
+gnc_split_store_sum (const GncSplitStore *store, const Account *acc,
+                     time64 start, time64 end, const char *states)
+{
+    StateFilter wanted {states};
+    AmountSum sum;
+    guint32 index = 0;
+
+    g_return_val_if_fail (store, gnc_numeric_zero ());
+
+    if (acc)
+    {
+        auto iter = store->m_account_indexes.find (acc);
+        if (iter == store->m_account_indexes.end ())
+            return gnc_numeric_zero ();
+        index = iter->second;
+    }
+
+    for (size_t row = 0; row < store->m_split.size (); ++row)
+    {
+        if (acc && store->m_account[row] != index)
+            continue;
+        if (store->m_posted[row] < start || store->m_posted[row] > end)
+            continue;
+        if (!wanted (store->m_reconcile[row]))
+            continue;
+        sum.add (store->m_amount[row]);
+    }
+    return sum.total ();
+}
+
+GHashTable *
+gnc_split_store_sum_by_account (const GncSplitStore *store, time64 start,
+                                time64 end, const char *states)
+{
+    StateFilter wanted {states};
+    GHashTable *result;
+
+    g_return_val_if_fail (store, NULL);
+
+    /* One running sum per account the store has seen. */
+    std::vector<AmountSum> sums (store->m_accounts.size ());
+    for (size_t row = 0; row < store->m_split.size (); ++row)
+    {
+        if (store->m_posted[row] < start || store->m_posted[row] > end)
+            continue;
+        if (!wanted (store->m_reconcile[row]))
+            continue;
+        sums[store->m_account[row]].add (store->m_amount[row]);
+    }
+
+    result = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                    NULL, g_free);
+    for (size_t index = 0; index < sums.size (); ++index)
+    {
+        if (sums[index].empty ())
+            continue;
+        auto total = g_new (gnc_numeric, 1);
+        *total = sums[index].total ();
+        g_hash_table_insert (result,
+                             const_cast<Account*>(store->m_accounts[index]),
+                             total);
+    }
+    return result;
+}
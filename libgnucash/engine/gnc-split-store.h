@@ -0,0 +1,106 @@
+/********************************************************************
+ * gnc-split-store.h -- packed, read-only mirror of a book's splits  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/** @addtogroup Engine
+    @{ */
+/** @addtogroup SplitStore Split Store
+ *
+ * A split store keeps, for every split in a book, the split's account,
+ * the posted date of its transaction, its amount and its reconcile
+ * state in parallel arrays.  Aggregates over many splits (sums over a
+ * date range, per-account totals) can then run over those arrays
+ * instead of chasing pointers from transaction to split to account.
+ *
+ * A store is optional: nothing in the engine creates one.  Once created
+ * it follows the book through QOF events until it is destroyed.  Since
+ * QOF events are suspended while a book is loaded, create the store
+ * after the book has been loaded.
+ @{ */
+
+/** @file gnc-split-store.h
+ *  @brief Columnar mirror of the splits in a book
+ */
+
+#ifndef GNC_SPLIT_STORE_H
+#define GNC_SPLIT_STORE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+#include "qof.h"
+#include "Account.h"
+
+typedef struct GncSplitStore GncSplitStore;
+
+/** Create a store holding the splits of book and keep it up to date
+ *  from then on.
+ *
+ *  @param book The book whose splits to mirror.
+ *  @return A new store, to be freed with gnc_split_store_destroy().
+ */
+GncSplitStore *gnc_split_store_new (QofBook *book);
+
+/** Stop following the book and free the store. */
+void gnc_split_store_destroy (GncSplitStore *store);
+
+/** @return The number of splits in the store. */
+guint gnc_split_store_get_size (const GncSplitStore *store);
+
+/** Sum the amounts of the splits in an account that were posted
+ *  between two dates.
+ *
+ *  @param store The split store.
+ *  @param acc The account, or NULL for the splits of all accounts.
+ *  @param start The earliest posted date to include.
+ *  @param end The latest posted date to include.
+ *  @param states The reconcile states (e.g. "cy") of the splits to
+ *  include, or NULL for all of them.
+ *  @return The sum, with the denominator of the amounts if they all
+ *  share one.
+ */
+gnc_numeric gnc_split_store_sum (const GncSplitStore *store,
+                                 const Account *acc, time64 start,
+                                 time64 end, const char *states);
+
+/** Sum the amounts of the splits posted between two dates by account.
+ *
+ *  @param store The split store.
+ *  @param start The earliest posted date to include.
+ *  @param end The latest posted date to include.
+ *  @param states The reconcile states of the splits to include, or
+ *  NULL for all of them.
+ *  @return A hash table from each Account with such splits to a
+ *  g_malloc'ed gnc_numeric holding its sum.  Free it with
+ *  g_hash_table_destroy().
+ */
+GHashTable *gnc_split_store_sum_by_account (const GncSplitStore *store,
+                                            time64 start, time64 end,
+                                            const char *states);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNC_SPLIT_STORE_H */
+/** @} */
+/** @} */
@@ -47,12 +47,14 @@ static const char delim = '/';
 
 KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept
 {
+    m_valuemap.reserve(rhs.m_valuemap.size());
     std::for_each(rhs.m_valuemap.begin(), rhs.m_valuemap.end(),
         [this](const map_type::value_type & a)
         {
-            auto key = static_cast<char *>(qof_string_cache_insert(a.first));
+            auto key = qof_string_cache_ref(a.first);
             auto val = new KvpValueImpl(*a.second);
-            this->m_valuemap.insert({key,val});
+            /* rhs is in order, so each goes on the end. */
+            this->m_valuemap.insert(this->m_valuemap.end(), map_type::value_type {key, val});
         }
     );
 }
@@ -71,31 +73,36 @@ KvpFrameImpl::~KvpFrameImpl() noexcept
 KvpFrame *
 KvpFrame::get_child_frame_or_nullptr (Path const & path) noexcept
 {
-    if (!path.size ())
-        return this;
-    auto key = path.front ();
-    if (m_valuemap.find (key.c_str ()) == m_valuemap.end ())
-        return nullptr;
-    auto child = m_valuemap.at (key.c_str ())->get <KvpFrame *> ();
-    Path send;
-    std::copy (path.begin () + 1, path.end (), std::back_inserter (send));
-    return child->get_child_frame_or_nullptr (send);
+    auto frame = this;
+    for (auto const & key : path)
+    {
+        auto spot = frame->m_valuemap.find (key.c_str ());
+        if (spot == frame->m_valuemap.end ())
+            return nullptr;
+        frame = spot->second->get <KvpFrame *> ();
+        if (!frame)
+            return nullptr;
+    }
+    return frame;
 }
 
 KvpFrame *
 KvpFrame::get_child_frame_or_create (Path const & path) noexcept
 {
-    if (!path.size ())
-        return this;
-    auto key = path.front ();
-    auto spot = m_valuemap.find (key.c_str ());
-    if (spot == m_valuemap.end () || spot->second->get_type () != KvpValue::Type::FRAME)
-        delete set_impl (key.c_str (), new KvpValue {new KvpFrame});
-    Path send;
-    std::copy (path.begin () + 1, path.end (), std::back_inserter (send));
-    auto child_val = m_valuemap.at (key.c_str ());
-    auto child = child_val->get <KvpFrame *> ();
-    return child->get_child_frame_or_create (send);
+    auto frame = this;
+    for (auto const & key : path)
+    {
+        auto spot = frame->m_valuemap.find (key.c_str ());
+        if (spot == frame->m_valuemap.end () || spot->second->get_type () != KvpValue::Type::FRAME)
+        {
+            auto child = new KvpFrame;
+            delete frame->set_impl (key, new KvpValue {child});
+            frame = child;
+        }
+        else
+            frame = spot->second->get <KvpFrame *> ();
+    }
+    return frame;
 }
 
 
@@ -103,17 +110,24 @@ KvpValue *
 KvpFrame::set_impl (std::string const & key, KvpValue * value) noexcept
 {
     KvpValue * ret {};
-    auto spot = m_valuemap.find (key.c_str ());
-    if (spot != m_valuemap.end ())
+    auto spot = m_valuemap.lower_bound (key.c_str ());
+    if (spot != m_valuemap.end () && !m_valuemap.key_comp () (key.c_str (), spot->first))
     {
-        qof_string_cache_remove (spot->first);
         ret = spot->second;
-        m_valuemap.erase (spot);
+        /* Replacing keeps the key and leaves the others where they are. */
+        if (value)
+            spot->second = value;
+        else
+        {
+            qof_string_cache_remove (spot->first);
+            m_valuemap.erase (spot);
+        }
+        return ret;
     }
     if (value)
     {
         auto cachedkey = static_cast <char const *> (qof_string_cache_insert (key.c_str ()));
-        m_valuemap.emplace (cachedkey, value);
+        m_valuemap.insert (spot, map_type::value_type {cachedkey, value});
     }
     return ret;
 }
@@ -85,7 +85,7 @@
 #define GNC_KVP_FRAME_TYPE
 
 #include "kvp-value.hpp"
-#include <map>
+#include <boost/container/flat_map.hpp>
 #include <string>
 #include <vector>
 #include <cstring>
@@ -118,7 +118,11 @@ struct KvpFrameImpl
 		return ret;
 	    }
     };
-    using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
+    /* Most frames hold a handful of slots, so they're kept in one sorted
+     * array of key and value pointers rather than in a node per slot.
+     * The keys come from the qof-string-cache. */
+    using map_type = boost::container::flat_map<const char *, KvpValue*,
+                                                cstring_comparer>;
 
     public:
     KvpFrameImpl() noexcept {};
@@ -177,8 +177,8 @@ public:
      * build unless the initialization is stepped-through in a debugger.
      */
     QofBackend() :
-        m_percentage{nullptr}, m_fullpath{}, m_last_err{ERR_BACKEND_NO_ERR},
-        m_error_msg{} {}
+        m_percentage{nullptr}, m_autosaving{false}, m_fullpath{},
+        m_last_err{ERR_BACKEND_NO_ERR}, m_error_msg{} {}
     QofBackend(const QofBackend&) = delete;
     QofBackend(const QofBackend&&) = delete;
     virtual ~QofBackend() = default;
@@ -286,6 +286,12 @@ public:
  */
     void set_percentage(QofBePercentageFunc pctfn) { m_percentage = pctfn; }
     QofBePercentageFunc get_percentage() { return m_percentage; }
+/** Store and retrieve whether the next sync was started by an auto-save
+ * timer rather than by the user, so that a backend may trade thoroughness
+ * for speed.
+ */
+    void set_autosaving(bool autosaving) { m_autosaving = autosaving; }
+    bool get_autosaving() { return m_autosaving; }
 /** Retrieve the backend's storage URI.
  */
     std::string get_uri() { return m_fullpath; }
@@ -297,6 +303,7 @@ public:
     static void release_backends();
 protected:
     QofBePercentageFunc m_percentage;
+    bool m_autosaving;
     /** Each backend resolves a fully-qualified file path.
      * This holds the filepath and communicates it to the frontends.
      */
@@ -0,0 +1,229 @@
+/********************************************************************\
+ * qof-guid-map.cpp -- A hash table of instances keyed by GncGUID   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+}
+
+#include "qof-guid-map.hpp"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+const uint8_t ctrl_empty = 0x80;
+const uint8_t ctrl_deleted = 0xfe;
+const size_t group_size = 16;
+const size_t min_capacity = 2 * group_size;
+
+uint64_t
+guid_hash (const GncGUID& guid) noexcept
+{
+    uint64_t lo, hi;
+
+    memcpy (&lo, guid.reserved, sizeof lo);
+    memcpy (&hi, guid.reserved + sizeof lo, sizeof hi);
+    /* The multiply spreads any bits that differ across the whole word,
+     * in case someone has made GUIDs that aren't random. */
+    return (lo ^ hi) * UINT64_C(0x9e3779b97f4a7c15);
+}
+
+/* The 7 bits of the hash kept in the control byte, and the group that
+ * probing starts at, come from different ends of the hash. */
+inline uint8_t
+hash_bits (uint64_t hash) noexcept
+{
+    return hash >> 57;
+}
+
+inline bool
+guid_eq (const GncGUID& a, const GncGUID& b) noexcept
+{
+    return memcmp (a.reserved, b.reserved, GUID_DATA_SIZE) == 0;
+}
+
+/* A bit set for each control byte in the group starting at ctrl that
+ * equals value. */
+inline unsigned
+match_group (const uint8_t *ctrl, uint8_t value) noexcept
+{
+#ifdef __SSE2__
+    auto group = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(ctrl));
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (group,
+                                              _mm_set1_epi8 (static_cast<char>(value))));
+#else
+    unsigned mask = 0;
+    for (size_t i = 0; i < group_size; ++i)
+        if (ctrl[i] == value)
+            mask |= 1u << i;
+    return mask;
+#endif
+}
+
+inline unsigned
+lowest_bit (unsigned mask) noexcept
+{
+    return __builtin_ctz (mask);
+}
+}
+
+/* Probing visits whole groups, one after another, so a lookup only
+ * stops at a group with an empty slot: the key would have gone there. */
+size_t
+QofGuidMap::find (const GncGUID& guid, uint64_t hash) const noexcept
+{
+    auto num_groups = m_ctrl.size () / group_size;
+    auto bits = hash_bits (hash);
+
+    for (size_t group = hash & (num_groups - 1), step = 1; ;
+         group = (group + step++) & (num_groups - 1))
+    {
+        auto ctrl = m_ctrl.data () + group * group_size;
+        for (auto mask = match_group (ctrl, bits); mask; mask &= mask - 1)
+        {
+            auto slot = group * group_size + lowest_bit (mask);
+            if (guid_eq (m_slots[slot].guid, guid))
+                return slot;
+        }
+        if (match_group (ctrl, ctrl_empty))
+            return m_ctrl.size ();
+    }
+}
+
+QofInstance *
+QofGuidMap::lookup (const GncGUID& guid) const noexcept
+{
+    if (!m_size)
+        return nullptr;
+    auto slot = find (guid, guid_hash (guid));
+    return slot < m_ctrl.size () ? m_slots[slot].inst : nullptr;
+}
+
+size_t
+QofGuidMap::position (const GncGUID& guid) const noexcept
+{
+    if (!m_size)
+        return SIZE_MAX;
+    auto slot = find (guid, guid_hash (guid));
+    return slot < m_ctrl.size () ? slot : SIZE_MAX;
+}
+
+void
+QofGuidMap::insert (const GncGUID& guid, QofInstance *inst)
+{
+    auto hash = guid_hash (guid);
+
+    if (m_size)
+    {
+        auto slot = find (guid, hash);
+        if (slot < m_ctrl.size ())
+        {
+            m_slots[slot].inst = inst;
+            return;
+        }
+    }
+
+    /* Keep at least 1/8 of the slots empty so that probes end quickly;
+     * if many of the used ones are only deleted, rehashing at the same
+     * size is enough to clear them. */
+    if ((m_used + 1) * 8 > m_ctrl.size () * 7)
+        rehash (m_size * 2 >= m_ctrl.size () ?
+                m_ctrl.size () * 2 : m_ctrl.size ());
+    insert_new (guid, inst, hash);
+}
+
+void
+QofGuidMap::insert_new (const GncGUID& guid, QofInstance *inst,
+                        uint64_t hash) noexcept
+{
+    auto num_groups = m_ctrl.size () / group_size;
+
+    for (size_t group = hash & (num_groups - 1), step = 1; ;
+         group = (group + step++) & (num_groups - 1))
+    {
+        auto ctrl = m_ctrl.data () + group * group_size;
+        auto mask = match_group (ctrl, ctrl_empty) |
+                    match_group (ctrl, ctrl_deleted);
+        if (!mask)
+            continue;
+
+        auto slot = group * group_size + lowest_bit (mask);
+        if (m_ctrl[slot] == ctrl_empty)
+            m_used++;
+        m_ctrl[slot] = hash_bits (hash);
+        m_slots[slot] = {guid, inst};
+        m_size++;
+        return;
+    }
+}
+
+bool
+QofGuidMap::remove (const GncGUID& guid) noexcept
+{
+    if (!m_size)
+        return false;
+
+    auto slot = find (guid, guid_hash (guid));
+    if (slot == m_ctrl.size ())
+        return false;
+
+    /* If the group has an empty slot no probe went past it, so this
+     * one can be made empty too; otherwise it has to stay in use. */
+    auto group = slot - slot % group_size;
+    if (match_group (m_ctrl.data () + group, ctrl_empty))
+    {
+        m_ctrl[slot] = ctrl_empty;
+        m_used--;
+    }
+    else
+        m_ctrl[slot] = ctrl_deleted;
+    m_slots[slot].inst = nullptr;
+    m_size--;
+    return true;
+}
+
+void
+QofGuidMap::rehash (size_t capacity)
+{
+    std::vector<uint8_t> ctrl (capacity < min_capacity ? min_capacity :
+                               capacity, ctrl_empty);
+    std::vector<Slot> slots (ctrl.size ());
+
+    ctrl.swap (m_ctrl);
+    slots.swap (m_slots);
+    m_size = m_used = 0;
+    for (size_t i = 0; i < ctrl.size (); ++i)
+        if (is_full (ctrl[i]))
+            insert_new (slots[i].guid, slots[i].inst, guid_hash (slots[i].guid));
+}
+
+size_t
+QofGuidMap::memory_usage () const noexcept
+{
+    return m_ctrl.capacity () * sizeof (uint8_t) +
+           m_slots.capacity () * sizeof (Slot);
+}
@@ -0,0 +1,101 @@
+/********************************************************************\
+ * qof-guid-map.hpp -- A hash table of instances keyed by GncGUID   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#ifndef QOF_GUID_MAP_HPP
+#define QOF_GUID_MAP_HPP
+
+extern "C"
+{
+#include "guid.h"
+#include "qofid.h"
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** @ingroup Entity
+ *  @brief The table of a QofCollection's instances, keyed by GncGUID.
+ *
+ * An open-addressing hash table that keeps a copy of each key in its
+ * slot, so a lookup compares GUIDs without going through a pointer to
+ * the instance.  Beside the slots is an array of one control byte per
+ * slot, holding 7 bits of the key's hash or a marker for an empty or
+ * deleted slot; a probe checks a group of 16 of them at once (with
+ * SSE2 where it is available) and only compares the keys of the slots
+ * whose bits match.
+ *
+ * GUIDs are random, so the hash is just their bits folded together.
+ */
+class QofGuidMap
+{
+public:
+    QofGuidMap () = default;
+    QofGuidMap (const QofGuidMap&) = delete;
+    QofGuidMap& operator= (const QofGuidMap&) = delete;
+
+    /** The instance with the given GUID, or nullptr. */
+    QofInstance *lookup (const GncGUID& guid) const noexcept;
+    /** Add an instance, replacing any with the same GUID. */
+    void insert (const GncGUID& guid, QofInstance *inst);
+    /** Remove the instance with the given GUID.
+     * @return false if there wasn't one. */
+    bool remove (const GncGUID& guid) noexcept;
+    /** Where the instance with the given GUID comes in the order
+     * foreach visits them, or SIZE_MAX if there isn't one.  Only holds
+     * until the table is changed. */
+    size_t position (const GncGUID& guid) const noexcept;
+    /** The number of instances. */
+    size_t size () const noexcept { return m_size; }
+    /** The bytes allocated for the table. */
+    size_t memory_usage () const noexcept;
+
+    /** Call func on every instance.  The table must not be changed
+     * until it returns. */
+    template <typename Func> void foreach (Func func) const
+    {
+        for (size_t i = 0; i < m_ctrl.size (); ++i)
+            if (is_full (m_ctrl[i]))
+                func (m_slots[i].inst);
+    }
+
+private:
+    struct Slot
+    {
+        GncGUID guid;
+        QofInstance *inst;
+    };
+
+    static bool is_full (uint8_t ctrl) noexcept { return !(ctrl & 0x80); }
+    size_t find (const GncGUID& guid, uint64_t hash) const noexcept;
+    void insert_new (const GncGUID& guid, QofInstance *inst,
+                     uint64_t hash) noexcept;
+    void rehash (size_t capacity);
+
+    std::vector<uint8_t> m_ctrl;
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+    /* The slots that are either full or marked deleted. */
+    size_t m_used = 0;
+};
+
+#endif /* QOF_GUID_MAP_HPP */
@@ -37,46 +37,130 @@ extern "C"
 #include "qof.h"
 }
 
+#include <cstddef>
+#include <vector>
+
 /* Uncomment if you need to log anything.
 static QofLogModule log_module = QOF_MOD_UTIL;
 */
 /* =================================================================== */
 /* The QOF string cache                                                */
 /*                                                                     */
-/* The cache is a GHashTable where a copy of the string is the key,    */
-/* and a ref count is the value                                        */
+/* The cache is split into shards, each a GHashTable of entries behind */
+/* its own lock, so that several threads can use it at once.  The      */
+/* shard is picked by the string's hash, which is kept in the entry    */
+/* so that it is only worked out once for each call.  Each entry holds */
+/* a ref count and the cached string itself.  Inserts and removals    */
+/* lock the shard; only qof_string_cache_ref(), which needs no lookup, */
+/* just increments the count atomically.                               */
 /* =================================================================== */
 
-static GHashTable* qof_string_cache = NULL;
+struct CacheEntry
+{
+    guint hash;
+    gint refcount;
+    /* Points at data, or for a lookup key at the string looked for */
+    const char *str;
+    char data[1];
+};
+
+static const guint num_shards = 64;
+
+struct alignas(64) CacheShard
+{
+    GMutex mutex;
+    GHashTable *entries;
+};
+
+/* Static GMutexes need no initialising. */
+static CacheShard shards[num_shards];
+
+static guint
+cache_entry_hash (gconstpointer entry)
+{
+    return static_cast<const CacheEntry*>(entry)->hash;
+}
+
+static gboolean
+cache_entry_equal (gconstpointer a, gconstpointer b)
+{
+    auto ea = static_cast<const CacheEntry*>(a);
+    auto eb = static_cast<const CacheEntry*>(b);
+    return ea->hash == eb->hash && strcmp (ea->str, eb->str) == 0;
+}
+
+static CacheShard *
+shard_for_hash (guint hash)
+{
+    /* Use the top bits of the product, so that the shard doesn't
+     * depend on the low bits the GHashTable picks its buckets by. */
+    return &shards[(hash * 2654435769u) >> 26];
+}
+
+static CacheEntry *
+entry_for_string (const char *cached)
+{
+    return reinterpret_cast<CacheEntry*>(const_cast<char*>(cached) -
+                                         offsetof (CacheEntry, data));
+}
 
-static GHashTable*
-qof_get_string_cache(void)
+/* Find or add the entry for key in shard, which must be locked, and
+ * take a reference to it. */
+static char *
+shard_insert (CacheShard *shard, const char *key, guint hash)
 {
-    if (!qof_string_cache)
+    CacheEntry lookup_key;
+    CacheEntry *entry;
+
+    lookup_key.hash = hash;
+    lookup_key.str = key;
+    if (!shard->entries)
+        shard->entries = g_hash_table_new (cache_entry_hash, cache_entry_equal);
+
+    entry = static_cast<CacheEntry*>(g_hash_table_lookup (shard->entries,
+                                                          &lookup_key));
+    if (entry)
     {
-        qof_string_cache = g_hash_table_new_full(
-                               g_str_hash,               /* hash_func          */
-                               g_str_equal,              /* key_equal_func     */
-                               g_free,                   /* key_destroy_func   */
-                               g_free);                  /* value_destroy_func */
+        g_atomic_int_inc (&entry->refcount);
+        return entry->data;
     }
-    return qof_string_cache;
+
+    auto len = strlen (key);
+    entry = static_cast<CacheEntry*>(g_malloc (offsetof (CacheEntry, data) +
+                                               len + 1));
+    entry->hash = hash;
+    entry->refcount = 1;
+    memcpy (entry->data, key, len + 1);
+    entry->str = entry->data;
+    g_hash_table_add (shard->entries, entry);
+    return entry->data;
 }
 
 void
 qof_string_cache_init(void)
 {
-    (void)qof_get_string_cache();
+    /* The shards create their tables on first use. */
 }
 
 void
 qof_string_cache_destroy (void)
 {
-    if (qof_string_cache)
+    for (auto& shard : shards)
     {
-        g_hash_table_destroy(qof_string_cache);
+        g_mutex_lock (&shard.mutex);
+        if (shard.entries)
+        {
+            GHashTableIter iter;
+            gpointer entry;
+
+            g_hash_table_iter_init (&iter, shard.entries);
+            while (g_hash_table_iter_next (&iter, &entry, NULL))
+                g_free (entry);
+            g_hash_table_destroy (shard.entries);
+            shard.entries = NULL;
+        }
+        g_mutex_unlock (&shard.mutex);
     }
-    qof_string_cache = NULL;
 }
 
 /* If the key exists in the cache, check the refcount.  If 1, just
@@ -86,21 +170,27 @@ qof_string_cache_remove(const char * key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
+        CacheEntry lookup_key;
+        CacheEntry *entry;
+        CacheShard *shard;
+
+        lookup_key.hash = g_str_hash (key);
+        lookup_key.str = key;
+        shard = shard_for_hash (lookup_key.hash);
+
+        g_mutex_lock (&shard->mutex);
+        entry = shard->entries ?
+            static_cast<CacheEntry*>(g_hash_table_lookup (shard->entries,
+                                                          &lookup_key)) :
+            NULL;
+        /* Only this lock guards against the count reaching zero, but
+         * qof_string_cache_ref() may add to it without the lock. */
+        if (entry && g_atomic_int_dec_and_test (&entry->refcount))
         {
-            guint* refcount = (guint*)value;
-            if (*refcount == 1)
-            {
-                g_hash_table_remove(cache, key);
-            }
-            else
-            {
-                --(*refcount);
-            }
+            g_hash_table_remove (shard->entries, entry);
+            g_free (entry);
         }
+        g_mutex_unlock (&shard->mutex);
     }
 }
 
@@ -111,27 +201,64 @@ qof_string_cache_insert(const char * key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
-        {
-            guint* refcount = (guint*)value;
-            ++(*refcount);
-            return static_cast <char *> (cache_key);
-        }
-        else
-        {
-            gpointer new_key = g_strdup(static_cast<const char*>(key));
-            guint* refcount = static_cast<unsigned int*>(g_malloc(sizeof(guint)));
-            *refcount = 1;
-            g_hash_table_insert(cache, new_key, refcount);
-            return static_cast <char *> (new_key);
-        }
+        guint hash = g_str_hash (key);
+        CacheShard *shard = shard_for_hash (hash);
+        char *cached;
+
+        g_mutex_lock (&shard->mutex);
+        cached = shard_insert (shard, key, hash);
+        g_mutex_unlock (&shard->mutex);
+        return cached;
+    }
+    return NULL;
+}
+
+char *
+qof_string_cache_ref(const char * cached)
+{
+    if (cached)
+    {
+        g_atomic_int_inc (&entry_for_string (cached)->refcount);
+        return const_cast<char*>(cached);
     }
     return NULL;
 }
 
+void
+qof_string_cache_insert_many(const char ** keys, char ** cached, guint n_keys)
+{
+    std::vector<guint> hashes (n_keys);
+    std::vector<guint> order (n_keys);
+    guint counts[num_shards + 1] = {0};
+
+    /* Sort the keys by shard so that each shard is locked once. */
+    for (guint i = 0; i < n_keys; ++i)
+    {
+        cached[i] = NULL;
+        if (!keys[i])
+            continue;
+        hashes[i] = g_str_hash (keys[i]);
+        counts[shard_for_hash (hashes[i]) - shards + 1]++;
+    }
+    for (guint i = 1; i <= num_shards; ++i)
+        counts[i] += counts[i - 1];
+    for (guint i = 0; i < n_keys; ++i)
+        if (keys[i])
+            order[counts[shard_for_hash (hashes[i]) - shards]++] = i;
+
+    /* counts[s] is now where shard s + 1's keys start. */
+    for (guint s = 0, i = 0; s < num_shards; ++s)
+    {
+        if (i == counts[s])
+            continue;
+        g_mutex_lock (&shards[s].mutex);
+        for (; i < counts[s]; ++i)
+            cached[order[i]] = shard_insert (&shards[s], keys[order[i]],
+                                             hashes[order[i]]);
+        g_mutex_unlock (&shards[s].mutex);
+    }
+}
+
 char *
 qof_string_cache_replace(char const * dst, char const * src)
 {
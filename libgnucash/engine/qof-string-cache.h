@@ -68,6 +68,12 @@ extern "C"
  *
  * The string cache is demand-created on first use.
  *
+ * The cache may be used from several threads at once.  It is divided
+ * into shards by the strings' hashes, each with its own lock, so
+ * threads only wait for each other when they use the same shard.
+ * Inserting and removing both take the shard's lock; only
+ * qof_string_cache_ref() works without one.
+ *
  **/
 
 /** Initialize the string cache */
@@ -86,6 +92,21 @@ void qof_string_cache_remove(const char * key);
 */
 char * qof_string_cache_insert(const char * key);
 
+/** Take another reference to a string already in the cache, without
+   looking it up.  cached must have been returned by one of the insert
+   functions, and the caller must hold a reference to it.
+   @return cached
+*/
+char * qof_string_cache_ref(const char * cached);
+
+/** Insert n_keys strings at once, as qof_string_cache_insert() would,
+   putting the cached strings in the matching places in cached.  Each
+   shard of the cache is locked only once, which suits loaders that
+   gather up many strings before storing them.
+*/
+void qof_string_cache_insert_many(const char ** keys, char ** cached,
+                                  guint n_keys);
+
 /** Same as CACHE_REPLACE below, but safe to call from C++.
  */
 char * qof_string_cache_replace(const char * dst, const char * src);
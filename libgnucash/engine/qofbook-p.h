@@ -59,6 +59,14 @@ void qof_book_set_backend (QofBook *book, QofBackend *be);
 /* Register books with the engine */
 gboolean qof_book_register (void);
 
+/** Called by qof_commit_edit_part2() with an instance about to be
+ *  committed to the backend.  If the book is deferring its commits,
+ *  inst is kept for qof_book_end_deferred_commits() and TRUE is
+ *  returned; an instance that is about to be freed is dropped instead
+ *  and has to be committed now. */
+gboolean qof_book_defer_commit (QofBook *book, QofInstance *inst,
+                                gboolean freeing);
+
 /** @deprecated use qof_instance_set_guid instead but only in
 backends (when reading the GncGUID from the data source). */
 #define qof_book_set_guid(book,guid)    \
@@ -61,6 +61,9 @@ extern "C"
 // For GNC_ID_ROOT_ACCOUNT:
 #include "AccountP.h"
 
+#include <unordered_set>
+#include <vector>
+
 static QofLogModule log_module = QOF_MOD_ENGINE;
 #define AB_KEY "hbci"
 #define AB_TEMPLATES "template-list"
@@ -574,6 +577,93 @@ qof_book_get_data (const QofBook *book, const char *key)
     return g_hash_table_lookup (book->data_tables, (gpointer)key);
 }
 
+/* ====================================================================== */
+
+static const char *deferred_commits_key = "qof-deferred-commits";
+
+/* The instances whose backend commits are held back, in the order of
+ * their first commits. */
+struct DeferredCommits
+{
+    guint depth = 0;
+    std::vector<QofInstance*> order;
+    std::unordered_set<QofInstance*> pending;
+};
+
+static void
+deferred_commits_free (QofBook *book, gpointer key, gpointer data)
+{
+    delete static_cast<DeferredCommits*>(data);
+}
+
+void
+qof_book_begin_deferred_commits (QofBook *book)
+{
+    g_return_if_fail (book != NULL);
+
+    auto deferred = static_cast<DeferredCommits*>(
+        qof_book_get_data (book, deferred_commits_key));
+    if (!deferred)
+    {
+        deferred = new DeferredCommits;
+        qof_book_set_data_fin (book, deferred_commits_key, deferred,
+                               deferred_commits_free);
+    }
+    deferred->depth++;
+}
+
+gboolean
+qof_book_defer_commit (QofBook *book, QofInstance *inst, gboolean freeing)
+{
+    auto deferred = static_cast<DeferredCommits*>(
+        qof_book_get_data (book, deferred_commits_key));
+    if (!deferred || !deferred->depth)
+        return FALSE;
+
+    if (freeing)
+    {
+        deferred->pending.erase (inst);
+        return FALSE;
+    }
+    if (deferred->pending.insert (inst).second)
+        deferred->order.push_back (inst);
+    return TRUE;
+}
+
+QofBackendError
+qof_book_end_deferred_commits (QofBook *book)
+{
+    QofBackendError errcode = ERR_BACKEND_NO_ERR;
+
+    g_return_val_if_fail (book != NULL, errcode);
+
+    auto deferred = static_cast<DeferredCommits*>(
+        qof_book_get_data (book, deferred_commits_key));
+    if (!deferred || !deferred->depth)
+    {
+        PWARN ("no deferred commits to end");
+        return errcode;
+    }
+    if (--deferred->depth)
+        return errcode;
+
+    /* The address of an instance freed since it was deferred may have
+     * been reused and pushed again; it is committed at the first. */
+    auto order = std::move (deferred->order);
+    auto pending = std::move (deferred->pending);
+    deferred->order.clear ();
+    deferred->pending.clear ();
+    for (auto inst : order)
+    {
+        if (!pending.erase (inst))
+            continue;
+        auto err = qof_instance_commit_deferred (inst);
+        if (errcode == ERR_BACKEND_NO_ERR)
+            errcode = err;
+    }
+    return errcode;
+}
+
 /* ====================================================================== */
 gboolean
 qof_book_is_readonly(const QofBook *book)
@@ -252,6 +252,23 @@ void qof_book_set_data_fin (QofBook *book, const gchar *key, gpointer data,
 /** Retrieves arbitrary pointers to structs stored by qof_book_set_data. */
 gpointer qof_book_get_data (const QofBook *book, const gchar *key);
 
+/** Hold back the backend commits of the book's instances until
+ *  qof_book_end_deferred_commits() is called, so that a run of many
+ *  edits reaches the backend in one go at its end.  Each instance is
+ *  committed once however many times it was edited; one that is
+ *  destroyed in the meantime is committed right away, as before.
+ *  Calls may be nested.
+ */
+void qof_book_begin_deferred_commits (QofBook *book);
+
+/** Give the backend everything held back since the matching
+ *  qof_book_begin_deferred_commits().
+ *  @return The first error the backend reported, or
+ *  ERR_BACKEND_NO_ERR.  An instance that failed to commit is left
+ *  dirty.
+ */
+QofBackendError qof_book_end_deferred_commits (QofBook *book);
+
 /** Return whether the book is read only. */
 gboolean qof_book_is_readonly(const QofBook *book);
 
@@ -34,9 +34,20 @@ typedef struct
     gpointer user_data;
 
     gint handler_id;
+
+    /* Set instead of handler for a batch handler */
+    QofEventBatchHandler batch_handler;
 } HandlerInfo;
 
 /* generates an event even when events are suspended! */
 void qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data);
 
+/* TRUE while events are suspended and so being dropped. */
+gboolean qof_event_is_suspended (void);
+
+/* Counts the calls to qof_event_suspend().  Anything kept up to date
+ * from events can compare it with an earlier reading to tell whether
+ * events may have been dropped in between. */
+guint qof_event_get_suspend_epoch (void);
+
 #endif
@@ -31,12 +31,23 @@ extern "C"
 #include "qof.h"
 #include "qofevent-p.h"
 
+#include <unordered_map>
+#include <vector>
+
 /* Static Variables ************************************************/
 static guint   suspend_counter   = 0;
+static guint   suspend_epoch     = 0;
 static gint    next_handler_id   = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
 static GList   *handlers  =   NULL;
+static guint   batch_level       = 0;
+static guint64 events_generated  = 0;
+static guint64 events_delivered  = 0;
+
+/* The batch being collected, and where each entity's entry is in it */
+static std::vector<QofEventBatchEntry> batch_entries;
+static std::unordered_map<QofInstance*, size_t> batch_positions;
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -72,10 +83,30 @@ find_next_handler_id(void)
     return handler_id;
 }
 
+static gint
+add_handler (QofEventHandler handler, QofEventBatchHandler batch_handler,
+             gpointer user_data)
+{
+    HandlerInfo *hi;
+
+    /* look for a free handler id */
+    gint handler_id = find_next_handler_id();
+
+    /* Found one, add the handler */
+    hi = g_new0 (HandlerInfo, 1);
+
+    hi->handler = handler;
+    hi->batch_handler = batch_handler;
+    hi->user_data = user_data;
+    hi->handler_id = handler_id;
+
+    handlers = g_list_prepend (handlers, hi);
+    return handler_id;
+}
+
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
 {
-    HandlerInfo *hi;
     gint handler_id;
 
     ENTER ("(handler=%p, data=%p)", handler, user_data);
@@ -87,17 +118,27 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
         return 0;
     }
 
-    /* look for a free handler id */
-    handler_id = find_next_handler_id();
+    handler_id = add_handler (handler, NULL, user_data);
+    LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
+    return handler_id;
+}
 
-    /* Found one, add the handler */
-    hi = g_new0 (HandlerInfo, 1);
+gint
+qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                  gpointer user_data)
+{
+    gint handler_id;
 
-    hi->handler = handler;
-    hi->user_data = user_data;
-    hi->handler_id = handler_id;
+    ENTER ("(handler=%p, data=%p)", handler, user_data);
 
-    handlers = g_list_prepend (handlers, hi);
+    /* sanity check */
+    if (!handler)
+    {
+        PERR ("no handler specified");
+        return 0;
+    }
+
+    handler_id = add_handler (NULL, handler, user_data);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
@@ -120,12 +161,14 @@ qof_event_unregister_handler (gint handler_id)
            of a generated event, such as QOF_EVENT_DESTROY.  In that case,
            we're in the middle of walking the GList and it is wrong to
            modify the list. So, instead, we just NULL the handler. */
-        if (hi->handler)
+        if (hi->handler || hi->batch_handler)
             LEAVE ("(handler_id=%d) handler=%p data=%p", handler_id,
-                   hi->handler, hi->user_data);
+                   hi->handler ? (gpointer)hi->handler : (gpointer)hi->batch_handler,
+                   hi->user_data);
 
         /* safety -- clear the handler in case we're running events now */
         hi->handler = NULL;
+        hi->batch_handler = NULL;
 
         if (handler_run_level == 0)
         {
@@ -148,6 +191,7 @@ void
 qof_event_suspend (void)
 {
     suspend_counter++;
+    suspend_epoch++;
 
     if (suspend_counter == 0)
     {
@@ -167,12 +211,79 @@ qof_event_resume (void)
     suspend_counter--;
 }
 
+gboolean
+qof_event_is_suspended (void)
+{
+    return suspend_counter != 0;
+}
+
+guint
+qof_event_get_suspend_epoch (void)
+{
+    return suspend_epoch;
+}
+
+static void
+remove_pending_deletes (void)
+{
+    GList *node;
+    GList *next_node = NULL;
+
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        next_node = node->next;
+        if (hi->handler == NULL && hi->batch_handler == NULL)
+        {
+            /* remove this node from the list, then free this node */
+            handlers = g_list_remove_link (handlers, node);
+            g_list_free_1 (node);
+            g_free (hi);
+        }
+    }
+    pending_deletes = 0;
+}
+
+static QofEventBatchEntry
+make_batch_entry (QofInstance *entity)
+{
+    QofEventBatchEntry entry;
+
+    entry.entity = entity;
+    entry.guid = *qof_instance_get_guid (entity);
+    entry.e_type = entity->e_type;
+    entry.event_mask = 0;
+    return entry;
+}
+
+static void
+add_to_batch (QofInstance *entity, QofEventId event_id)
+{
+    auto pos = batch_positions.find (entity);
+
+    if (pos == batch_positions.end ())
+    {
+        pos = batch_positions.emplace (entity, batch_entries.size ()).first;
+        batch_entries.push_back (make_batch_entry (entity));
+    }
+    batch_entries[pos->second].event_mask |= event_id;
+
+    /* The entity is about to be freed.  Forget it, so that one created
+     * at the same address later in the batch gets an entry of its own. */
+    if (event_id & QOF_EVENT_DESTROY)
+    {
+        batch_entries[pos->second].entity = NULL;
+        batch_positions.erase (pos);
+    }
+}
+
 static void
 qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                              gpointer event_data)
 {
     GList *node;
     GList *next_node = NULL;
+    gboolean batched = (batch_level != 0);
 
     g_return_if_fail(entity);
 
@@ -185,6 +296,10 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
     }
     }
 
+    events_generated++;
+    if (batched)
+        add_to_batch (entity, event_id);
+
     handler_run_level++;
     for (node = handlers; node; node = next_node)
     {
@@ -196,6 +311,17 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
             PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
                   hi->handler, event_data);
             hi->handler (entity, event_id, hi->user_data, event_data);
+            events_delivered++;
+        }
+        else if (hi->batch_handler && !batched)
+        {
+            QofEventBatchEntry entry = make_batch_entry (entity);
+
+            entry.event_mask = event_id;
+            if (event_id & QOF_EVENT_DESTROY)
+                entry.entity = NULL;
+            hi->batch_handler (&entry, 1, hi->user_data);
+            events_delivered++;
         }
     }
     handler_run_level--;
@@ -204,21 +330,83 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
      * then go delete the handlers now.
      */
     if (handler_run_level == 0 && pending_deletes)
+        remove_pending_deletes ();
+}
+
+static void
+deliver_batch (void)
+{
+    std::vector<QofEventBatchEntry> entries;
+    GList *node;
+    GList *next_node = NULL;
+
+    /* Handlers may generate events of their own, which are delivered as
+     * they happen now that the batch is over. */
+    entries.swap (batch_entries);
+    batch_positions.clear ();
+    if (entries.empty ())
+        return;
+
+    handler_run_level++;
+    for (node = handlers; node; node = next_node)
     {
-        for (node = handlers; node; node = next_node)
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+
+        next_node = node->next;
+        if (hi->batch_handler)
         {
-            HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
-            next_node = node->next;
-            if (hi->handler == NULL)
-            {
-                /* remove this node from the list, then free this node */
-                handlers = g_list_remove_link (handlers, node);
-                g_list_free_1 (node);
-                g_free (hi);
-            }
+            PINFO("id=%d hi=%p han=%p entries=%u", hi->handler_id, hi,
+                  hi->batch_handler, (guint)entries.size ());
+            hi->batch_handler (entries.data (), entries.size (), hi->user_data);
+            events_delivered++;
         }
-        pending_deletes = 0;
     }
+    handler_run_level--;
+
+    if (handler_run_level == 0 && pending_deletes)
+        remove_pending_deletes ();
+}
+
+void
+qof_event_begin_batch (void)
+{
+    batch_level++;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level overflow");
+    }
+}
+
+void
+qof_event_end_batch (void)
+{
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+
+    batch_level--;
+
+    if (batch_level == 0)
+        deliver_batch ();
+}
+
+void
+qof_event_get_counts (guint64 *generated, guint64 *delivered)
+{
+    if (generated)
+        *generated = events_generated;
+    if (delivered)
+        *delivered = events_delivered;
+}
+
+void
+qof_event_reset_counts (void)
+{
+    events_generated = 0;
+    events_delivered = 0;
 }
 
 void
@@ -89,6 +89,36 @@ for future libqof1 or libqof2 usage.
 typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
                                  gpointer handler_data, gpointer event_data);
 
+/** \brief One entity's part of a batch of events.
+ *
+ * A batch holds one entry for each entity that generated events while
+ * it was open, in the order the entities first generated one.
+ */
+typedef struct
+{
+    /** The entity, or NULL if it was destroyed before the batch was
+     * delivered. */
+    QofInstance *entity;
+    /** The GncGUID of the entity. */
+    GncGUID guid;
+    /** The type of the entity. */
+    QofIdTypeConst e_type;
+    /** All the events the entity generated, OR'ed together. */
+    QofEventId event_mask;
+} QofEventBatchEntry;
+
+/** \brief Handler invoked with a batch of events.
+ *
+ * Batch handlers don't see the event data of the events.
+ *
+ * @param entries:   The entities that generated events and their events.
+ * @param n_entries: The number of entries.
+ * @param handler_data:   data supplied when handler was registered.
+ */
+typedef void (*QofEventBatchHandler) (const QofEventBatchEntry *entries,
+                                      guint n_entries,
+                                      gpointer handler_data);
+
 /** \brief Register a handler for events.
  *
  * @param handler:   handler to register
@@ -98,6 +128,21 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
  */
 gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data);
 
+/** \brief Register a handler for batches of events.
+ *
+ * Outside a batch (see qof_event_begin_batch()) the handler is invoked
+ * with a batch of one entry for each event as it is generated.  Inside
+ * one it is invoked once, when the batch ends.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler, to be passed to
+ * qof_event_unregister_handler()
+ */
+gint qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                       gpointer handler_data);
+
 /** \brief Unregister an event handler.
  *
  * @param handler_id: the id of the handler to unregister
@@ -139,6 +184,33 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start collecting events into a batch.
+ *
+ *    Until the batch ends, events are still passed to the handlers
+ *    registered with qof_event_register_handler() as they are generated,
+ *    but those for the handlers registered with
+ *    qof_event_register_batch_handler() are gathered up, one entry for
+ *    each entity, and delivered to each of them in one call when the
+ *    batch ends.  This may be called multiple times; the batch ends
+ *    with the matching number of calls to qof_event_end_batch().
+ */
+void qof_event_begin_batch (void);
+
+/** End a batch of events, delivering it if this was the outermost one. */
+void qof_event_end_batch (void);
+
+/** \brief Get the number of events generated and handler invocations.
+ *
+ * @param generated: Set to the number of events generated and not
+ * dropped because events were suspended.
+ * @param delivered: Set to the number of times a handler was invoked,
+ * counting each invocation of a batch handler once.
+ */
+void qof_event_get_counts (guint64 *generated, guint64 *delivered);
+
+/** Set both the counts returned by qof_event_get_counts() to zero. */
+void qof_event_reset_counts (void);
+
 #ifdef __cplusplus
 }
 #endif
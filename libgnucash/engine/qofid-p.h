@@ -46,6 +46,12 @@ extern "C"
  */
 void qof_collection_insert_entity (QofCollection *, QofInstance *);
 
+/** Where ent comes in the order qof_collection_foreach visits the
+ *  collection's entities, for putting entities found some other way
+ *  into that order.  Only holds until the collection changes. */
+size_t qof_collection_entity_position (const QofCollection *col,
+                                       const QofInstance *ent);
+
 /** reset value of dirty flag */
 void qof_collection_mark_clean (QofCollection *);
 void qof_collection_mark_dirty (QofCollection *);
@@ -32,6 +32,9 @@ extern "C"
 #include "qof.h"
 #include "qofid-p.h"
 #include "qofinstance-p.h"
+#include "qof-guid-map.hpp"
+
+#include <vector>
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -40,7 +43,7 @@ struct QofCollection_s
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    QofGuidMap * entities;
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
@@ -52,7 +55,7 @@ qof_collection_new (QofIdType type)
     QofCollection *col;
     col = g_new0(QofCollection, 1);
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
-    col->hash_of_entities = guid_hash_table_new();
+    col->entities = new QofGuidMap;
     col->data = NULL;
     return col;
 }
@@ -61,9 +64,9 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
+    delete col->entities;
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
+    col->entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
@@ -89,7 +92,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    col->entities->remove (*guid);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -103,7 +106,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    col->entities->insert (*guid, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -129,7 +132,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    coll->entities->insert (*guid, ent);
     return TRUE;
 }
 
@@ -213,12 +216,9 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
-    return ent;
+    return col->entities->lookup (*guid);
 }
 
 QofCollection *
@@ -244,10 +244,14 @@ qof_collection_from_glist (QofIdType type, const GList *glist)
 guint
 qof_collection_count (const QofCollection *col)
 {
-    guint c;
+    return col->entities->size ();
+}
 
-    c = g_hash_table_size(col->hash_of_entities);
-    return c;
+size_t
+qof_collection_entity_position (const QofCollection *col,
+                                const QofInstance *ent)
+{
+    return col->entities->position (*qof_instance_get_guid (ent));
 }
 
 /* =============================================================== */
@@ -303,40 +307,28 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
-{
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
-
-static void
-foreach_cb (gpointer item, gpointer arg)
-{
-    struct _iterate *iter = static_cast<_iterate*>(arg);
-    QofInstance *ent = static_cast<QofInstance*>(item);
-
-    iter->fcn (ent, iter->data);
-}
-
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _iterate iter;
-    GList *entries;
+    std::vector<QofInstance*> entries;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
-
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s before is %u", col->e_type,
+          (guint)col->entities->size ());
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    /* The callback may add or remove entities, so work from a copy. */
+    entries.reserve (col->entities->size ());
+    col->entities->foreach ([&entries] (QofInstance *ent)
+                            {
+                                entries.push_back (ent);
+                            });
+    for (auto ent : entries)
+        cb_func (ent, user_data);
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s after is %u", col->e_type,
+          (guint)col->entities->size ());
 }
 /* =============================================================== */
@@ -140,7 +140,7 @@ print error message if its bad  */
 
 @param e_type QofIdType
 @param is_dirty gboolean
-@param hash_of_entities GHashTable
+@param entities QofGuidMap, the entities keyed by GncGUID
 @param data gpointer, place where object class can hang arbitrary data
 
 */
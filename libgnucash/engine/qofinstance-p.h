@@ -32,6 +32,7 @@
 #define QOF_INSTANCE_P_H
 
 #include "qofinstance.h"
+#include "qofbackend.h"
 
 #ifdef __cplusplus
 #include "kvp-frame.hpp"
@@ -90,6 +91,12 @@ void qof_instance_set_dirty(QofInstance* inst);
 
 /* reset the dirty flag */
 void qof_instance_mark_clean (QofInstance *);
+
+/** Give the backend an instance whose commit qof_commit_edit_part2()
+ *  held back, as it would have then.  Used by
+ *  qof_book_end_deferred_commits().
+ *  @return The backend's error, which is also left on the backend. */
+QofBackendError qof_instance_commit_deferred (QofInstance *inst);
 /** Get the version number on this instance.  The version number is
  *  used to manage multi-user updates. */
 gint32 qof_instance_get_version (gconstpointer inst);
@@ -988,6 +988,32 @@ gboolean qof_commit_edit (QofInstance *inst)
     return TRUE;
 }
 
+/* Hand inst to the backend, which marks it clean if all went well. */
+static QofBackendError
+commit_to_backend (QofInstance *inst, QofBackend *be)
+{
+    QofBackendError errcode;
+
+    /* clear errors */
+    do
+    {
+        errcode = be->get_error();
+    }
+    while (errcode != ERR_BACKEND_NO_ERR);
+
+    be->commit(inst);
+    errcode = be->get_error();
+    if (errcode != ERR_BACKEND_NO_ERR)
+    {
+        /* Push error back onto the stack */
+        be->set_error (errcode);
+        return errcode;
+    }
+    /* XXX the backend commit code should clear dirty!! */
+    GET_PRIVATE(inst)->dirty = FALSE;
+    return ERR_BACKEND_NO_ERR;
+}
+
 gboolean
 qof_commit_edit_part2(QofInstance *inst,
                       void (*on_error)(QofInstance *, QofBackendError),
@@ -1004,34 +1030,26 @@ qof_commit_edit_part2(QofInstance *inst,
       qof_book_mark_session_dirty(priv->book);
     }
 
-    /* See if there's a backend.  If there is, invoke it. */
+    /* See if there's a backend.  If there is, invoke it, unless the
+     * book is holding its commits back until later. */
     auto be = qof_book_get_backend(priv->book);
+    if (be && qof_book_defer_commit(priv->book, inst, priv->do_free))
+    {
+        if (on_done)
+            on_done(inst);
+        return TRUE;
+    }
     if (be)
     {
-        QofBackendError errcode;
-
-        /* clear errors */
-        do
-        {
-            errcode = be->get_error();
-        }
-        while (errcode != ERR_BACKEND_NO_ERR);
-
-        be->commit(inst);
-        errcode = be->get_error();
+        auto errcode = commit_to_backend(inst, be);
         if (errcode != ERR_BACKEND_NO_ERR)
         {
             /* XXX Should perform a rollback here */
             priv->do_free = FALSE;
-
-            /* Push error back onto the stack */
-            be->set_error (errcode);
             if (on_error)
                 on_error(inst, errcode);
             return FALSE;
         }
-        /* XXX the backend commit code should clear dirty!! */
-        priv->dirty = FALSE;
     }
     priv->infant = FALSE;
 
@@ -1047,6 +1065,20 @@ qof_commit_edit_part2(QofInstance *inst,
     return TRUE;
 }
 
+QofBackendError
+qof_instance_commit_deferred (QofInstance *inst)
+{
+    auto priv = GET_PRIVATE(inst);
+    auto be = qof_book_get_backend(priv->book);
+
+    if (!be)
+        return ERR_BACKEND_NO_ERR;
+    auto errcode = commit_to_backend(inst, be);
+    if (errcode == ERR_BACKEND_NO_ERR)
+        priv->infant = FALSE;
+    return errcode;
+}
+
 gboolean
 qof_instance_has_kvp (QofInstance *inst)
 {
@@ -38,6 +38,11 @@ extern "C"
 #include "qofclass-p.h"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
+#include "qofqueryindex-p.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
 static QofLogModule log_module = QOF_MOD_QUERY;
 
@@ -54,6 +59,8 @@ struct _QofQueryTerm
      */
     GSList *                param_fcns;
     QofQueryPredicateFunc   pred_fcn;
+    /* The same test specialised for this term, if it has such a form */
+    QofQueryCompiledPred *  compiled;
 };
 
 struct _QofQuerySort
@@ -93,6 +100,9 @@ struct _QofQuery
     /* The maximum number of results to return */
     gint              max_results;
 
+    /* Whether the objects may be checked on several threads at once */
+    gboolean          parallel;
+
     /* list of books that will be participating in the query */
     GList *           books;
 
@@ -106,11 +116,27 @@ struct _QofQuery
     GList *           results;
 };
 
+/* An object that passed the query, and when it was found. */
+struct QofQueryMatch
+{
+    gpointer          object;
+    size_t            seq;
+};
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
-    GList *           list;
-    gint              count;
+    /* The matches, in the order found.  If the query is sorted and
+     * limited to max_results, only the last max_results in sort order
+     * are kept, in a heap with the first of them on top. */
+    std::vector<QofQueryMatch> matches;
+    size_t            count;
+    size_t            limit;
+    bool              sorted;
+    /* For parallel queries, the objects to check once they have all
+     * been gathered. */
+    bool              deferred;
+    std::vector<gpointer> pending;
 } QofQueryCB;
 
 /* initial_term will be owned by the new Query */
@@ -182,6 +208,8 @@ static void free_query_term (QofQueryTerm *qt)
     qof_query_core_predicate_free (qt->pdata);
     g_slist_free (qt->param_list);
     g_slist_free (qt->param_fcns);
+    if (qt->compiled)
+        qof_query_compiled_predicate_free (qt->compiled);
     g_free (qt);
 }
 
@@ -194,6 +222,7 @@ static QofQueryTerm * copy_query_term (const QofQueryTerm *qt)
     memcpy (new_qt, qt, sizeof(QofQueryTerm));
     new_qt->param_list = g_slist_copy (qt->param_list);
     new_qt->param_fcns = g_slist_copy (qt->param_fcns);
+    new_qt->compiled = NULL;
     new_qt->pdata = qof_query_core_predicate_copy (qt->pdata);
     return new_qt;
 }
@@ -356,6 +385,63 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
     }
 }
 
+/* Matches that sort_func finds equal stay in the order they were found,
+ * as g_list_sort_with_data would leave them. */
+static bool
+match_less (const QofQuery *q, const QofQueryMatch& a, const QofQueryMatch& b)
+{
+    int retval = sort_func (a.object, b.object, const_cast<QofQuery*>(q));
+    return retval < 0 || (retval == 0 && a.seq < b.seq);
+}
+
+static gboolean
+query_is_sorted (const QofQuery *q)
+{
+    return q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+           (q->primary_sort.use_default && q->defaultSort);
+}
+
+static void
+query_cb_add_match (QofQueryCB *qcb, gpointer object)
+{
+    QofQueryMatch match {object, qcb->count++};
+    auto& matches = qcb->matches;
+
+    if (qcb->limit == 0)
+        return;
+
+    if (!qcb->sorted)
+    {
+        /* Only the last limit found are wanted; drop the earlier ones
+         * now and then rather than keeping them all. */
+        matches.push_back (match);
+        if (qcb->limit != SIZE_MAX && matches.size () >= 2 * qcb->limit)
+            matches.erase (matches.begin (), matches.end () - qcb->limit);
+        return;
+    }
+    if (qcb->limit == SIZE_MAX)
+    {
+        matches.push_back (match);
+        return;
+    }
+
+    /* Keep the limit greatest in a heap with the least of them on top,
+     * so that a new match either displaces it or is discarded. */
+    auto greater = [qcb](const QofQueryMatch& a, const QofQueryMatch& b)
+        { return match_less (qcb->query, b, a); };
+    if (matches.size () < qcb->limit)
+    {
+        matches.push_back (match);
+        std::push_heap (matches.begin (), matches.end (), greater);
+    }
+    else if (match_less (qcb->query, matches.front (), match))
+    {
+        std::pop_heap (matches.begin (), matches.end (), greater);
+        matches.back () = match;
+        std::push_heap (matches.begin (), matches.end (), greater);
+    }
+}
+
 /* ==================================================================== */
 /* This is the main workhorse for performing the query.  For each
  * object, it walks over all of the query terms to see if the
@@ -377,7 +463,16 @@ check_object (const QofQuery *q, gpointer object)
 	     and_ptr = static_cast<GList*>(and_ptr->next))
         {
             qt = (QofQueryTerm *)(and_ptr->data);
-            if (qt->param_fcns && qt->pred_fcn)
+            if (qt->compiled)
+            {
+                if (qof_query_compiled_predicate_match (qt->compiled,
+                                                        object) == qt->invert)
+                {
+                    and_terms_ok = 0;
+                    break;
+                }
+            }
+            else if (qt->param_fcns && qt->pred_fcn)
             {
                 const GSList *node;
                 QofParam *param = NULL;
@@ -526,6 +621,9 @@ static void compile_terms (QofQuery *q)
 
             g_slist_free (qt->param_fcns);
             qt->param_fcns = NULL;
+            if (qt->compiled)
+                qof_query_compiled_predicate_free (qt->compiled);
+            qt->compiled = NULL;
 
             /* Walk the parameter list of obtain the parameter functions */
             qt->param_fcns = compile_params (qt->param_list, q->search_for,
@@ -539,6 +637,11 @@ static void compile_terms (QofQuery *q)
                 qt->pred_fcn = qof_query_core_get_predicate (resObj->param_type);
             else
                 qt->pred_fcn = NULL;
+
+            if (qt->pred_fcn)
+                qt->compiled = qof_query_core_compile_predicate (qt->param_fcns,
+                                                                 resObj->param_type,
+                                                                 qt->pdata);
         }
     }
 
@@ -573,14 +676,91 @@ static void check_item_cb (gpointer object, gpointer user_data)
 
     if (!object || !ql) return;
 
-    if (check_object (ql->query, object))
+    if (ql->deferred)
     {
-        ql->list = g_list_prepend (ql->list, object);
-        ql->count++;
+        ql->pending.push_back (object);
+        return;
     }
+    if (check_object (ql->query, object))
+        query_cb_add_match (ql, object);
     return;
 }
 
+/* Below this many objects, starting threads costs more than it saves. */
+static const size_t parallel_threshold = 10000;
+/* How many objects a thread takes on at a time. */
+static const size_t parallel_chunk = 512;
+
+typedef struct
+{
+    const QofQuery *            query;
+    const std::vector<gpointer> *objects;
+    std::vector<char> *         passed;
+    gint                        next_chunk;
+} QofQueryWork;
+
+/* Check chunks of the objects until there are none left.  Each thread
+ * takes the next unclaimed chunk, so one that gets slow objects doesn't
+ * hold the others up. */
+static gpointer
+check_chunks (gpointer data)
+{
+    QofQueryWork *work = static_cast<QofQueryWork*>(data);
+    size_t size = work->objects->size ();
+
+    for (;;)
+    {
+        size_t begin = parallel_chunk *
+                       static_cast<size_t>(g_atomic_int_add (&work->next_chunk, 1));
+        size_t end = MIN (begin + parallel_chunk, size);
+
+        if (begin >= size) break;
+        for (size_t i = begin; i < end; ++i)
+            (*work->passed)[i] = check_object (work->query,
+                                               (*work->objects)[i]);
+    }
+    return NULL;
+}
+
+static void
+check_pending_objects (QofQueryCB *qcb)
+{
+    const auto& objects = qcb->pending;
+    std::vector<char> passed (objects.size ());
+    std::vector<GThread*> threads;
+    QofQueryWork work {qcb->query, &objects, &passed, 0};
+    size_t num_threads = MIN (static_cast<size_t>(g_get_num_processors ()),
+                              objects.size () / parallel_chunk);
+
+    if (objects.size () < parallel_threshold || num_threads < 2)
+    {
+        for (auto object : objects)
+            if (check_object (qcb->query, object))
+                query_cb_add_match (qcb, object);
+        return;
+    }
+
+    /* This thread does its share too. */
+    for (size_t i = 1; i < num_threads; ++i)
+    {
+        GThread *thread = g_thread_try_new ("qof-query", check_chunks, &work,
+                                            NULL);
+        if (thread)
+            threads.push_back (thread);
+    }
+    check_chunks (&work);
+    for (auto thread : threads)
+        g_thread_join (thread);
+    PINFO ("checked %zu objects on %zu threads", objects.size (),
+           threads.size () + 1);
+
+    /* Take the matches in the order the objects were found, as a serial
+     * run would have. */
+    for (size_t i = 0; i < objects.size (); ++i)
+        if (passed[i])
+            query_cb_add_match (qcb, objects[i]);
+}
+
 static int param_list_cmp (const QofQueryParamList *l1, const QofQueryParamList *l2)
 {
     int ret;
@@ -728,7 +908,6 @@ static GList * qof_query_run_internal (QofQuery *q,
                                        gpointer cb_arg)
 {
     GList *matching_objects = NULL;
-    int        object_count = 0;
 
     if (!q) return NULL;
     g_return_val_if_fail (q->search_for, NULL);
@@ -752,57 +931,33 @@ static GList * qof_query_run_internal (QofQuery *q,
     /* Now run the query over all the objects and save the results */
     {
         QofQueryCB qcb;
+        size_t index;
 
-        memset (&qcb, 0, sizeof (qcb));
         qcb.query = q;
+        qcb.count = 0;
+        qcb.limit = q->max_results < 0 ? SIZE_MAX : q->max_results;
+        qcb.sorted = query_is_sorted (q);
+        qcb.deferred = q->parallel;
 
         /* Run the query callback */
         run_cb(&qcb, cb_arg);
-
-        matching_objects = qcb.list;
-        object_count = qcb.count;
-    }
-    PINFO ("matching objects=%p count=%d", matching_objects, object_count);
-
-    /* There is no absolute need to reverse this list, since it's being
-     * sorted below. However, in the common case, we will be searching
-     * in a confined location where the objects are already in order,
-     * thus reversing will put us in the correct order we want and make
-     * the sorting go much faster.
-     */
-    matching_objects = g_list_reverse(matching_objects);
-
-    /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
-    {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
-    }
-
-    /* Crop the list to limit the number of splits. */
-    if ((object_count > q->max_results) && (q->max_results > -1))
-    {
-        if (q->max_results > 0)
-        {
-            GList *mptr;
-
-            /* mptr is set to the first node of what will be the new list */
-            mptr = g_list_nth(matching_objects, object_count - q->max_results);
-            /* mptr should not be NULL, but let's be safe */
-            if (mptr != NULL)
-            {
-                if (mptr->prev != NULL) mptr->prev->next = NULL;
-                mptr->prev = NULL;
-            }
-            g_list_free(matching_objects);
-            matching_objects = mptr;
-        }
-        else
-        {
-            /* q->max_results == 0 */
-            g_list_free(matching_objects);
-            matching_objects = NULL;
-        }
+        if (qcb.deferred)
+            check_pending_objects (&qcb);
+        PINFO ("matching objects count=%zu kept=%zu", qcb.count,
+               qcb.matches.size ());
+
+        /* Now sort the matching objects based on the search criteria */
+        if (qcb.sorted)
+            std::sort (qcb.matches.begin (), qcb.matches.end (),
+                       [q](const QofQueryMatch& a, const QofQueryMatch& b)
+                       { return match_less (q, a, b); });
+
+        /* Crop to the last max_results matches. */
+        index = qcb.matches.size () > qcb.limit ?
+                qcb.matches.size () - qcb.limit : 0;
+        for (auto iter = qcb.matches.rbegin ();
+             iter != qcb.matches.rend () - index; ++iter)
+            matching_objects = g_list_prepend (matching_objects, iter->object);
     }
 
     q->changed = 0;
@@ -839,9 +994,13 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 #endif
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+        /* And then iterate over all the objects, or just those an
+         * index picks out */
+        if (!qof_query_index_foreach (book, qcb->query,
+                                      (QofInstanceForeachCB) check_item_cb,
+                                      qcb))
+            qof_object_foreach (qcb->query->search_for, book,
+                                (QofInstanceForeachCB) check_item_cb, qcb);
     }
 }
 
@@ -1050,6 +1209,7 @@ QofQuery * qof_query_invert (QofQuery *q)
     case 0:
         retval = qof_query_create();
         retval->max_results = q->max_results;
+        retval->parallel = q->parallel;
         break;
 
         /* This is the DeMorgan expansion for a single AND expression. */
@@ -1057,6 +1217,7 @@ QofQuery * qof_query_invert (QofQuery *q)
     case 1:
         retval = qof_query_create();
         retval->max_results = q->max_results;
+        retval->parallel = q->parallel;
         retval->books = g_list_copy (q->books);
         retval->search_for = q->search_for;
         retval->changed = 1;
@@ -1090,6 +1251,7 @@ QofQuery * qof_query_invert (QofQuery *q)
         retval = qof_query_merge(iright, ileft, QOF_QUERY_AND);
         retval->books          = g_list_copy (q->books);
         retval->max_results    = q->max_results;
+        retval->parallel       = q->parallel;
         retval->search_for     = q->search_for;
         retval->changed        = 1;
 
@@ -1150,6 +1312,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
             g_list_concat(copy_or_terms(q1->terms), copy_or_terms(q2->terms));
         retval->books           = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
         break;
 
@@ -1157,6 +1320,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
         retval = qof_query_create();
         retval->books          = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
 
         /* g_list_append() can take forever, so let's build the list in
@@ -1274,6 +1438,12 @@ void qof_query_set_max_results (QofQuery *q, int n)
     q->max_results = n;
 }
 
+void qof_query_set_parallel (QofQuery *q, gboolean parallel)
+{
+    if (!q) return;
+    q->parallel = parallel;
+}
+
 void qof_query_add_guid_list_match (QofQuery *q, QofQueryParamList *param_list,
                                     GList *guid_list, QofGuidMatch options,
                                     QofQueryOp op)
@@ -1349,6 +1519,7 @@ void qof_query_init (void)
 
 void qof_query_shutdown (void)
 {
+    qof_query_index_shutdown ();
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
@@ -127,6 +127,62 @@ void qof_query_init (void);
 void qof_query_shutdown (void);
 // @}
 
+/* --------------------------------------------------------- */
+/** \name Secondary Indexes
+ *
+ * Without help, qof_query_run() hands every object in a book's
+ * collection to the query's predicates.  An object type can register
+ * indexes on parameters that queries often restrict, such as a split's
+ * account or its transaction's posted date.  In a book that has
+ * indexes enabled, qof_query_run() looks the candidates up in the
+ * index when one of the terms is selective enough and runs the
+ * predicates on those alone.  The results are the same either way.
+ *
+ * Indexes are built the first time a query can use them and are kept
+ * up to date from QOF events, so they see an object's state as of its
+ * last commit.  Objects in the middle of an edit are only found under
+ * their last committed values, and while events are suspended queries
+ * scan the whole collection.
+ *
+ * Indexes can serve GUID terms matching any of a list of GUIDs, date
+ * comparisons other than QOF_COMPARE_NEQ, QOF_CHAR_MATCH_ANY terms and
+ * case-sensitive string terms testing for equality or, as a regular
+ * expression, for a literal prefix ("^Groceries").
+ */
+// @{
+
+/** Return the objects whose index entries may need refreshing when
+ *  the given object changes.  The list is not freed. */
+typedef GList * (*QofQueryIndexDependents) (gpointer object);
+
+/** Offer an index of the objects of type obj_type on the value found
+ *  by following param_path from them.  The value must be a GUID,
+ *  date, char or string.
+ *
+ *  If the path passes through another object whose own changes don't
+ *  generate events for the indexed objects, as a split's transaction
+ *  posted date does, give that object's type and a function listing
+ *  the indexed objects that depend on it.
+ *
+ *  @param obj_type The type of the objects to index.
+ *  @param param_path The parameters leading to the value to index
+ *  them by.  The list becomes the property of the query subsystem.
+ *  @param dependent_type The type of the objects further along the
+ *  path, or NULL.
+ *  @param dependents Lists the indexed objects depending on an object
+ *  of dependent_type, or NULL.
+ */
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               QofQueryParamList *param_path,
+                               QofIdTypeConst dependent_type,
+                               QofQueryIndexDependents dependents);
+
+/** Turn the use of the registered indexes for a book's queries on or
+ *  off.  They are off by default.  Turning them off frees them.
+ */
+void qof_query_enable_indexes (QofBook *book, gboolean enable);
+// @}
+
 /* --------------------------------------------------------- */
 /** \name Low-Level API Functions */
 // @{
@@ -360,6 +416,17 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
  */
 void qof_query_set_max_results (QofQuery *q, int n);
 
+/**
+ * Allow qof_query_run() and qof_query_run_subquery() to check large
+ * numbers of objects against the query on several threads at once.
+ * The results are the same, in the same order, as a serial run's.
+ *
+ * Only do this for queries whose parameter getters merely read the
+ * objects, and don't change the objects while the query runs.  Runs
+ * over fewer than a few thousand objects stay on the calling thread.
+ */
+void qof_query_set_parallel (QofQuery *q, gboolean parallel);
+
 /** Compare two queries for equality.
  * Query terms are compared each to each.
  * This is a simplistic
@@ -52,6 +52,19 @@ QofCompareFunc qof_query_core_get_compare (gchar const *type);
 /* Compare two predicates */
 gboolean qof_query_core_predicate_equal (const QofQueryPredData *p1, const QofQueryPredData *p2);
 
+/* A query term specialised for its parameter chain and predicate data.
+ * Returns NULL if the predicate has no specialised form, in which case
+ * the predicate function has to be used. */
+typedef struct QofQueryCompiledPred QofQueryCompiledPred;
+QofQueryCompiledPred *qof_query_core_compile_predicate (const GSList *param_fcns,
+                                                        QofType param_type,
+                                                        const QofQueryPredData *pd);
+/* Follow the parameter chain from object and test the value found, as
+ * the predicate function would. */
+gboolean qof_query_compiled_predicate_match (const QofQueryCompiledPred *pred,
+                                             gpointer object);
+void qof_query_compiled_predicate_free (QofQueryCompiledPred *pred);
+
 /* Predicate Data Structures:
  *
  * These are defined such that you can cast between these types and
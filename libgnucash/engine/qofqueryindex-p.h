@@ -0,0 +1,50 @@
+/********************************************************************\
+ * qofqueryindex-p.h -- secondary indexes for QofQuery              *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#ifndef QOF_QUERY_INDEX_P_H
+#define QOF_QUERY_INDEX_P_H
+
+#include "qofquery.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Call cb on every object in book that the indexes say might match
+ * the query; the caller still has to check them against the query.
+ * Returns FALSE without calling cb if the book has no indexes that
+ * would cut the search down and the whole collection has to be
+ * scanned instead.  The query must already have been compiled.
+ */
+gboolean qof_query_index_foreach (QofBook *book, const QofQuery *q,
+                                  QofInstanceForeachCB cb,
+                                  gpointer user_data);
+
+/* Forget the registered indexes. */
+void qof_query_index_shutdown (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QOF_QUERY_INDEX_P_H */
@@ -0,0 +1,718 @@
+/********************************************************************\
+ * qofqueryindex.cpp -- secondary indexes for QofQuery              *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+
+#include <glib.h>
+#include <string.h>
+}
+
+#include "qof.h"
+#include "qofevent-p.h"
+#include "qofid-p.h"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
+#include "qofqueryindex-p.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static QofLogModule log_module = QOF_MOD_QUERY;
+
+static const char *book_indexes_key = "qof-query-indexes";
+
+/* The getters' signatures, as in qofquerycore.cpp. */
+typedef const GncGUID * (*query_guid_getter) (gpointer, QofParam *);
+typedef time64 (*query_date_getter) (gpointer, QofParam *);
+typedef char (*query_char_getter) (gpointer, QofParam *);
+typedef const char * (*query_string_getter) (gpointer, QofParam *);
+
+struct QofQueryIndexDef
+{
+    QofIdTypeConst obj_type;
+    QofQueryParamList *param_path;
+    QofIdTypeConst dependent_type;
+    QofQueryIndexDependents dependents;
+    /* Set once the path turned out not to lead to an indexable value. */
+    bool unusable;
+};
+
+static std::vector<QofQueryIndexDef> index_defs;
+
+static bool
+param_path_equal (const QofQueryParamList *a, const QofQueryParamList *b)
+{
+    for (; a && b; a = a->next, b = b->next)
+        if (g_strcmp0 (static_cast<const char*>(a->data),
+                       static_cast<const char*>(b->data)))
+            return false;
+    return !a && !b;
+}
+
+namespace
+{
+/* The objects one index lookup would produce. */
+class IndexScan
+{
+public:
+    virtual ~IndexScan () = default;
+    /* How many objects the scan produces, counting no further than
+     * limit. */
+    virtual size_t count (size_t limit) const = 0;
+    virtual void foreach (const std::function<void(gpointer)>& func) const = 0;
+};
+
+class QueryIndex
+{
+public:
+    QueryIndex (const QofQueryIndexDef& def, GSList *getters) :
+        m_obj_type {def.obj_type}, m_param_path {g_slist_copy (def.param_path)},
+        m_dependent_type {def.dependent_type},
+        m_dependents {def.dependents}, m_getters {getters} {}
+    virtual ~QueryIndex ()
+    {
+        g_slist_free (m_param_path);
+        g_slist_free (m_getters);
+    }
+    /* File the object under its current value. */
+    virtual void update (gpointer object) = 0;
+    virtual void remove (gpointer object) = 0;
+    /* A scan producing the objects that could pass all of and_terms, or
+     * nullptr if none of them can use this index. */
+    virtual std::unique_ptr<IndexScan> plan (const GList *and_terms) const = 0;
+    void handle_event (QofInstance *ent, QofEventId event_type);
+
+protected:
+    /* Follow the parameter path as check_object does, up to the object
+     * that the last getter is called on. */
+    gpointer key_object (gpointer object, QofParam **getter) const
+    {
+        GSList *node;
+        for (node = m_getters; node->next; node = node->next)
+        {
+            auto param = static_cast<QofParam*>(node->data);
+            object = param->param_getfcn (object, param);
+        }
+        *getter = static_cast<QofParam*>(node->data);
+        return object;
+    }
+    bool serves (const QofQueryTerm *term) const
+    {
+        return !qof_query_term_is_inverted (term) &&
+            param_path_equal (qof_query_term_get_param_path (term),
+                              m_param_path);
+    }
+
+private:
+    QofIdTypeConst m_obj_type;
+    QofQueryParamList *m_param_path;
+    QofIdTypeConst m_dependent_type;
+    QofQueryIndexDependents m_dependents;
+    GSList *m_getters;
+};
+
+void
+QueryIndex::handle_event (QofInstance *ent, QofEventId event_type)
+{
+    if (!g_strcmp0 (ent->e_type, m_obj_type))
+    {
+        if ((event_type & QOF_EVENT_DESTROY) ||
+            qof_instance_get_destroying (ent))
+            remove (ent);
+        else
+            update (ent);
+    }
+    else if (m_dependents && !g_strcmp0 (ent->e_type, m_dependent_type) &&
+             !(event_type & QOF_EVENT_DESTROY) &&
+             !qof_instance_get_destroying (ent))
+    {
+        for (auto node = m_dependents (ent); node; node = node->next)
+            if (!qof_instance_get_destroying (node->data))
+                update (node->data);
+    }
+}
+
+/* An inclusive range of keys, or one open at the top. */
+template <typename Key> struct KeyRange
+{
+    Key lo;
+    Key hi;
+    bool hi_excluded;
+};
+
+/* The key types.  Each knows its QOF type, how to get the key from an
+ * object and which keys a predicate can match. */
+struct GuidLess
+{
+    bool operator() (const GncGUID& a, const GncGUID& b) const
+    {
+        return memcmp (a.reserved, b.reserved, GUID_DATA_SIZE) < 0;
+    }
+};
+
+struct GuidKey
+{
+    using Key = GncGUID;
+    using Less = GuidLess;
+    static constexpr const char *type_name = QOF_TYPE_GUID;
+
+    static bool get (gpointer object, QofParam *getter, Key& key)
+    {
+        auto guid = ((query_guid_getter)getter->param_getfcn) (object, getter);
+        if (!guid)
+            return false;
+        key = *guid;
+        return true;
+    }
+    static bool ranges (const QofQueryPredData *pd,
+                        std::vector<KeyRange<Key>>& ranges)
+    {
+        auto pdata = reinterpret_cast<const query_guid_def*>(pd);
+        if (pdata->options != QOF_GUID_MATCH_ANY)
+            return false;
+        for (auto node = pdata->guids; node; node = node->next)
+        {
+            /* A NULL in the list matches objects without a GUID, which
+             * aren't in the index. */
+            if (!node->data)
+                return false;
+            auto guid = static_cast<const GncGUID*>(node->data);
+            ranges.push_back ({*guid, *guid, false});
+        }
+        return true;
+    }
+};
+
+struct DateKey
+{
+    using Key = time64;
+    using Less = std::less<time64>;
+    static constexpr const char *type_name = QOF_TYPE_DATE;
+
+    static bool get (gpointer object, QofParam *getter, Key& key)
+    {
+        key = ((query_date_getter)getter->param_getfcn) (object, getter);
+        return true;
+    }
+    static bool ranges (const QofQueryPredData *pd,
+                        std::vector<KeyRange<Key>>& ranges)
+    {
+        auto pdata = reinterpret_cast<const query_date_def*>(pd);
+        /* QOF_DATE_MATCH_DAY compares the days the dates fall on, which
+         * in any time zone lie within two days of the dates themselves.
+         * LT and GT are looked up as LTE and GTE; the predicates weed
+         * out the extra objects. */
+        const time64 slop = pdata->options == QOF_DATE_MATCH_DAY ?
+            2 * 24 * 3600 : 0;
+        time64 lo = G_MININT64, hi = G_MAXINT64;
+
+        switch (pd->how)
+        {
+        case QOF_COMPARE_LT:
+        case QOF_COMPARE_LTE:
+            hi = pdata->date > G_MAXINT64 - slop ? G_MAXINT64 :
+                pdata->date + slop;
+            break;
+        case QOF_COMPARE_GT:
+        case QOF_COMPARE_GTE:
+            lo = pdata->date < G_MININT64 + slop ? G_MININT64 :
+                pdata->date - slop;
+            break;
+        case QOF_COMPARE_EQUAL:
+            lo = pdata->date < G_MININT64 + slop ? G_MININT64 :
+                pdata->date - slop;
+            hi = pdata->date > G_MAXINT64 - slop ? G_MAXINT64 :
+                pdata->date + slop;
+            break;
+        default:
+            return false;
+        }
+        ranges.push_back ({lo, hi, false});
+        return true;
+    }
+};
+
+struct CharKey
+{
+    using Key = char;
+    using Less = std::less<char>;
+    static constexpr const char *type_name = QOF_TYPE_CHAR;
+
+    static bool get (gpointer object, QofParam *getter, Key& key)
+    {
+        key = ((query_char_getter)getter->param_getfcn) (object, getter);
+        return true;
+    }
+    static bool ranges (const QofQueryPredData *pd,
+                        std::vector<KeyRange<Key>>& ranges)
+    {
+        auto pdata = reinterpret_cast<const query_char_def*>(pd);
+        if (pdata->options != QOF_CHAR_MATCH_ANY || !pdata->char_list)
+            return false;
+        /* strchr finds the terminating nul too, so '\0' always matches. */
+        ranges.push_back ({'\0', '\0', false});
+        for (auto c = pdata->char_list; *c; ++c)
+            ranges.push_back ({*c, *c, false});
+        return true;
+    }
+};
+
+struct StringKey
+{
+    using Key = std::string;
+    using Less = std::less<std::string>;
+    static constexpr const char *type_name = QOF_TYPE_STRING;
+
+    static bool get (gpointer object, QofParam *getter, Key& key)
+    {
+        auto s = ((query_string_getter)getter->param_getfcn) (object, getter);
+        key = s ? s : "";
+        return true;
+    }
+    static bool ranges (const QofQueryPredData *pd,
+                        std::vector<KeyRange<Key>>& ranges)
+    {
+        auto pdata = reinterpret_cast<const query_string_def*>(pd);
+        if (pd->how != QOF_COMPARE_EQUAL ||
+            pdata->options != QOF_STRING_MATCH_NORMAL || !pdata->matchstring)
+            return false;
+        if (!pdata->is_regex)
+        {
+            ranges.push_back ({pdata->matchstring, pdata->matchstring, false});
+            return true;
+        }
+
+        /* A regular expression that is a caret and some ordinary
+         * characters matches the strings with those characters as
+         * their prefix, which run from the prefix up to the first
+         * string that is neither it nor starts with it. */
+        auto match = pdata->matchstring;
+        if (match[0] != '^' || !match[1] ||
+            strpbrk (match + 1, ".[]()*+?{}|^$\\"))
+            return false;
+        std::string prefix {match + 1}, next {prefix};
+        while (!next.empty () &&
+               static_cast<unsigned char>(next.back ()) == 0xff)
+            next.pop_back ();
+        if (next.empty ())
+            return false;
+        next.back () = static_cast<char>(static_cast<unsigned char>(next.back ()) + 1);
+        ranges.push_back ({prefix, next, true});
+        return true;
+    }
+};
+
+template <typename Traits>
+class KeyedIndex : public QueryIndex
+{
+    using Key = typename Traits::Key;
+    using Less = typename Traits::Less;
+    using Range = KeyRange<Key>;
+    using Map = std::multimap<Key, gpointer, Less>;
+
+    class Scan : public IndexScan
+    {
+    public:
+        Scan (const Map& map, std::vector<Range>&& ranges) :
+            m_map (map), m_ranges {std::move (ranges)} {}
+        size_t count (size_t limit) const override
+        {
+            size_t n = 0;
+            for (auto& range : m_ranges)
+            {
+                if (Less {} (range.hi, range.lo))
+                    continue;
+                auto last = end (range);
+                for (auto iter = m_map.lower_bound (range.lo);
+                     iter != last && n < limit; ++iter)
+                    ++n;
+            }
+            return n;
+        }
+        void foreach (const std::function<void(gpointer)>& func) const override
+        {
+            for (auto& range : m_ranges)
+            {
+                if (Less {} (range.hi, range.lo))
+                    continue;
+                auto last = end (range);
+                for (auto iter = m_map.lower_bound (range.lo);
+                     iter != last; ++iter)
+                    func (iter->second);
+            }
+        }
+    private:
+        typename Map::const_iterator end (const Range& range) const
+        {
+            return range.hi_excluded ? m_map.lower_bound (range.hi) :
+                m_map.upper_bound (range.hi);
+        }
+        const Map& m_map;
+        std::vector<Range> m_ranges;
+    };
+
+public:
+    using QueryIndex::QueryIndex;
+
+    void update (gpointer object) override
+    {
+        QofParam *getter;
+        auto key_obj = key_object (object, &getter);
+        Key key;
+
+        auto iter = m_entries.find (object);
+        if (!Traits::get (key_obj, getter, key))
+        {
+            remove (object);
+            return;
+        }
+        if (iter != m_entries.end ())
+        {
+            /* Most events don't change the indexed value. */
+            auto& old_key = iter->second->first;
+            if (!Less {} (old_key, key) && !Less {} (key, old_key))
+                return;
+            m_map.erase (iter->second);
+            iter->second = m_map.emplace (std::move (key), object);
+        }
+        else
+            m_entries.emplace (object, m_map.emplace (std::move (key), object));
+    }
+
+    void remove (gpointer object) override
+    {
+        auto iter = m_entries.find (object);
+        if (iter == m_entries.end ())
+            return;
+        m_map.erase (iter->second);
+        m_entries.erase (iter);
+    }
+
+    std::unique_ptr<IndexScan> plan (const GList *and_terms) const override
+    {
+        std::vector<Range> ranges;
+        bool planned = false;
+
+        for (auto node = and_terms; node; node = node->next)
+        {
+            auto term = static_cast<const QofQueryTerm*>(node->data);
+            auto pd = qof_query_term_get_pred_data (term);
+            std::vector<Range> term_ranges;
+
+            if (!serves (term) || g_strcmp0 (pd->type_name, Traits::type_name) ||
+                !Traits::ranges (pd, term_ranges))
+                continue;
+            if (!planned)
+            {
+                ranges = std::move (term_ranges);
+                planned = true;
+            }
+            /* Terms bounding a range from either side narrow it down. */
+            else if (ranges.size () == 1 && term_ranges.size () == 1)
+                ranges[0] = intersect (ranges[0], term_ranges[0]);
+            else if (term_ranges.size () < ranges.size ())
+                ranges = std::move (term_ranges);
+        }
+        if (!planned)
+            return nullptr;
+        return std::unique_ptr<IndexScan> (new Scan (m_map, std::move (ranges)));
+    }
+
+private:
+    static Range intersect (const Range& a, const Range& b)
+    {
+        Less less;
+        Range range = a;
+        if (less (a.lo, b.lo))
+            range.lo = b.lo;
+        if (less (b.hi, a.hi))
+        {
+            range.hi = b.hi;
+            range.hi_excluded = b.hi_excluded;
+        }
+        else if (!less (a.hi, b.hi))
+            range.hi_excluded = a.hi_excluded || b.hi_excluded;
+        return range;
+    }
+
+    Map m_map;
+    std::unordered_map<gpointer, typename Map::iterator> m_entries;
+};
+
+/* The indexes of one book.  They are built when first wanted. */
+struct BookIndexes
+{
+    BookIndexes (QofBook *book) : m_book {book},
+        m_epoch {qof_event_get_suspend_epoch ()} {}
+    QueryIndex *get (size_t def_no);
+    void check_current ();
+
+    QofBook *m_book;
+    gint m_handler_id = 0;
+    guint m_epoch;
+    std::vector<std::unique_ptr<QueryIndex>> m_indexes;
+};
+}
+
+static void
+add_to_index (QofInstance *inst, gpointer user_data)
+{
+    static_cast<QueryIndex*>(user_data)->update (inst);
+}
+
+static QueryIndex *
+make_index (QofQueryIndexDef& def)
+{
+    QofIdTypeConst type = def.obj_type;
+    GSList *getters = NULL;
+
+    for (auto node = def.param_path; node; node = node->next)
+    {
+        auto param = qof_class_get_parameter (type,
+                                              static_cast<const char*>(node->data));
+        if (!param)
+        {
+            PWARN ("%s has no parameter %s", type,
+                   static_cast<const char*>(node->data));
+            g_slist_free (getters);
+            def.unusable = true;
+            return nullptr;
+        }
+        getters = g_slist_prepend (getters, const_cast<QofParam*>(param));
+        type = param->param_type;
+    }
+    getters = g_slist_reverse (getters);
+
+    if (!g_strcmp0 (type, QOF_TYPE_GUID))
+        return new KeyedIndex<GuidKey> (def, getters);
+    if (!g_strcmp0 (type, QOF_TYPE_DATE))
+        return new KeyedIndex<DateKey> (def, getters);
+    if (!g_strcmp0 (type, QOF_TYPE_CHAR))
+        return new KeyedIndex<CharKey> (def, getters);
+    if (!g_strcmp0 (type, QOF_TYPE_STRING))
+        return new KeyedIndex<StringKey> (def, getters);
+
+    PWARN ("can't index %s by values of type %s", def.obj_type, type);
+    g_slist_free (getters);
+    def.unusable = true;
+    return nullptr;
+}
+
+QueryIndex *
+BookIndexes::get (size_t def_no)
+{
+    auto& def = index_defs[def_no];
+
+    if (def.unusable)
+        return nullptr;
+    if (m_indexes.size () <= def_no)
+        m_indexes.resize (index_defs.size ());
+    if (!m_indexes[def_no])
+    {
+        auto index = make_index (def);
+        if (!index)
+            return nullptr;
+        ENTER ("book=%p type=%s", m_book, def.obj_type);
+        qof_collection_foreach (qof_book_get_collection (m_book, def.obj_type),
+                                add_to_index, index);
+        m_indexes[def_no].reset (index);
+        LEAVE (" ");
+    }
+    return m_indexes[def_no].get ();
+}
+
+/* Anything that happened while events were suspended went unseen, so
+ * start the indexes afresh. */
+void
+BookIndexes::check_current ()
+{
+    auto epoch = qof_event_get_suspend_epoch ();
+    if (epoch == m_epoch)
+        return;
+    m_indexes.clear ();
+    m_epoch = epoch;
+}
+
+static void
+query_index_event_handler (QofInstance *ent, QofEventId event_type,
+                           gpointer user_data, gpointer event_data)
+{
+    auto indexes = static_cast<BookIndexes*>(user_data);
+
+    if (!ent || qof_instance_get_book (ent) != indexes->m_book)
+        return;
+    for (auto& index : indexes->m_indexes)
+        if (index)
+            index->handle_event (ent, event_type);
+}
+
+static void
+book_indexes_destroy (BookIndexes *indexes)
+{
+    if (!indexes)
+        return;
+    qof_event_unregister_handler (indexes->m_handler_id);
+    delete indexes;
+}
+
+static void
+book_indexes_finalize (QofBook *book, gpointer key, gpointer user_data)
+{
+    book_indexes_destroy (static_cast<BookIndexes*>(user_data));
+}
+
+void
+qof_query_register_index (QofIdTypeConst obj_type,
+                          QofQueryParamList *param_path,
+                          QofIdTypeConst dependent_type,
+                          QofQueryIndexDependents dependents)
+{
+    g_return_if_fail (obj_type && param_path);
+
+    for (auto& def : index_defs)
+        if (!g_strcmp0 (def.obj_type, obj_type) &&
+            param_path_equal (def.param_path, param_path))
+        {
+            g_slist_free (param_path);
+            return;
+        }
+    index_defs.push_back ({obj_type, param_path, dependent_type, dependents,
+                           false});
+}
+
+void
+qof_query_enable_indexes (QofBook *book, gboolean enable)
+{
+    BookIndexes *indexes;
+
+    g_return_if_fail (book);
+
+    indexes = static_cast<BookIndexes*>(qof_book_get_data (book,
+                                                           book_indexes_key));
+    if (enable && !indexes)
+    {
+        indexes = new BookIndexes (book);
+        indexes->m_handler_id =
+            qof_event_register_handler (query_index_event_handler, indexes);
+        qof_book_set_data_fin (book, book_indexes_key, indexes,
+                               book_indexes_finalize);
+    }
+    else if (!enable && indexes)
+    {
+        qof_book_set_data (book, book_indexes_key, NULL);
+        book_indexes_destroy (indexes);
+    }
+}
+
+gboolean
+qof_query_index_foreach (QofBook *book, const QofQuery *q,
+                         QofInstanceForeachCB cb, gpointer user_data)
+{
+    std::vector<std::unique_ptr<IndexScan>> scans;
+    std::unordered_set<gpointer> seen;
+    std::vector<std::pair<size_t, QofInstance*>> found;
+    size_t total = 0, budget;
+    QofCollection *col;
+    QofIdTypeConst search_for;
+    BookIndexes *indexes;
+    GList *terms;
+
+    indexes = static_cast<BookIndexes*>(qof_book_get_data (book,
+                                                           book_indexes_key));
+    terms = qof_query_get_terms (q);
+    if (!indexes || !terms || qof_event_is_suspended ())
+        return FALSE;
+    indexes->check_current ();
+
+    /* Looking objects up is only worth it if it skips most of them. */
+    search_for = qof_query_get_search_for (q);
+    col = qof_book_get_collection (book, search_for);
+    budget = qof_collection_count (col) / 2;
+
+    /* Every OR term needs an index to find its candidates; take the one
+     * that finds fewest. */
+    for (auto or_node = terms; or_node; or_node = or_node->next)
+    {
+        auto and_terms = static_cast<const GList*>(or_node->data);
+        std::unique_ptr<IndexScan> best;
+        size_t best_count = 0;
+
+        for (size_t i = 0; i < index_defs.size (); ++i)
+        {
+            if (g_strcmp0 (index_defs[i].obj_type, search_for))
+                continue;
+            auto index = indexes->get (i);
+            if (!index)
+                continue;
+            auto scan = index->plan (and_terms);
+            if (!scan)
+                continue;
+            auto count = scan->count (best ? best_count : budget - total + 1);
+            if (!best || count < best_count)
+            {
+                best = std::move (scan);
+                best_count = count;
+            }
+        }
+        total += best_count;
+        if (!best || total > budget)
+            return FALSE;
+        scans.push_back (std::move (best));
+    }
+    PINFO ("looking up %zu of %zu objects", total, budget * 2);
+
+    /* The same object can turn up under several keys or OR terms. */
+    found.reserve (total);
+    for (auto& scan : scans)
+        scan->foreach ([&seen, &found, col](gpointer object)
+                       {
+                           auto inst = static_cast<QofInstance*>(object);
+                           if (seen.insert (object).second)
+                               found.emplace_back (
+                                   qof_collection_entity_position (col, inst),
+                                   inst);
+                       });
+
+    /* Hand the objects over in the order a scan would find them, so
+     * that an unsorted query limited to max_results, or a sorted one
+     * with ties, keeps the same ones either way. */
+    std::sort (found.begin (), found.end ());
+    for (auto& entry : found)
+        cb (entry.second, user_data);
+    return TRUE;
+}
+
+void
+qof_query_index_shutdown (void)
+{
+    for (auto& def : index_defs)
+        g_slist_free (def.param_path);
+    index_defs.clear ();
+}
@@ -423,7 +423,7 @@ QofSessionImpl::is_saving () const noexcept
 /* Manipulators (save, load, etc.) -------------------------*/
 
 void
-QofSessionImpl::save (QofPercentageFunc percentage_func) noexcept
+QofSessionImpl::save (QofPercentageFunc percentage_func, bool autosave) noexcept
 {
     if (!qof_book_session_not_saved (m_book)) //Clean book, nothing to do.
         return;
@@ -441,6 +441,7 @@ QofSessionImpl::save (QofPercentageFunc percentage_func) noexcept
     {
 
         backend->set_percentage(percentage_func);
+        backend->set_autosaving(autosave);
         backend->sync(m_book);
         auto err = backend->get_error();
         if (err != ERR_BACKEND_NO_ERR)
@@ -468,6 +469,7 @@ QofSessionImpl::safe_save (QofPercentageFunc percentage_func) noexcept
     auto backend = qof_book_get_backend (m_book);
     if (!backend) return;
     backend->set_percentage(percentage_func);
+    backend->set_autosaving(false);
     backend->safe_sync(get_book ());
     auto err = backend->get_error();
     auto msg = backend->get_message();
@@ -615,6 +617,14 @@ qof_session_save (QofSession *session,
     session->save (percentage_func);
 }
 
+void
+qof_session_autosave (QofSession *session,
+                      QofPercentageFunc percentage_func)
+{
+    if (!session) return;
+    session->save (percentage_func, true);
+}
+
 void
 qof_session_safe_save(QofSession *session, QofPercentageFunc percentage_func)
 {
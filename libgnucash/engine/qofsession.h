@@ -236,6 +236,15 @@ QofBackend * qof_session_get_backend(const QofSession *session);
 void     qof_session_save (QofSession *session,
                            QofPercentageFunc percentage_func);
 
+/**
+ * The qof_session_autosave() method saves like qof_session_save(), for
+ * saves started by a timer rather than by the user.  The backend may
+ * favour speed; the XML backend compresses the file at the auto-save
+ * compression level.
+ */
+void     qof_session_autosave (QofSession *session,
+                               QofPercentageFunc percentage_func);
+
 /**
  * A special version of save used in the sql backend which moves the
  * existing tables aside, then saves everything to new tables, then
@@ -47,7 +47,9 @@ struct QofSessionImpl
     void swap_books (QofSessionImpl &) noexcept;
     void ensure_all_data_loaded () noexcept;
     void load (QofPercentageFunc) noexcept;
-    void save (QofPercentageFunc) noexcept;
+    /** Save the book; autosave says whether a timer rather than the
+     * user asked for it. */
+    void save (QofPercentageFunc, bool autosave = false) noexcept;
     void safe_save (QofPercentageFunc) noexcept;
     bool save_in_progress () const noexcept;
     bool export_session (QofSessionImpl & real_session, QofPercentageFunc) noexcept;
@@ -0,0 +1,644 @@
+/********************************************************************
+ * bench-engine.cpp: Micro-benchmarks of core engine operations.    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/**
+ * @file bench-engine.cpp
+ * @brief Time the engine's hot paths on random books of a given size.
+ *
+ * Usage: bench-engine [SPLITS...]
+ *
+ * For each book size (by default 10000, 100000 and 1000000 splits) a
+ * random book is built with the test-engine-stuff generators and each
+ * operation is timed on it.  Every result is printed to stdout as one
+ * JSON object per line, e.g.
+ *
+ *   {"benchmark": "xaccAccountRecomputeBalance", "splits": 10000,
+ *    "ops": 10000, "seconds": 0.004211, "ns_per_op": 421.1}
+ *
+ * so that runs from different commits can be compared with a script.
+ * The random seed is fixed, so a given size always gets the same book.
+ */
+
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include "qof.h"
+#include "Account.h"
+#include "Query.h"
+#include "Split.h"
+#include "Transaction.h"
+#include "TransLog.h"
+#include "gnc-pricedb.h"
+#include "cashobjects.h"
+#include "test-stuff.h"
+#include "test-engine-stuff.h"
+}
+
+#include "qof-guid-map.hpp"
+#include "qofinstance-p.h"
+
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const guint default_sizes[] = {10000, 100000, 1000000};
+static const guint num_lookups = 10000;
+static const guint num_query_runs = 10;
+static const guint num_commits = 1000;
+
+static void
+report (const char *name, guint splits, guint ops, Clock::duration elapsed)
+{
+    double seconds = std::chrono::duration<double> (elapsed).count ();
+
+    printf ("{\"benchmark\": \"%s\", \"splits\": %u, \"ops\": %u, "
+            "\"seconds\": %.6f, \"ns_per_op\": %.1f}\n",
+            name, splits, ops, seconds, ops ? seconds * 1e9 / ops : 0.0);
+    fflush (stdout);
+}
+
+template <typename T> static T
+random_element (const std::vector<T>& vec)
+{
+    return vec[get_random_int_in_range (0, vec.size () - 1)];
+}
+
+struct BenchBook
+{
+    QofBook *book;
+    guint num_splits;
+    std::vector<Account*> accounts;
+    std::vector<Transaction*> transactions;
+    std::vector<GNCPrice*> prices;
+};
+
+static void
+begin_account_edit (Account *acc, gpointer data)
+{
+    xaccAccountBeginEdit (acc);
+}
+
+static void
+commit_account_edit (Account *acc, gpointer data)
+{
+    static_cast<BenchBook*>(data)->accounts.push_back (acc);
+    xaccAccountCommitEdit (acc);
+}
+
+static void
+collect_transaction (QofInstance *inst, gpointer data)
+{
+    static_cast<BenchBook*>(data)->transactions.push_back (GNC_TRANSACTION (inst));
+}
+
+static gboolean
+collect_price (GNCPrice *price, gpointer data)
+{
+    static_cast<BenchBook*>(data)->prices.push_back (price);
+    return TRUE;
+}
+
+/* A random book with at least num_splits splits and one price for
+ * every hundred of them.  The accounts are held open for editing while
+ * the transactions go in, as they are during a load, so the balances
+ * are computed once at the end. */
+static void
+make_book (BenchBook *bench, guint num_splits)
+{
+    QofCollection *splits;
+    GNCPriceDB *pricedb;
+    Account *root;
+
+    bench->book = get_random_book ();
+    root = gnc_book_get_root_account (bench->book);
+    splits = qof_book_get_collection (bench->book, GNC_ID_SPLIT);
+    pricedb = gnc_pricedb_get_db (bench->book);
+
+    /* Random transactions need at least two accounts to go between. */
+    while (gnc_account_n_descendants (root) < 2)
+        get_random_account_tree (bench->book);
+
+    qof_event_suspend ();
+    gnc_account_foreach_descendant (root, begin_account_edit, NULL);
+    while (qof_collection_count (splits) < num_splits)
+        add_random_transactions_to_book (bench->book, 100);
+    for (guint i = 0; i < num_splits / 100; ++i)
+    {
+        GNCPrice *price = get_random_price (bench->book);
+        gnc_pricedb_add_price (pricedb, price);
+        gnc_price_unref (price);
+    }
+    gnc_account_foreach_descendant (root, commit_account_edit, bench);
+    qof_event_resume ();
+
+    bench->num_splits = qof_collection_count (splits);
+    qof_collection_foreach (qof_book_get_collection (bench->book,
+                                                     GNC_ID_TRANS),
+                            collect_transaction, bench);
+    gnc_pricedb_foreach_price (pricedb, collect_price, bench, FALSE);
+    fprintf (stderr, "Book with %u splits in %zu accounts, %zu prices\n",
+             bench->num_splits, bench->accounts.size (),
+             bench->prices.size ());
+}
+
+static void
+collect_split_guid (QofInstance *inst, gpointer data)
+{
+    static_cast<std::vector<const GncGUID*>*>(data)->push_back (qof_instance_get_guid (inst));
+}
+
+/* GHashTable sizes are powers of two kept at least a quarter full,
+ * with a hash, a key and a value for each. */
+static size_t
+ghash_memory_usage (guint count)
+{
+    size_t size = 8;
+    while (size * 3 / 4 < count)
+        size *= 2;
+    return size * (sizeof (guint) + 2 * sizeof (gpointer));
+}
+
+/* Look splits up by GncGUID in a GHashTable keyed by GncGUID pointers,
+ * as QofCollection used to, and in the QofGuidMap it uses now. */
+static void
+bench_guid_lookup (BenchBook *bench)
+{
+    std::vector<const GncGUID*> guids, lookups;
+    GHashTable *table = guid_hash_table_new ();
+    QofGuidMap map;
+
+    qof_collection_foreach (qof_book_get_collection (bench->book, GNC_ID_SPLIT),
+                            collect_split_guid, &guids);
+    for (auto guid : guids)
+    {
+        g_hash_table_insert (table, (gpointer)guid, (gpointer)guid);
+        map.insert (*guid, (QofInstance*)guid);
+    }
+    for (guint i = 0; i < num_lookups * 10; ++i)
+        lookups.push_back (random_element (guids));
+
+    auto start = Clock::now ();
+    for (auto guid : lookups)
+        g_hash_table_lookup (table, guid);
+    report ("g_hash_table_lookup (GncGUID)", bench->num_splits,
+            lookups.size (), Clock::now () - start);
+
+    start = Clock::now ();
+    for (auto guid : lookups)
+        map.lookup (*guid);
+    report ("QofGuidMap::lookup", bench->num_splits, lookups.size (),
+            Clock::now () - start);
+
+    fprintf (stderr, "GncGUID tables of %zu splits: GHashTable about %zu "
+             "bytes, QofGuidMap %zu bytes\n", guids.size (),
+             ghash_memory_usage (guids.size ()), map.memory_usage ());
+    g_hash_table_destroy (table);
+}
+
+/* Give every split an online id and an import-map style nested slot,
+ * as a book with downloaded transactions has, and look them up. */
+static void
+bench_kvp_get_slot (BenchBook *bench)
+{
+    std::vector<KvpFrame*> frames;
+    Path online_id {"online_id"};
+    Path nested {"import-map-bayes", "memo", "Expenses"};
+    guint i = 0;
+
+    for (auto trans : bench->transactions)
+        for (auto node = xaccTransGetSplitList (trans); node; node = node->next)
+        {
+            auto frame = qof_instance_get_slots (QOF_INSTANCE (node->data));
+            delete frame->set (online_id,
+                               new KvpValue {g_strdup_printf ("%u", i++)});
+            delete frame->set_path (nested, new KvpValue {int64_t {1}});
+            frames.push_back (frame);
+        }
+
+    auto start = Clock::now ();
+    for (auto frame : frames)
+    {
+        frame->get_slot (online_id);
+        frame->get_slot (nested);
+    }
+    report ("KvpFrame::get_slot", bench->num_splits, frames.size () * 2,
+            Clock::now () - start);
+
+    for (auto frame : frames)
+    {
+        delete frame->set (online_id, nullptr);
+        delete frame->set ({nested[0]}, nullptr);
+    }
+}
+
+static const guint num_cache_strings = 100000;
+
+/* Intern and release strings of which each is used about ten times,
+ * as memos and slot keys are, one at a time and in bulk. */
+static void
+string_cache_work (const std::vector<const char*>& keys, bool bulk)
+{
+    std::vector<char*> cached (keys.size ());
+
+    if (bulk)
+        qof_string_cache_insert_many (const_cast<const char**>(keys.data ()),
+                                      cached.data (), keys.size ());
+    else
+        for (size_t i = 0; i < keys.size (); ++i)
+            cached[i] = qof_string_cache_insert (keys[i]);
+    for (auto str : cached)
+        qof_string_cache_remove (str);
+}
+
+struct StringCacheJob
+{
+    const std::vector<const char*> *keys;
+    bool bulk;
+};
+
+static gpointer
+string_cache_thread (gpointer data)
+{
+    auto job = static_cast<StringCacheJob*>(data);
+    string_cache_work (*job->keys, job->bulk);
+    return NULL;
+}
+
+static void
+bench_string_cache (BenchBook *bench)
+{
+    std::vector<std::string> strings;
+    std::vector<const char*> keys;
+    guint num_threads = g_get_num_processors ();
+
+    for (guint i = 0; i < num_cache_strings; ++i)
+        strings.push_back ("string-" + std::to_string (
+                               get_random_int_in_range (0, num_cache_strings / 10)));
+    for (auto& str : strings)
+        keys.push_back (str.c_str ());
+
+    for (auto bulk : {false, true})
+    {
+        auto start = Clock::now ();
+        string_cache_work (keys, bulk);
+        report (bulk ? "qof_string_cache_insert_many" : "qof_string_cache_insert",
+                bench->num_splits, keys.size (), Clock::now () - start);
+
+        StringCacheJob job {&keys, bulk};
+        std::vector<GThread*> threads;
+        start = Clock::now ();
+        for (guint i = 0; i < num_threads; ++i)
+            threads.push_back (g_thread_new ("bench", string_cache_thread, &job));
+        for (auto thread : threads)
+            g_thread_join (thread);
+        report (bulk ? "qof_string_cache_insert_many (all threads)" :
+                "qof_string_cache_insert (all threads)", bench->num_splits,
+                keys.size () * num_threads, Clock::now () - start);
+    }
+}
+
+static void
+bench_recompute_balance (BenchBook *bench)
+{
+    auto start = Clock::now ();
+    for (auto acc : bench->accounts)
+    {
+        gnc_account_set_balance_dirty (acc);
+        xaccAccountRecomputeBalance (acc);
+    }
+    report ("xaccAccountRecomputeBalance", bench->num_splits,
+            bench->num_splits, Clock::now () - start);
+}
+
+static void
+bench_balance_as_of_date (BenchBook *bench)
+{
+    std::vector<std::pair<Account*, time64>> queries;
+
+    for (guint i = 0; i < num_lookups; ++i)
+        queries.emplace_back (random_element (bench->accounts),
+                              get_random_time ());
+
+    auto start = Clock::now ();
+    for (auto& query : queries)
+        xaccAccountGetBalanceAsOfDate (query.first, query.second);
+    report ("xaccAccountGetBalanceAsOfDate", bench->num_splits, num_lookups,
+            Clock::now () - start);
+}
+
+static void
+bench_pricedb_lookup (BenchBook *bench)
+{
+    GNCPriceDB *pricedb = gnc_pricedb_get_db (bench->book);
+    std::vector<std::pair<GNCPrice*, time64>> queries;
+
+    if (bench->prices.empty ())
+        return;
+    for (guint i = 0; i < num_lookups; ++i)
+        queries.emplace_back (random_element (bench->prices),
+                              get_random_time ());
+
+    auto start = Clock::now ();
+    for (auto& query : queries)
+    {
+        auto price = gnc_pricedb_lookup_nearest_in_time64 (pricedb,
+                         gnc_price_get_commodity (query.first),
+                         gnc_price_get_currency (query.first), query.second);
+        gnc_price_unref (price);
+    }
+    report ("gnc_pricedb_lookup_nearest_in_time64", bench->num_splits,
+            num_lookups, Clock::now () - start);
+}
+
+static void
+bench_query_run (BenchBook *bench)
+{
+    QofQuery *query = qof_query_create_for (GNC_ID_SPLIT);
+    time64 t1 = get_random_time (), t2 = get_random_time ();
+
+    qof_query_set_book (query, bench->book);
+    xaccQueryAddDateMatchTT (query, TRUE, MIN (t1, t2), TRUE, MAX (t1, t2),
+                             QOF_QUERY_AND);
+
+    auto start = Clock::now ();
+    for (guint i = 0; i < num_query_runs; ++i)
+        qof_query_run (query);
+    report ("qof_query_run", bench->num_splits, num_query_runs,
+            Clock::now () - start);
+    qof_query_destroy (query);
+}
+
+/* A register's query: one account's splits in a date range, run by
+ * scanning and then through the secondary indexes. */
+static void
+bench_account_query (BenchBook *bench)
+{
+    QofQuery *query = qof_query_create_for (GNC_ID_SPLIT);
+    time64 t1 = get_random_time (), t2 = get_random_time ();
+
+    qof_query_set_book (query, bench->book);
+    xaccQueryAddSingleAccountMatch (query, random_element (bench->accounts),
+                                    QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (query, TRUE, MIN (t1, t2), TRUE, MAX (t1, t2),
+                             QOF_QUERY_AND);
+
+    auto start = Clock::now ();
+    for (guint i = 0; i < num_query_runs; ++i)
+        qof_query_run (query);
+    report ("qof_query_run (account)", bench->num_splits, num_query_runs,
+            Clock::now () - start);
+
+    qof_query_enable_indexes (bench->book, TRUE);
+    start = Clock::now ();
+    qof_query_run (query);
+    report ("qof_query_run (building indexes)", bench->num_splits, 1,
+            Clock::now () - start);
+    start = Clock::now ();
+    for (guint i = 0; i < num_query_runs; ++i)
+        qof_query_run (query);
+    report ("qof_query_run (account, indexed)", bench->num_splits,
+            num_query_runs, Clock::now () - start);
+    qof_query_enable_indexes (bench->book, FALSE);
+    qof_query_destroy (query);
+}
+
+static void
+bench_trans_commit (BenchBook *bench)
+{
+    std::vector<std::pair<Transaction*, time64>> edits;
+
+    for (guint i = 0; i < num_commits; ++i)
+        edits.emplace_back (random_element (bench->transactions),
+                            get_random_time ());
+
+    for (auto bulk : {false, true})
+    {
+        auto start = Clock::now ();
+        if (bulk)
+            gnc_book_begin_bulk_edit (bench->book);
+        for (auto& edit : edits)
+        {
+            xaccTransBeginEdit (edit.first);
+            xaccTransSetDatePostedSecs (edit.first, edit.second);
+            xaccTransCommitEdit (edit.first);
+        }
+        if (bulk)
+            gnc_book_commit_bulk_edit (bench->book);
+        report (bulk ? "xaccTransCommitEdit (bulk edit)" :
+                "xaccTransCommitEdit", bench->num_splits, num_commits,
+                Clock::now () - start);
+    }
+}
+
+/* The same commits logged to a scratch directory in each durability
+ * mode, including the time to get the last record out. */
+static void
+bench_translog (BenchBook *bench)
+{
+    static const std::pair<XaccLogDurability, const char*> modes[] =
+    {
+        {XACC_LOG_SYNC, "xaccTransWriteLog (sync)"},
+        {XACC_LOG_ASYNC, "xaccTransWriteLog (async)"},
+        {XACC_LOG_ASYNC_FSYNC, "xaccTransWriteLog (async, fsync)"},
+    };
+    std::vector<Transaction*> transactions;
+    auto dir = g_dir_make_tmp ("bench-translog-XXXXXX", NULL);
+    auto base = g_build_filename (dir, "translog", NULL);
+
+    for (guint i = 0; i < num_commits; ++i)
+        transactions.push_back (random_element (bench->transactions));
+
+    xaccCloseLog ();
+    xaccLogSetBaseName (base);
+    for (auto& mode : modes)
+    {
+        xaccLogSetDurability (mode.first);
+        xaccOpenLog ();
+        auto start = Clock::now ();
+        for (auto trans : transactions)
+            xaccTransWriteLog (trans, 'C');
+        xaccLogFlush ();
+        report (mode.second, bench->num_splits, num_commits,
+                Clock::now () - start);
+        xaccCloseLog ();
+    }
+    xaccLogSetDurability (XACC_LOG_SYNC);
+    xaccLogSetBaseName ("translog");
+
+    auto gdir = g_dir_open (dir, 0, NULL);
+    while (auto name = g_dir_read_name (gdir))
+    {
+        auto path = g_build_filename (dir, name, NULL);
+        g_remove (path);
+        g_free (path);
+    }
+    g_dir_close (gdir);
+    g_rmdir (dir);
+    g_free (base);
+    g_free (dir);
+}
+
+static void
+count_batch_entries (const QofEventBatchEntry *entries, guint n_entries,
+                     gpointer data)
+{
+    *static_cast<guint64*>(data) += n_entries;
+}
+
+/* The same commits with a batch handler registered, first delivering
+ * each event as it happens and then all of them in one batch. */
+static void
+bench_event_batch (BenchBook *bench)
+{
+    std::vector<std::pair<Transaction*, time64>> edits;
+    guint64 entries = 0, generated, delivered;
+    gint handler_id;
+
+    for (guint i = 0; i < num_commits; ++i)
+        edits.emplace_back (random_element (bench->transactions),
+                            get_random_time ());
+
+    handler_id = qof_event_register_batch_handler (count_batch_entries,
+                                                   &entries);
+    for (auto batched : {false, true})
+    {
+        entries = 0;
+        qof_event_reset_counts ();
+        auto start = Clock::now ();
+        if (batched)
+            qof_event_begin_batch ();
+        for (auto& edit : edits)
+        {
+            xaccTransBeginEdit (edit.first);
+            xaccTransSetDatePostedSecs (edit.first, edit.second);
+            xaccTransCommitEdit (edit.first);
+        }
+        if (batched)
+            qof_event_end_batch ();
+        report (batched ? "xaccTransCommitEdit (batched events)" :
+                "xaccTransCommitEdit (event per call)", bench->num_splits,
+                num_commits, Clock::now () - start);
+        qof_event_get_counts (&generated, &delivered);
+        fprintf (stderr, "%" G_GUINT64_FORMAT " events generated, %"
+                 G_GUINT64_FORMAT " handler calls, %" G_GUINT64_FORMAT
+                 " batch entries\n", generated, delivered, entries);
+    }
+    qof_event_unregister_handler (handler_id);
+}
+
+/* Add up each account's split amounts, as the balance computations
+ * do: pairwise and then with gnc_numeric_sum. */
+static void
+bench_numeric (BenchBook *bench)
+{
+    std::vector<std::vector<gnc_numeric>> amounts;
+
+    for (auto acc : bench->accounts)
+    {
+        std::vector<gnc_numeric> acc_amounts;
+        for (auto node = xaccAccountGetSplitList (acc); node; node = node->next)
+            acc_amounts.push_back (xaccSplitGetAmount (static_cast<Split*>(node->data)));
+        amounts.push_back (std::move (acc_amounts));
+    }
+
+    auto start = Clock::now ();
+    for (auto& acc_amounts : amounts)
+    {
+        gnc_numeric total = gnc_numeric_zero ();
+        for (auto& amount : acc_amounts)
+            total = gnc_numeric_add_fixed (total, amount);
+    }
+    report ("gnc_numeric_add_fixed", bench->num_splits, bench->num_splits,
+            Clock::now () - start);
+
+    start = Clock::now ();
+    for (auto& acc_amounts : amounts)
+        gnc_numeric_sum (acc_amounts.data (), acc_amounts.size (),
+                         GNC_DENOM_AUTO,
+                         GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    report ("gnc_numeric_sum", bench->num_splits, bench->num_splits,
+            Clock::now () - start);
+}
+
+static void
+run_benchmarks (guint num_splits)
+{
+    BenchBook bench {};
+
+    srand (0);
+    make_book (&bench, num_splits);
+
+    bench_guid_lookup (&bench);
+    bench_kvp_get_slot (&bench);
+    bench_string_cache (&bench);
+    bench_recompute_balance (&bench);
+    bench_balance_as_of_date (&bench);
+    bench_pricedb_lookup (&bench);
+    bench_query_run (&bench);
+    bench_account_query (&bench);
+    bench_trans_commit (&bench);
+    bench_translog (&bench);
+    bench_event_batch (&bench);
+    bench_numeric (&bench);
+
+    qof_book_destroy (bench.book);
+}
+
+int
+main (int argc, char **argv)
+{
+    std::vector<guint> sizes;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        guint64 size = g_ascii_strtoull (argv[i], NULL, 10);
+        if (size == 0 || size > G_MAXUINT)
+        {
+            fprintf (stderr, "Usage: %s [SPLITS...]\n", argv[0]);
+            return 1;
+        }
+        sizes.push_back (size);
+    }
+    if (sizes.empty ())
+        sizes.assign (std::begin (default_sizes), std::end (default_sizes));
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+
+    /* Keep the generated books small in everything but splits. */
+    set_max_kvp_depth (1);
+    set_max_kvp_frame_elements (1);
+    set_max_account_tree_depth (3);
+    set_max_accounts_per_level (4);
+
+    for (auto size : sizes)
+        run_benchmarks (size);
+
+    qof_close ();
+    return 0;
+}
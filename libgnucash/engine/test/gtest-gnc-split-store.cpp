@@ -0,0 +1,170 @@
+/********************************************************************
+ * gtest-gnc-split-store.cpp: Test the columnar split store.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include "../Account.h"
+#include "../Split.h"
+#include "../Transaction.h"
+#include "../gnc-commodity.h"
+#include "../gnc-split-store.h"
+#include <qof.h>
+}
+
+#include <gtest/gtest.h>
+
+static const time64 day = 24 * 3600;
+static const time64 jan1 = 1483228800; /* 2017-01-01 00:00 UTC */
+
+class SplitStoreTest : public testing::Test
+{
+protected:
+    void SetUp() {
+        t_book = qof_book_new();
+        Account *root = gnc_account_create_root(t_book);
+        t_usd = gnc_commodity_new(t_book, "US Dollar", "CURRENCY", "USD",
+                                  "0", 100);
+
+        t_bank = xaccMallocAccount(t_book);
+        xaccAccountSetName(t_bank, "Bank");
+        xaccAccountSetCommodity(t_bank, t_usd);
+        gnc_account_append_child(root, t_bank);
+
+        t_expense = xaccMallocAccount(t_book);
+        xaccAccountSetName(t_expense, "Expense");
+        xaccAccountSetCommodity(t_expense, t_usd);
+        gnc_account_append_child(root, t_expense);
+    }
+    void TearDown() {
+        auto root = gnc_book_get_root_account (t_book);
+        xaccAccountBeginEdit (root);
+        xaccAccountDestroy (root);
+        qof_book_destroy (t_book);
+    }
+    /* Pay amount/100 from the bank into the expense account. */
+    Transaction *pay(time64 date, gint64 amount, char reconciled = NREC) {
+        auto trans = xaccMallocTransaction(t_book);
+        xaccTransBeginEdit(trans);
+        xaccTransSetCurrency(trans, t_usd);
+        xaccTransSetDatePostedSecs(trans, date);
+        add_split(trans, t_bank, -amount, reconciled);
+        add_split(trans, t_expense, amount, NREC);
+        xaccTransCommitEdit(trans);
+        return trans;
+    }
+    void add_split(Transaction *trans, Account *acc, gint64 amount,
+                   char reconciled) {
+        auto split = xaccMallocSplit(t_book);
+        auto value = gnc_numeric_create(amount, 100);
+        xaccSplitSetParent(split, trans);
+        xaccSplitSetAccount(split, acc);
+        xaccSplitSetAmount(split, value);
+        xaccSplitSetValue(split, value);
+        xaccSplitSetReconcile(split, reconciled);
+    }
+    QofBook *t_book {};
+    gnc_commodity *t_usd {};
+    Account *t_bank {};
+    Account *t_expense {};
+};
+
+TEST_F(SplitStoreTest, LoadsExistingSplits)
+{
+    pay(jan1, 1000);
+    pay(jan1 + day, 2550);
+    auto store = gnc_split_store_new(t_book);
+    EXPECT_EQ(4u, gnc_split_store_get_size(store));
+    auto sum = gnc_split_store_sum(store, t_expense, jan1, jan1 + day, NULL);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(3550, 100), sum));
+    EXPECT_EQ(100, sum.denom);
+    sum = gnc_split_store_sum(store, NULL, jan1, jan1 + day, NULL);
+    EXPECT_TRUE(gnc_numeric_zero_p(sum));
+    gnc_split_store_destroy(store);
+}
+
+TEST_F(SplitStoreTest, FiltersDatesAndStates)
+{
+    auto store = gnc_split_store_new(t_book);
+    pay(jan1, 1000, CREC);
+    pay(jan1 + day, 2000, YREC);
+    pay(jan1 + 2 * day, 4000);
+    EXPECT_EQ(6u, gnc_split_store_get_size(store));
+
+    auto sum = gnc_split_store_sum(store, t_bank, jan1 + day,
+                                   jan1 + 2 * day, NULL);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(-6000, 100), sum));
+    sum = gnc_split_store_sum(store, t_bank, jan1, jan1 + 2 * day, "cy");
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(-3000, 100), sum));
+    sum = gnc_split_store_sum(store, t_bank, jan1 + 3 * day,
+                              jan1 + 4 * day, NULL);
+    EXPECT_TRUE(gnc_numeric_zero_p(sum));
+
+    auto sums = gnc_split_store_sum_by_account(store, jan1, jan1 + day,
+                                               NULL);
+    EXPECT_EQ(2u, g_hash_table_size(sums));
+    auto bank = static_cast<gnc_numeric*>(g_hash_table_lookup(sums, t_bank));
+    auto expense = static_cast<gnc_numeric*>(g_hash_table_lookup(sums,
+                                                                 t_expense));
+    ASSERT_NE(nullptr, bank);
+    ASSERT_NE(nullptr, expense);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(-3000, 100), *bank));
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(3000, 100), *expense));
+    g_hash_table_destroy(sums);
+    gnc_split_store_destroy(store);
+}
+
+TEST_F(SplitStoreTest, FollowsEdits)
+{
+    auto store = gnc_split_store_new(t_book);
+    auto first = pay(jan1, 1000);
+    auto second = pay(jan1 + day, 2000);
+
+    xaccTransBeginEdit(second);
+    xaccTransSetDatePostedSecs(second, jan1 + 10 * day);
+    xaccTransCommitEdit(second);
+    auto sum = gnc_split_store_sum(store, t_expense, jan1, jan1 + day, NULL);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(1000, 100), sum));
+
+    auto split = xaccTransFindSplitByAccount(first, t_expense);
+    xaccTransBeginEdit(first);
+    xaccSplitSetAmount(split, gnc_numeric_create(1500, 1000));
+    xaccSplitSetValue(split, gnc_numeric_create(1500, 1000));
+    xaccTransCommitEdit(first);
+    sum = gnc_split_store_sum(store, t_expense, jan1, jan1 + 10 * day, NULL);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(2150, 100), sum));
+    /* The per-account sums cope with the mixed denominators too. */
+    auto sums = gnc_split_store_sum_by_account(store, jan1, jan1 + 10 * day,
+                                               NULL);
+    auto expense = static_cast<gnc_numeric*>(g_hash_table_lookup(sums,
+                                                                 t_expense));
+    ASSERT_NE(nullptr, expense);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(2150, 100), *expense));
+    g_hash_table_destroy(sums);
+
+    xaccTransBeginEdit(first);
+    xaccTransDestroy(first);
+    xaccTransCommitEdit(first);
+    EXPECT_EQ(2u, gnc_split_store_get_size(store));
+    sum = gnc_split_store_sum(store, t_expense, jan1, jan1 + 10 * day, NULL);
+    EXPECT_TRUE(gnc_numeric_equal(gnc_numeric_create(2000, 100), sum));
+    gnc_split_store_destroy(store);
+}
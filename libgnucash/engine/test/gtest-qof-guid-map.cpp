@@ -0,0 +1,117 @@
+/********************************************************************
+ * gtest-qof-guid-map.cpp: Test the GncGUID hash table.             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+}
+
+#include "../qof-guid-map.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <map>
+#include <random>
+
+static QofInstance *
+fake_instance (uintptr_t n)
+{
+    return reinterpret_cast<QofInstance*>(n);
+}
+
+struct GuidLess
+{
+    bool operator() (const GncGUID& a, const GncGUID& b) const
+    {
+        return memcmp (a.reserved, b.reserved, GUID_DATA_SIZE) < 0;
+    }
+};
+
+TEST(QofGuidMap, empty)
+{
+    QofGuidMap map;
+    GncGUID guid = *guid_null ();
+
+    EXPECT_EQ (0u, map.size ());
+    EXPECT_EQ (nullptr, map.lookup (guid));
+    EXPECT_FALSE (map.remove (guid));
+}
+
+TEST(QofGuidMap, insert_replace_remove)
+{
+    QofGuidMap map;
+    GncGUID guid;
+
+    guid_replace (&guid);
+    map.insert (guid, fake_instance (8));
+    EXPECT_EQ (1u, map.size ());
+    EXPECT_EQ (fake_instance (8), map.lookup (guid));
+
+    map.insert (guid, fake_instance (16));
+    EXPECT_EQ (1u, map.size ());
+    EXPECT_EQ (fake_instance (16), map.lookup (guid));
+
+    EXPECT_TRUE (map.remove (guid));
+    EXPECT_EQ (0u, map.size ());
+    EXPECT_EQ (nullptr, map.lookup (guid));
+    EXPECT_FALSE (map.remove (guid));
+}
+
+/* Random inserts, removals and lookups, checked against a std::map.
+ * The keys differ only in a few bytes and are often reused, so that
+ * groups fill up and deleted slots are both reused and rehashed away. */
+TEST(QofGuidMap, random_operations)
+{
+    QofGuidMap map;
+    std::map<GncGUID, QofInstance*, GuidLess> expected;
+    std::mt19937 rng (42);
+
+    for (uintptr_t i = 1; i <= 200000; ++i)
+    {
+        GncGUID guid = *guid_null ();
+        auto key = rng () % 20000;
+        memcpy (guid.reserved, &key, sizeof key);
+
+        switch (rng () % 3)
+        {
+        case 0:
+            map.insert (guid, fake_instance (i));
+            expected[guid] = fake_instance (i);
+            break;
+        case 1:
+            EXPECT_EQ (expected.erase (guid) == 1, map.remove (guid));
+            break;
+        default:
+        {
+            auto iter = expected.find (guid);
+            EXPECT_EQ (iter == expected.end () ? nullptr : iter->second,
+                       map.lookup (guid));
+        }
+        }
+        ASSERT_EQ (expected.size (), map.size ());
+    }
+
+    size_t count = 0;
+    map.foreach ([&count] (QofInstance*) { ++count; });
+    EXPECT_EQ (expected.size (), count);
+    for (auto& entry : expected)
+        EXPECT_EQ (entry.second, map.lookup (entry.first));
+}
@@ -0,0 +1,149 @@
+/********************************************************************
+ * gtest-qofevent.cpp: Test the delivery of batches of QOF events.  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <qof.h>
+}
+
+#include <gtest/gtest.h>
+#include <vector>
+
+static const char *test_type = "test type";
+
+class QofEventTest : public testing::Test
+{
+protected:
+    QofEventTest () : m_book {qof_book_new ()}
+    {
+        for (auto& inst : m_insts)
+        {
+            inst = static_cast<QofInstance*>(g_object_new (QOF_TYPE_INSTANCE,
+                                                           NULL));
+            qof_instance_init_data (inst, test_type, m_book);
+        }
+        m_handler_id = qof_event_register_handler (count_event, this);
+        m_batch_handler_id = qof_event_register_batch_handler (collect_batch,
+                                                               this);
+        qof_event_reset_counts ();
+    }
+    ~QofEventTest ()
+    {
+        qof_event_unregister_handler (m_handler_id);
+        qof_event_unregister_handler (m_batch_handler_id);
+        for (auto inst : m_insts)
+            g_object_unref (inst);
+        qof_book_destroy (m_book);
+    }
+
+    static void count_event (QofInstance *ent, QofEventId event_type,
+                             gpointer handler_data, gpointer event_data)
+    {
+        static_cast<QofEventTest*>(handler_data)->m_events++;
+    }
+    static void collect_batch (const QofEventBatchEntry *entries,
+                               guint n_entries, gpointer handler_data)
+    {
+        auto test = static_cast<QofEventTest*>(handler_data);
+        test->m_batches.emplace_back (entries, entries + n_entries);
+    }
+
+    QofBook *m_book;
+    QofInstance *m_insts[3];
+    gint m_handler_id;
+    gint m_batch_handler_id;
+    guint m_events = 0;
+    std::vector<std::vector<QofEventBatchEntry>> m_batches;
+};
+
+TEST_F(QofEventTest, unbatched)
+{
+    guint64 generated, delivered;
+
+    qof_event_gen (m_insts[0], QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (m_insts[0], QOF_EVENT_MODIFY, NULL);
+
+    EXPECT_EQ (2u, m_events);
+    ASSERT_EQ (2u, m_batches.size ());
+    ASSERT_EQ (1u, m_batches[0].size ());
+    EXPECT_EQ (m_insts[0], m_batches[0][0].entity);
+    EXPECT_TRUE (guid_equal (qof_instance_get_guid (m_insts[0]),
+                             &m_batches[0][0].guid));
+    EXPECT_STREQ (test_type, m_batches[0][0].e_type);
+    EXPECT_EQ (QOF_EVENT_MODIFY, m_batches[0][0].event_mask);
+
+    qof_event_get_counts (&generated, &delivered);
+    EXPECT_EQ (2u, generated);
+    EXPECT_EQ (4u, delivered);
+}
+
+TEST_F(QofEventTest, batched)
+{
+    guint64 generated, delivered;
+
+    qof_event_begin_batch ();
+    qof_event_gen (m_insts[1], QOF_EVENT_CREATE, NULL);
+    qof_event_begin_batch ();
+    qof_event_gen (m_insts[0], QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (m_insts[1], QOF_EVENT_MODIFY, NULL);
+    qof_event_end_batch ();
+    qof_event_gen (m_insts[0], QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (m_insts[2], QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (m_insts[2], QOF_EVENT_DESTROY, NULL);
+    EXPECT_TRUE (m_batches.empty ());
+    qof_event_end_batch ();
+
+    EXPECT_EQ (6u, m_events);
+    ASSERT_EQ (1u, m_batches.size ());
+    auto& batch = m_batches[0];
+    ASSERT_EQ (3u, batch.size ());
+    EXPECT_EQ (m_insts[1], batch[0].entity);
+    EXPECT_EQ (QOF_EVENT_CREATE | QOF_EVENT_MODIFY, batch[0].event_mask);
+    EXPECT_EQ (m_insts[0], batch[1].entity);
+    EXPECT_EQ (QOF_EVENT_MODIFY, batch[1].event_mask);
+    EXPECT_EQ (nullptr, batch[2].entity);
+    EXPECT_TRUE (guid_equal (qof_instance_get_guid (m_insts[2]),
+                             &batch[2].guid));
+    EXPECT_EQ (QOF_EVENT_MODIFY | QOF_EVENT_DESTROY, batch[2].event_mask);
+
+    qof_event_get_counts (&generated, &delivered);
+    EXPECT_EQ (6u, generated);
+    EXPECT_EQ (7u, delivered);
+}
+
+TEST_F(QofEventTest, suspended)
+{
+    guint64 generated, delivered;
+
+    qof_event_begin_batch ();
+    qof_event_suspend ();
+    qof_event_gen (m_insts[0], QOF_EVENT_MODIFY, NULL);
+    qof_event_resume ();
+    qof_event_end_batch ();
+
+    EXPECT_EQ (0u, m_events);
+    EXPECT_TRUE (m_batches.empty ());
+    qof_event_get_counts (&generated, &delivered);
+    EXPECT_EQ (0u, generated);
+    EXPECT_EQ (0u, delivered);
+}
@@ -194,3 +194,80 @@ TEST(qof_query_core_predicate_get_date, numeric)
 
     EXPECT_FALSE (qof_query_date_predicate_get_date(pdata, &date));
 }
+
+struct compiled_test_obj
+{
+    gnc_numeric amount;
+    gint64 count;
+};
+
+static gnc_numeric
+compiled_test_amount (gpointer obj, QofParam *param)
+{
+    return static_cast<compiled_test_obj*>(obj)->amount;
+}
+
+static gint64
+compiled_test_count (gpointer obj, QofParam *param)
+{
+    return static_cast<compiled_test_obj*>(obj)->count;
+}
+
+static void
+expect_compiled_matches_generic (QofParam *param, QofQueryPredData *pdata,
+                                 compiled_test_obj *objs, size_t n_objs)
+{
+    GSList *fcns = g_slist_prepend (NULL, param);
+    QofQueryPredicateFunc pred =
+        qof_query_core_get_predicate (param->param_type);
+    QofQueryCompiledPred *compiled =
+        qof_query_core_compile_predicate (fcns, param->param_type, pdata);
+
+    ASSERT_NE (nullptr, compiled);
+    for (size_t i = 0; i < n_objs; i++)
+        EXPECT_EQ (pred (&objs[i], param, pdata) != 0,
+                   qof_query_compiled_predicate_match (compiled, &objs[i]) != 0);
+
+    qof_query_compiled_predicate_free (compiled);
+    qof_query_core_predicate_free (pdata);
+    g_slist_free (fcns);
+}
+
+TEST(qof_query_core_compile_predicate, numeric)
+{
+    qof_query_core_init();
+    QofParam param { "amount", QOF_TYPE_NUMERIC,
+                     (QofAccessFunc)compiled_test_amount, NULL, NULL };
+    compiled_test_obj objs[] = { {{ -500, 100 }, 0}, {{ 0, 1 }, 0},
+                                 {{ 500, 100 }, 0}, {{ 50001, 10000 }, 0},
+                                 {{ 1000, 100 }, 0} };
+    QofQueryCompare hows[] = { QOF_COMPARE_LT, QOF_COMPARE_LTE,
+                               QOF_COMPARE_EQUAL, QOF_COMPARE_GT,
+                               QOF_COMPARE_GTE, QOF_COMPARE_NEQ };
+    QofNumericMatch options[] = { QOF_NUMERIC_MATCH_ANY,
+                                  QOF_NUMERIC_MATCH_CREDIT,
+                                  QOF_NUMERIC_MATCH_DEBIT };
+
+    for (auto how : hows)
+        for (auto option : options)
+            expect_compiled_matches_generic (
+                &param, qof_query_numeric_predicate (how, option, { 500, 100 }),
+                objs, G_N_ELEMENTS (objs));
+}
+
+TEST(qof_query_core_compile_predicate, int64)
+{
+    qof_query_core_init();
+    QofParam param { "count", QOF_TYPE_INT64,
+                     (QofAccessFunc)compiled_test_count, NULL, NULL };
+    compiled_test_obj objs[] = { {{ 0, 1 }, -3}, {{ 0, 1 }, 0},
+                                 {{ 0, 1 }, 42}, {{ 0, 1 }, 100} };
+    QofQueryCompare hows[] = { QOF_COMPARE_LT, QOF_COMPARE_LTE,
+                               QOF_COMPARE_EQUAL, QOF_COMPARE_GT,
+                               QOF_COMPARE_GTE, QOF_COMPARE_NEQ };
+
+    for (auto how : hows)
+        expect_compiled_matches_generic (
+            &param, qof_query_int64_predicate (how, 42),
+            objs, G_N_ELEMENTS (objs));
+}
@@ -0,0 +1,223 @@
+/********************************************************************
+ * gtest-translog.cpp: Test the transaction log writer.             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include <glib/gstdio.h>
+#include "../Account.h"
+#include "../Split.h"
+#include "../Transaction.h"
+#include "../TransLog.h"
+#include "../gnc-commodity.h"
+#include <qof.h>
+}
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const time64 jan1 = 1483228800; /* 2017-01-01 00:00 UTC */
+
+class TransLogTest : public testing::Test
+{
+protected:
+    void SetUp() {
+        t_dir = g_dir_make_tmp("translog-XXXXXX", NULL);
+        ASSERT_NE(nullptr, t_dir);
+        open_log ("setup", XACC_LOG_ASYNC);
+        t_book = qof_book_new();
+        Account *root = gnc_account_create_root(t_book);
+        t_usd = gnc_commodity_new(t_book, "US Dollar", "CURRENCY", "USD",
+                                  "0", 100);
+
+        t_bank = xaccMallocAccount(t_book);
+        xaccAccountSetName(t_bank, "Bank");
+        xaccAccountSetCommodity(t_bank, t_usd);
+        gnc_account_append_child(root, t_bank);
+
+        t_expense = xaccMallocAccount(t_book);
+        xaccAccountSetName(t_expense, "Expense");
+        xaccAccountSetCommodity(t_expense, t_usd);
+        gnc_account_append_child(root, t_expense);
+    }
+    void TearDown() {
+        auto root = gnc_book_get_root_account (t_book);
+        xaccCloseLog ();
+        xaccLogSetDurability (XACC_LOG_SYNC);
+        xaccLogDisable ();
+        xaccAccountBeginEdit (root);
+        xaccAccountDestroy (root);
+        qof_book_destroy (t_book);
+        xaccLogEnable ();
+
+        auto dir = g_dir_open (t_dir, 0, NULL);
+        while (auto name = g_dir_read_name (dir))
+        {
+            auto path = g_build_filename (t_dir, name, NULL);
+            g_remove (path);
+            g_free (path);
+        }
+        g_dir_close (dir);
+        g_rmdir (t_dir);
+        g_free (t_dir);
+    }
+    /* Start a log named for base in the test directory. */
+    void open_log(const char *base, XaccLogDurability durability) {
+        auto path = g_build_filename (t_dir, base, NULL);
+        xaccCloseLog ();
+        xaccLogSetDurability (durability);
+        xaccLogSetBaseName (path);
+        xaccOpenLog ();
+        g_free (path);
+    }
+    /* The contents of the log named for base, without the time each
+     * record was written. */
+    std::string read_log(const char *base) {
+        std::string contents;
+        auto dir = g_dir_open (t_dir, 0, NULL);
+        while (auto name = g_dir_read_name (dir))
+        {
+            if (!g_str_has_prefix (name, base)) continue;
+            auto path = g_build_filename (t_dir, name, NULL);
+            gchar *text;
+            if (g_file_get_contents (path, &text, NULL, NULL))
+            {
+                contents = text;
+                g_free (text);
+            }
+            g_free (path);
+        }
+        g_dir_close (dir);
+
+        std::istringstream lines (contents);
+        std::string line, result;
+        while (std::getline (lines, line))
+        {
+            auto start = line.find ('\t');
+            for (int i = 0; i < 2 && start != std::string::npos; ++i)
+                start = line.find ('\t', start + 1);
+            if (start != std::string::npos)
+                line.erase (start, line.find ('\t', start + 1) - start);
+            result += line + '\n';
+        }
+        return result;
+    }
+    /* Pay amount/100 from the bank into the expense account. */
+    Transaction *pay(time64 date, gint64 amount) {
+        auto trans = xaccMallocTransaction(t_book);
+        xaccTransBeginEdit(trans);
+        xaccTransSetCurrency(trans, t_usd);
+        xaccTransSetDatePostedSecs(trans, date);
+        xaccTransSetDescription(trans, "Groceries");
+        add_split(trans, t_bank, -amount);
+        add_split(trans, t_expense, amount);
+        xaccTransCommitEdit(trans);
+        return trans;
+    }
+    void add_split(Transaction *trans, Account *acc, gint64 amount) {
+        auto split = xaccMallocSplit(t_book);
+        auto value = gnc_numeric_create(amount, 100);
+        xaccSplitSetParent(split, trans);
+        xaccSplitSetAccount(split, acc);
+        xaccSplitSetAmount(split, value);
+        xaccSplitSetValue(split, value);
+    }
+    gchar *t_dir {};
+    QofBook *t_book {};
+    gnc_commodity *t_usd {};
+    Account *t_bank {};
+    Account *t_expense {};
+};
+
+/* Nothing logged may be lost in a crash unless asked for. */
+TEST_F(TransLogTest, SyncIsTheDefault)
+{
+    EXPECT_EQ(XACC_LOG_SYNC, xaccLogGetDurability ());
+}
+
+TEST_F(TransLogTest, AsyncMatchesSync)
+{
+    std::vector<Transaction*> transactions;
+    for (int i = 0; i < 10; ++i)
+        transactions.push_back (pay (jan1 + i, 100 * i));
+
+    open_log ("sync", XACC_LOG_SYNC);
+    for (auto trans : transactions)
+    {
+        xaccTransWriteLog (trans, 'B');
+        xaccTransWriteLog (trans, 'C');
+    }
+    xaccCloseLog ();
+
+    open_log ("async", XACC_LOG_ASYNC);
+    for (auto trans : transactions)
+    {
+        xaccTransWriteLog (trans, 'B');
+        xaccTransWriteLog (trans, 'C');
+    }
+    xaccCloseLog ();
+
+    auto sync_log = read_log ("sync");
+    EXPECT_NE(std::string::npos, sync_log.find ("===== START\nB\t"));
+    EXPECT_NE(std::string::npos, sync_log.find ("\tGroceries\t"));
+    EXPECT_EQ(sync_log, read_log ("async"));
+}
+
+TEST_F(TransLogTest, FlushWritesEverythingQueued)
+{
+    open_log ("fsync", XACC_LOG_ASYNC_FSYNC);
+    /* More than fit in the writer's queue at once. */
+    for (int i = 0; i < 1000; ++i)
+        pay (jan1 + i, i);
+    xaccLogFlush ();
+
+    auto log = read_log ("fsync");
+    size_t ends = 0;
+    for (auto pos = log.find ("===== END\n"); pos != std::string::npos;
+         pos = log.find ("===== END\n", pos + 1))
+        ++ends;
+    /* A begin and a commit for each. */
+    EXPECT_EQ(2000u, ends);
+}
+
+TEST_F(TransLogTest, ChangingDurabilityKeepsRecords)
+{
+    open_log ("switch", XACC_LOG_ASYNC);
+    pay (jan1, 100);
+    xaccLogSetDurability (XACC_LOG_SYNC);
+    EXPECT_EQ(XACC_LOG_SYNC, xaccLogGetDurability ());
+    pay (jan1 + 1, 200);
+    xaccLogSetDurability (XACC_LOG_ASYNC);
+    pay (jan1 + 2, 300);
+    xaccCloseLog ();
+
+    auto log = read_log ("switch");
+    auto first = log.find ("\t-100/100\t");
+    auto second = log.find ("\t-200/100\t");
+    auto third = log.find ("\t-300/100\t");
+    ASSERT_NE(std::string::npos, first);
+    ASSERT_NE(std::string::npos, second);
+    ASSERT_NE(std::string::npos, third);
+    EXPECT_LT(first, second);
+    EXPECT_LT(second, third);
+}
@@ -545,6 +545,69 @@ check_add_subtract (void)
     }
 }
 
+static void
+check_sum (void)
+{
+    const gsize n = 1000;
+    gnc_numeric values[1000], fold = gnc_numeric_zero(), sum;
+    gnc_numeric mixed[3] = { gnc_numeric_create(1, 3),
+                             gnc_numeric_create(1, 4),
+                             gnc_numeric_create(5, 100) };
+    gnc_numeric big[3] = { gnc_numeric_create(G_MAXINT64, 1),
+                           gnc_numeric_create(G_MAXINT64, 1),
+                           gnc_numeric_create(-G_MAXINT64, 1) };
+    gsize i;
+
+    /* Same denominator: must agree with adding them up one by one. */
+    for (i = 0; i < n; i++)
+    {
+        values[i] = gnc_numeric_create(get_random_gint64() % 100000000, 100);
+        fold = gnc_numeric_add_fixed(fold, values[i]);
+    }
+    sum = gnc_numeric_sum(values, n, GNC_DENOM_AUTO,
+                          GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    do_test (gnc_numeric_equal(fold, sum) && sum.denom == 100,
+             "sum of same-denominator values");
+
+    /* A change of denominator part way through. */
+    values[n / 2] = gnc_numeric_create(1, 3);
+    fold = gnc_numeric_zero();
+    for (i = 0; i < n; i++)
+        fold = gnc_numeric_add(fold, values[i], GNC_DENOM_AUTO,
+                               GNC_HOW_DENOM_EXACT);
+    sum = gnc_numeric_sum(values, n, GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    do_test (gnc_numeric_equal(fold, sum), "sum of mixed denominators");
+
+    check_binary_op (gnc_numeric_create(19, 30),
+                     gnc_numeric_sum(mixed, 3, GNC_DENOM_AUTO,
+                                     GNC_HOW_DENOM_REDUCE),
+                     mixed[0], mixed[1], "expected %s got %s = sum of %s, %s, 5/100");
+    check_binary_op (gnc_numeric_create(63, 100),
+                     gnc_numeric_sum(mixed, 3, 100, GNC_HOW_RND_ROUND),
+                     mixed[0], mixed[1], "expected %s got %s = sum of %s, %s, 5/100 in 100ths");
+    /* Unlike gnc_numeric_add_fixed, mixed denominators aren't an error. */
+    sum = gnc_numeric_sum(mixed, 3, GNC_DENOM_AUTO,
+                          GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    do_test (gnc_numeric_equal(sum, gnc_numeric_create(19, 30)) &&
+             sum.denom == 300, "fixed sum of mixed denominators");
+
+    /* Intermediate sums may exceed 64 bits as long as the result doesn't. */
+    sum = gnc_numeric_sum(big, 3, GNC_DENOM_AUTO,
+                          GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    do_test (gnc_numeric_equal(sum, big[0]), "sum with a large intermediate");
+    sum = gnc_numeric_sum(big, 2, GNC_DENOM_AUTO,
+                          GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    do_test (gnc_numeric_check(sum) == GNC_ERROR_OVERFLOW, "sum overflow");
+
+    big[1] = gnc_numeric_error(GNC_ERROR_ARG);
+    sum = gnc_numeric_sum(big, 3, GNC_DENOM_AUTO,
+                          GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    do_test (gnc_numeric_check(sum) == GNC_ERROR_ARG, "sum of an error");
+    sum = gnc_numeric_sum(NULL, 0, GNC_DENOM_AUTO,
+                          GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    do_test (gnc_numeric_zero_p(sum), "empty sum");
+}
+
 static const gint64 pten[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
 			       10000000, 100000000, 1000000000, 10000000000,
 			       100000000000, 1000000000000, 10000000000000,
@@ -897,6 +960,7 @@ run_test (void)
     check_double();
     check_neg();
     check_add_subtract();
+    check_sum ();
     check_add_subtract_overflow ();
     check_mult_div ();
 }
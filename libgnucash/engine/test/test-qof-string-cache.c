@@ -77,8 +77,36 @@ test_qof_string_cache( void )
     g_assert(str1_1 != str1_4);
 }
 
+static void
+test_qof_string_cache_many( void )
+{
+    /* Bulk inserts and refs count like single inserts. */
+    const gchar *keys[] = { "many1", NULL, "many2", "many1" };
+    gchar *cached[G_N_ELEMENTS (keys)];
+    gchar *str1;
+
+    qof_string_cache_insert_many(keys, cached, G_N_ELEMENTS (keys));
+    g_assert_cmpstr(cached[0], ==, "many1");
+    g_assert(cached[0] != keys[0]);
+    g_assert(cached[1] == NULL);
+    g_assert_cmpstr(cached[2], ==, "many2");
+    g_assert(cached[3] == cached[0]);           /* Refcount = 2 */
+
+    g_assert(qof_string_cache_ref(cached[0]) == cached[0]); /* Refcount = 3 */
+    str1 = qof_string_cache_insert("many1");    /* Refcount = 4 */
+    g_assert(str1 == cached[0]);
+    qof_string_cache_remove(str1);              /* Refcount = 3 */
+    qof_string_cache_remove(cached[0]);         /* Refcount = 2 */
+    qof_string_cache_remove(cached[3]);         /* Refcount = 1 */
+    g_assert(qof_string_cache_insert("many1") == cached[0]);
+    qof_string_cache_remove(cached[0]);         /* Refcount = 1 */
+    qof_string_cache_remove(cached[0]);         /* Refcount = 0 */
+    qof_string_cache_remove(cached[2]);
+}
+
 void
 test_suite_qof_string_cache ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "string-cache", test_qof_string_cache);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache-many", test_qof_string_cache_many);
 }
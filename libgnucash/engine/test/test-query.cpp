@@ -67,6 +67,166 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* A query limited to max_results must return the tail of what the
+ * unlimited query returns. */
+static void
+test_max_results (QofBook *book)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *all, *limited, *node;
+    guint length, max_results;
+
+    qof_query_set_book (q, book);
+    all = g_list_copy (qof_query_run (q));
+    length = g_list_length (all);
+
+    for (max_results = 0; max_results <= length + 1; max_results += 7)
+    {
+        qof_query_set_max_results (q, max_results);
+        limited = qof_query_run (q);
+        node = g_list_nth (all, length > max_results ? length - max_results : 0);
+        for (; node && limited; node = node->next, limited = limited->next)
+            if (node->data != limited->data)
+                break;
+        if (node || limited)
+        {
+            failure_args ("max results", __FILE__, __LINE__,
+                          "wrong results with max_results %u of %u",
+                          max_results, length);
+            break;
+        }
+    }
+    if (max_results > length + 1)
+        success ("max_results keeps the last results");
+
+    g_list_free (all);
+    qof_query_destroy (q);
+}
+
+/* Checking the splits on several threads must give the same results,
+ * in the same order, as checking them one after another. */
+static void
+test_parallel_queries (void)
+{
+    QofSession *session = get_random_session ();
+    QofBook *book = qof_session_get_book (session);
+    QofCollection *splits = qof_book_get_collection (book, GNC_ID_SPLIT);
+    int i;
+
+    while (qof_collection_count (splits) < 20000)
+        add_random_transactions_to_book (book, 500);
+
+    for (i = 0; i < 10; i++)
+    {
+        QofQuery *q = get_random_query ();
+        GList *serial, *parallel, *node;
+
+        qof_query_set_book (q, book);
+        serial = g_list_copy (qof_query_run (q));
+        qof_query_set_parallel (q, TRUE);
+        parallel = qof_query_run (q);
+        for (node = serial; node && parallel;
+             node = node->next, parallel = parallel->next)
+            if (node->data != parallel->data)
+                break;
+        if (node || parallel)
+            failure ("parallel query results differ");
+        else
+            success ("parallel query results match");
+        g_list_free (serial);
+        qof_query_destroy (q);
+    }
+
+    qof_session_end (session);
+}
+
+static void
+move_trans (Transaction *trans)
+{
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedSecs (trans, get_random_time ());
+    xaccTransCommitEdit (trans);
+}
+
+static void
+collect_trans (QofInstance *inst, gpointer data)
+{
+    GList **list = static_cast<GList**>(data);
+    *list = g_list_prepend (*list, inst);
+}
+
+/* The indexes have to follow the transactions as they change, whether
+ * or not events are being generated at the time. */
+static void
+test_indexed_queries (QofBook *book)
+{
+    GList *transactions = NULL, *node;
+
+    qof_query_enable_indexes (book, TRUE);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            collect_trans, &transactions);
+
+    for (node = transactions; node; node = node->next)
+        test_trans_query (GNC_TRANSACTION (node->data), book);
+
+    for (node = transactions; node; node = node->next)
+    {
+        move_trans (GNC_TRANSACTION (node->data));
+        test_trans_query (GNC_TRANSACTION (node->data), book);
+    }
+
+    qof_event_suspend ();
+    g_list_foreach (transactions, (GFunc)move_trans, NULL);
+    qof_event_resume ();
+    for (node = transactions; node; node = node->next)
+        test_trans_query (GNC_TRANSACTION (node->data), book);
+
+    qof_query_enable_indexes (book, FALSE);
+    g_list_free (transactions);
+}
+
+/* An unsorted query limited to max_results must keep the same splits
+ * whether the indexes find them or the book is scanned. */
+static void
+test_indexed_max_results (QofBook *book)
+{
+    GList *accounts, *acc_node;
+    gboolean same = TRUE;
+
+    accounts = gnc_account_get_descendants (gnc_book_get_root_account (book));
+    for (acc_node = accounts; acc_node; acc_node = acc_node->next)
+    {
+        QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+        GList *scanned, *indexed, *node;
+
+        qof_query_set_book (q, book);
+        xaccQueryAddSingleAccountMatch (q, GNC_ACCOUNT (acc_node->data),
+                                        QOF_QUERY_AND);
+        qof_query_set_sort_order (q, NULL, NULL, NULL);
+        qof_query_set_max_results (q, 3);
+
+        scanned = g_list_copy (qof_query_run (q));
+        qof_query_enable_indexes (book, TRUE);
+        indexed = qof_query_run (q);
+        qof_query_enable_indexes (book, FALSE);
+
+        for (node = scanned; node && indexed;
+             node = node->next, indexed = indexed->next)
+            if (node->data != indexed->data)
+                break;
+        if (node || indexed)
+            same = FALSE;
+        g_list_free (scanned);
+        qof_query_destroy (q);
+    }
+    g_list_free (accounts);
+
+    if (same)
+        success ("indexed limited query keeps the scanned results");
+    else
+        failure ("indexed limited query results differ");
+}
+
 static void
 run_test (void)
 {
@@ -81,6 +241,9 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    test_indexed_queries (book);
+    test_indexed_max_results (book);
+    test_max_results (book);
 
     qof_session_end (session);
 }
@@ -109,6 +272,7 @@ main (int argc, char **argv)
         run_test ();
     }
     success("queries seem to work");
+    test_parallel_queries ();
 
 cleanup:
     qof_close();
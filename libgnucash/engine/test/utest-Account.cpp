@@ -887,7 +887,7 @@ test_xaccFreeAccount (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert_cmpuint (p_priv->splits->len, !=, 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1002,7 +1002,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert_cmpuint (p_priv->splits->len, !=, 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1018,7 +1018,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     test_signal_assert_hits (sig2, 0);
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert_cmpuint (p_priv->splits->len, !=, 0);
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1102,19 +1102,19 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that the call fails with invalid account and split (throws) */
     g_assert (!gnc_account_insert_split (NULL, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->splits->len, == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     g_assert (!gnc_account_insert_split (fixture->acct, NULL));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->splits->len, == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     /* g_assert (!gnc_account_insert_split (fixture->acct, (Split*)priv)); */
-    /* g_assert_cmpuint (g_list_length (priv->splits), == , 0); */
+    /* g_assert_cmpuint (priv->splits->len, == , 0); */
     /* g_assert (!priv->sort_dirty); */
     /* g_assert (!priv->balance_dirty); */
     /* test_signal_assert_hits (sig1, 0); */
@@ -1127,7 +1127,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that it works the first time */
     g_assert (gnc_account_insert_split (fixture->acct, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 1);
+    g_assert_cmpuint (priv->splits->len, == , 1);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 1);
@@ -1139,7 +1139,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_ADDED, split2);
     /* Now add a second split to the account and check that sort_dirty isn't set. We have to bump the editlevel to force this. */
     g_assert (gnc_account_insert_split (fixture->acct, split2));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->len, == , 2);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 2);
@@ -1150,7 +1150,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     qof_instance_increase_editlevel (fixture->acct);
     g_assert (gnc_account_insert_split (fixture->acct, split3));
     qof_instance_decrease_editlevel (fixture->acct);
-    g_assert_cmpuint (g_list_length (priv->splits), == , 3);
+    g_assert_cmpuint (priv->splits->len, == , 3);
     g_assert (priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 3);
@@ -1161,7 +1161,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_REMOVED,
                             split3);
     g_assert (gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->len, == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1169,7 +1169,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     /* And do it again to make sure that it fails when the split has
      * already been removed */
     g_assert (!gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->len, == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1327,6 +1327,27 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
     g_assert (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
     g_assert (!priv->balance_dirty);
+    g_assert_cmpint (priv->split_index->len, ==, sdata->num_txns);
+
+    /* Taking out the second split must only recompute the ones after it
+     * but still leave the right balances. */
+    {
+        Split *first = static_cast<Split*>(g_ptr_array_index (priv->splits, 0));
+        Split *split = static_cast<Split*>(g_ptr_array_index (priv->splits, 1));
+        gnc_numeric first_bal = xaccSplitGetBalance (first);
+        gnc_numeric amt = xaccSplitGetAmount (split);
+
+        g_assert (gnc_account_remove_split (fixture->acct, split));
+        g_assert (!priv->balance_dirty);
+        g_assert (gnc_numeric_eq (xaccSplitGetBalance (first), first_bal));
+        g_assert (gnc_numeric_eq (priv->balance,
+                                  gnc_numeric_sub_fixed (bal, amt)));
+        g_assert (gnc_account_insert_split (fixture->acct, split));
+        xaccAccountRecomputeBalance (fixture->acct);
+        g_assert (gnc_numeric_eq (priv->balance, bal));
+        g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
+        g_assert (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
+    }
 }
 
 /* xaccAccountOrder
@@ -1932,6 +1953,46 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+/* xaccAccountGetClearedBalanceAsOfDate
+gnc_numeric
+xaccAccountGetClearedBalanceAsOfDate (Account *acc, time64 date)
+xaccAccountGetReconciledBalanceAsOfDate
+gnc_numeric
+xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)*/
+static void
+test_xaccAccountGetClearedBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
+{
+    gnc_numeric val, cleared = gnc_numeric_zero (), recd = gnc_numeric_zero ();
+    SetupData *sdata = (SetupData*)pData;
+    TxnParms* t_arr;
+    int ind;
+    gint min_ind = 3;
+    time64 now = gnc_time (NULL);
+    g_assert (sdata != NULL);
+    t_arr = (TxnParms*)sdata->txns;
+    for (ind = 0; ind < min_ind; ind++)
+    {
+        SplitParms p = t_arr[ind].splits[1];
+        if (p.reconciled != NREC)
+            cleared = gnc_numeric_add_fixed (cleared, p.amount);
+        if (p.reconciled == YREC || p.reconciled == FREC)
+            recd = gnc_numeric_add_fixed (recd, p.amount);
+    }
+    xaccAccountRecomputeBalance (fixture->acct);
+    val = xaccAccountGetClearedBalanceAsOfDate (fixture->acct, now);
+    g_assert (gnc_numeric_equal (val, cleared));
+    val = xaccAccountGetReconciledBalanceAsOfDate (fixture->acct, now);
+    g_assert (gnc_numeric_equal (val, recd));
+    /* Before the first split the balance is zero ... */
+    val = xaccAccountGetClearedBalanceAsOfDate (fixture->acct,
+                                                now - 24 * 3600 * 30);
+    g_assert (gnc_numeric_zero_p (val));
+    /* ... and after the last one it's the account's balance. */
+    val = xaccAccountGetClearedBalanceAsOfDate (fixture->acct,
+                                                now + 24 * 3600 * 30);
+    g_assert (gnc_numeric_equal (val,
+                                 xaccAccountGetClearedBalance (fixture->acct)));
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -1983,9 +2044,59 @@ test_xaccAccountGetPresentBalance (Fixture *fixture, gconstpointer pData)
  * xaccAccountGetBalanceAsOfDateInCurrency
  * xaccAccountGetBalanceChangeForPeriod
  */
+/* xaccAccountGetSplitList
+SplitList*
+xaccAccountGetSplitList (const Account *acc)// C: 38 in 16 */
+static void
+test_xaccAccountGetSplitList (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    SetupData *sdata = (SetupData*)pData;
+    GList *list = xaccAccountGetSplitList (fixture->acct), *node;
+    Split *split;
+    guint i = 0;
+
+    g_assert_cmpuint (g_list_length (list), ==, sdata->num_txns);
+    for (node = list; node; node = node->next, ++i)
+    {
+        g_assert (node->data == g_ptr_array_index (priv->splits, i));
+        if (node->next)
+            g_assert_cmpint (xaccSplitOrder (static_cast<Split*>(node->data),
+                                             static_cast<Split*>(node->next->data)),
+                             <, 0);
+    }
+
+    /* The list follows splits leaving and rejoining the account; the
+     * other splits keep their nodes. */
+    split = static_cast<Split*>(g_list_nth_data (list, 1));
+    g_assert (gnc_account_remove_split (fixture->acct, split));
+    g_assert (xaccAccountGetSplitList (fixture->acct) == list);
+    g_assert_cmpuint (g_list_length (list), ==, sdata->num_txns - 1);
+    g_assert (g_list_find (list, split) == NULL);
+    g_assert (gnc_account_insert_split (fixture->acct, split));
+    g_assert (xaccAccountGetSplitList (fixture->acct) == list);
+    g_assert_cmpuint (g_list_length (list), ==, sdata->num_txns);
+    g_assert (g_list_nth_data (list, 1) == split);
+
+    /* Likewise at either end of the list. */
+    node = g_list_last (list);
+    split = static_cast<Split*>(node->data);
+    g_assert (gnc_account_remove_split (fixture->acct, split));
+    g_assert (gnc_account_insert_split (fixture->acct, split));
+    g_assert (g_list_last (list)->data == split);
+    split = static_cast<Split*>(list->data);
+    g_assert (gnc_account_remove_split (fixture->acct, split));
+    list = xaccAccountGetSplitList (fixture->acct);
+    g_assert (g_list_find (list, split) == NULL);
+    g_assert (gnc_account_insert_split (fixture->acct, split));
+    list = xaccAccountGetSplitList (fixture->acct);
+    g_assert (list->data == split);
+    for (node = list, i = 0; node; node = node->next, ++i)
+        g_assert (node->data == g_ptr_array_index (priv->splits, i));
+    g_assert_cmpuint (i, ==, priv->splits->len);
+}
 /*
  * Yet more getters & setters:
- * xaccAccountGetSplitList
  * xaccAccountGetLotList
  */
 /* xaccAccountFindOpenLots
@@ -2578,7 +2689,9 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetClearedBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetClearedBalanceAsOfDate,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetSplitList", Fixture, &some_data, setup, test_xaccAccountGetSplitList,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
 
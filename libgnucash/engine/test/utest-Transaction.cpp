@@ -101,6 +101,10 @@ public:
     void safe_sync(QofBook*) override {
         m_last_call = "safe_sync";
     }
+    void commit(QofInstance* inst) override {
+        if (strcmp (inst->e_type, GNC_ID_TRANS) == 0)
+            ++m_trans_commits;
+    }
     void rollback(QofInstance*) override {
         set_error(m_result_err);
         m_last_call = "rollback";
@@ -109,6 +113,7 @@ public:
         m_result_err = err;
     }
     std::string m_last_call;
+    int m_trans_commits = 0;
 private:
     QofBackendError m_result_err;
 };
@@ -1735,6 +1740,72 @@ test_xaccTransRollbackEdit_BackendErrors (Fixture *fixture, gconstpointer pData)
     g_assert_cmpstr (mbe->m_last_call.c_str(), ==, "rollback");
 
 }
+/* gnc_book_begin_bulk_edit
+void
+gnc_book_begin_bulk_edit (QofBook *book)// Local: 0:0:0
+gnc_book_commit_bulk_edit
+void
+gnc_book_commit_bulk_edit (QofBook *book)// Local: 0:0:0
+*/
+static void
+test_gnc_book_bulk_edit (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = qof_instance_get_book (fixture->txn);
+    auto mbe = static_cast<TransMockBackend*>(qof_book_get_backend (book));
+    auto acc3 = xaccMallocAccount (book);
+    auto amount = gnc_numeric_create (240, 240);
+    auto balance = xaccAccountGetBalance (fixture->acc2);
+    Transaction *txns[3];
+
+    xaccAccountSetCommodity (acc3, fixture->curr);
+    mbe->m_trans_commits = 0;
+    gnc_book_begin_bulk_edit (book);
+    gnc_book_begin_bulk_edit (book);
+    for (auto& txn : txns)
+    {
+        auto split1 = xaccMallocSplit (book);
+        auto split2 = xaccMallocSplit (book);
+        txn = xaccMallocTransaction (book);
+        xaccTransBeginEdit (txn);
+        xaccTransSetCurrency (txn, fixture->curr);
+        xaccSplitSetParent (split1, txn);
+        xaccSplitSetParent (split2, txn);
+        xaccSplitSetAccount (split1, fixture->acc2);
+        xaccSplitSetAccount (split2, acc3);
+        xaccSplitSetAmount (split1, amount);
+        xaccSplitSetValue (split1, amount);
+        xaccSplitSetAmount (split2, gnc_numeric_neg (amount));
+        xaccSplitSetValue (split2, gnc_numeric_neg (amount));
+        xaccTransCommitEdit (txn);
+    }
+    /* A second edit is still only one commit to the backend. */
+    xaccTransBeginEdit (txns[0]);
+    xaccTransSetDescription (txns[0], "Waldo Pepper");
+    xaccTransCommitEdit (txns[0]);
+
+    g_assert_cmpint (qof_instance_get_editlevel (fixture->acc2), ==, 1);
+    g_assert_cmpint (qof_instance_get_editlevel (acc3), ==, 1);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (fixture->acc2),
+                                 balance));
+    g_assert_cmpint (mbe->m_trans_commits, ==, 0);
+    gnc_book_commit_bulk_edit (book);
+    g_assert_cmpint (mbe->m_trans_commits, ==, 0);
+    gnc_book_commit_bulk_edit (book);
+
+    g_assert_cmpint (mbe->m_trans_commits, ==, 3);
+    g_assert_cmpint (qof_instance_get_editlevel (fixture->acc2), ==, 0);
+    g_assert_cmpint (qof_instance_get_editlevel (acc3), ==, 0);
+    balance = gnc_numeric_add (balance, gnc_numeric_create (720, 240),
+                               240, GNC_HOW_RND_NEVER);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (fixture->acc2),
+                                 balance));
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (acc3),
+                                 gnc_numeric_create (-720, 240)));
+
+    for (auto txn : txns)
+        xaccTransDestroy (txn);
+    test_destroy (acc3);
+}
 /* xaccTransIsOpen C: 23 in 7 SCM: 1  Local: 0:0:0
  * xaccTransOrder C: 2 in 2 SCM: 12 in 12 Local: 0:1:0
 
@@ -2036,6 +2107,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD_FUNC (suitename, "xaccTransCommitEdit", test_xaccTransCommitEdit);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit", Fixture, NULL, setup, test_xaccTransRollbackEdit, teardown);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit - Backend Errors", Fixture, NULL, setup, test_xaccTransRollbackEdit_BackendErrors, teardown);
+    GNC_TEST_ADD (suitename, "gnc_book bulk edit", Fixture, NULL, setup, test_gnc_book_bulk_edit, teardown);
     GNC_TEST_ADD (suitename, "xaccTransOrder_num_action", Fixture, NULL, setup, test_xaccTransOrder_num_action, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetTxnType", Fixture, NULL, setup, test_xaccTransGetTxnType, teardown);
     GNC_TEST_ADD (suitename, "xaccTransVoid", Fixture, NULL, setup, test_xaccTransVoid, teardown);
@@ -1129,6 +1129,41 @@ test_gnc_pricedb_lookup_nearest_in_time64 (PriceDBFixture *fixture, gconstpointe
     g_assert_cmpstr(GET_CUR_NAME(price), ==, "AUD");
     g_assert_cmpstr(GET_COM_NAME(price), ==, "USD");
 }
+/* gnc_pricedb_lookup_nearest_in_time64_batch
+void
+gnc_pricedb_lookup_nearest_in_time64_batch (GNCPriceDB *db,
+*/
+static void
+test_gnc_pricedb_lookup_nearest_in_time64_batch (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceRequest requests[] = {
+        {fixture->com->gbp, gnc_dmy2time64(1, 1, 2012), NULL},
+        {fixture->com->aud, gnc_dmy2time64(25, 3, 2013), NULL},
+        {fixture->com->gbp, gnc_dmy2time64(1, 1, 2008), NULL},
+        {fixture->com->aud, gnc_dmy2time64(26, 3, 2013), NULL},
+        {fixture->com->gbp, gnc_dmy2time64(1, 1, 2016), NULL},
+        {fixture->com->gbp, gnc_dmy2time64(14, 10, 2012), NULL},
+        {fixture->com->usd, gnc_dmy2time64(14, 10, 2012), NULL},
+    };
+    guint n = G_N_ELEMENTS (requests);
+    guint i;
+
+    gnc_pricedb_lookup_nearest_in_time64_batch(fixture->pricedb,
+                                               fixture->com->usd,
+                                               requests, n);
+    for (i = 0; i < n; ++i)
+    {
+        GNCPrice *price =
+            gnc_pricedb_lookup_nearest_in_time64(fixture->pricedb,
+                                                 requests[i].commodity,
+                                                 fixture->com->usd,
+                                                 requests[i].time);
+        g_assert(requests[i].price == price);
+        gnc_price_unref(price);
+        gnc_price_unref(requests[i].price);
+    }
+    g_assert(requests[n - 1].price == NULL);
+}
 // Not Used
 /* gnc_pricedb_lookup_latest_before_t64
 GNCPrice *
@@ -1248,6 +1283,49 @@ test_gnc_pricedb_convert_balance_nearest_price_t64 (PriceDBFixture *fixture, gco
     g_assert_cmpint(result.denom, ==, 100);
 
 }
+
+/* The conversion cache must follow changes to the prices it used. */
+static void
+test_gnc_pricedb_convert_balance_cache (PriceDBFixture *fixture, gconstpointer pData)
+{
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(fixture->pricedb));
+    gnc_numeric from = gnc_numeric_create(10000, 100);
+    GNCPrice *latest, *newer;
+    gnc_numeric result =
+        gnc_pricedb_convert_balance_latest_price(fixture->pricedb, from,
+                                                 fixture->com->usd,
+                                                 fixture->com->aud);
+    g_assert_cmpint(result.num, ==, 11478);
+    result = gnc_pricedb_convert_balance_latest_price(fixture->pricedb, from,
+                                                      fixture->com->usd,
+                                                      fixture->com->aud);
+    g_assert_cmpint(result.num, ==, 11478);
+
+    latest = gnc_pricedb_lookup_latest(fixture->pricedb, fixture->com->usd,
+                                       fixture->com->aud);
+    g_assert(gnc_price_get_commodity(latest) == fixture->com->usd);
+    gnc_price_set_value(latest, gnc_numeric_create(2, 1));
+    result = gnc_pricedb_convert_balance_latest_price(fixture->pricedb, from,
+                                                      fixture->com->usd,
+                                                      fixture->com->aud);
+    g_assert_cmpint(result.num, ==, 20000);
+
+    newer = construct_price(book, fixture->com->usd, fixture->com->aud,
+                            gnc_dmy2time64(1, 1, 2016), PRICE_SOURCE_FQ,
+                            gnc_numeric_create(3, 1));
+    gnc_pricedb_add_price(fixture->pricedb, newer);
+    result = gnc_pricedb_convert_balance_latest_price(fixture->pricedb, from,
+                                                      fixture->com->usd,
+                                                      fixture->com->aud);
+    g_assert_cmpint(result.num, ==, 30000);
+
+    gnc_pricedb_remove_price(fixture->pricedb, newer);
+    result = gnc_pricedb_convert_balance_latest_price(fixture->pricedb, from,
+                                                      fixture->com->usd,
+                                                      fixture->com->aud);
+    g_assert_cmpint(result.num, ==, 20000);
+    gnc_price_unref(latest);
+}
 /* pricedb_foreach_pricelist
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)// Local: 0:1:0
@@ -1498,12 +1576,14 @@ test_suite_gnc_pricedb (void)
     GNC_TEST_ADD (suitename, "gnc pricedb lookup day", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_day_t64, teardown);
 // GNC_TEST_ADD (suitename, "lookup nearest in time", Fixture, NULL, setup, test_lookup_nearest_in_time, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time64, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time batch", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time64_batch, teardown);
 // GNC_TEST_ADD (suitename, "direct balance conversion", Fixture, NULL, setup, test_direct_balance_conversion, teardown);
 // GNC_TEST_ADD (suitename, "extract common prices", Fixture, NULL, setup, test_extract_common_prices, teardown);
 // GNC_TEST_ADD (suitename, "convert balance", Fixture, NULL, setup, test_convert_balance, teardown);
 // GNC_TEST_ADD (suitename, "indirect balance conversion", Fixture, NULL, setup, test_indirect_balance_conversion, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_nearest_price_t64, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb convert balance cache", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_cache, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);